@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
+
 namespace lv {
 
 struct Action {
@@ -13,4 +16,15 @@ struct Action {
     int upgrade_choice = -1;
 };
 
+// Raw policy outputs per action, in the Box action space order: move_x, move_y,
+// aim_x, aim_y, shoot, sprint, reload, upgrade_choice.
+constexpr size_t kActionValues = 8;
+
+// The one mapping from raw policy outputs to an Action, shared by the Python
+// env, native evaluation and rollouts, and agent replies: axes are clamped to
+// [-1, 1], buttons press at >= 0.5, and upgrade_choice below -0.5 means none,
+// otherwise it is rounded within [0, 2]. Non-finite axes count as 0, a
+// non-finite upgrade_choice as none and a NaN button as released.
+Action decode_action(std::span<const float, kActionValues> values);
+
 } // namespace lv
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "action.hpp"
+#include "state.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lv {
+
+enum class AgentTransport : uint8_t {
+    Tcp,  // HOST:PORT
+    Unix, // unix:/path/to/socket
+    Shm   // shm:name, a ShmMailbox in /dev/shm
+};
+
+struct AgentEndpoint {
+    AgentTransport transport = AgentTransport::Tcp;
+    std::string host; // Tcp
+    uint16_t port = 0; // Tcp
+    std::string path; // Unix socket path or shm mailbox name
+
+    std::string describe() const;
+};
+
+// Parses HOST:PORT, unix:/path or shm:name; nullopt when malformed.
+std::optional<AgentEndpoint> parse_agent_endpoint(const std::string& text);
+
+// Connection to an inference server (python/agent_server.py). Stream
+// transports (TCP, Unix sockets) start with the JSON hello and then use binary
+// frames when both sides agree (agent_protocol.hpp); the shared-memory mailbox
+// always carries binary frames.
+class AgentClient {
+  public:
+    virtual ~AgentClient() = default;
+
+    // Returns the server's model name.
+    virtual std::string handshake_or_throw() = 0;
+    // Sends one observation and replaces `out` with the reply: one action, or
+    // up to max_chunk actions for consecutive ticks.
+    virtual void infer_chunk_or_throw(std::span<const float> obs, std::vector<Action>& out) = 0;
+    virtual const char* protocol() const = 0;
+    // Wakes an infer_chunk_or_throw() blocked on another thread, which then
+    // throws; the client is unusable afterwards. Safe to call from any thread.
+    virtual void cancel() = 0;
+
+    // First action of a fresh reply.
+    Action infer_or_throw(std::span<const float> obs);
+
+    // Action for the tick about to run from `state`. Replays the rest of the
+    // last reply and only sends observe() once it is used up, the play state
+    // changed or the player lost health since the previous tick.
+    template <typename Observe>
+    Action next_action_or_throw(const GameState& state, Observe&& observe) {
+        if (chunk_pos_ >= chunk_.size() || state.play_state != last_play_state_ ||
+            state.player.health < last_health_) {
+            infer_chunk_or_throw(observe(), chunk_);
+            chunk_pos_ = 0;
+            ++queries_;
+        }
+        last_play_state_ = state.play_state;
+        last_health_ = state.player.health;
+        return chunk_[chunk_pos_++];
+    }
+
+    // Round trips made by next_action_or_throw().
+    uint64_t queries() const { return queries_; }
+
+  private:
+    std::vector<Action> chunk_;
+    size_t chunk_pos_ = 0;
+    PlayState last_play_state_ = PlayState::Playing;
+    float last_health_ = 0.0f;
+    uint64_t queries_ = 0;
+};
+
+// Throws std::runtime_error when the endpoint cannot be reached.
+// allow_binary = false keeps JSON on the stream transports; max_chunk > 1
+// lets the server answer with that many actions per observation.
+std::unique_ptr<AgentClient> connect_agent(const AgentEndpoint& endpoint, bool allow_binary = true, int max_chunk = 1);
+
+} // namespace lv
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "action.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lv {
+
+// Binary framing for the agent connection (python/agent_server.py), used once
+// both sides agree on it in the JSON hello:
+//   client: {"type":"hello","protocols":["binary-v1","json"],"max_chunk":K}
+//   server: {"type":"hello","model":"...","protocol":"binary-v1"}
+// A server that does not answer with "protocol":"binary-v1" keeps the
+// newline-delimited JSON messages. Either way a reply carries 8 * n action
+// values, n consecutive actions for the next n ticks, with 1 <= n <= K
+// (max_chunk, omitted when 1). Each binary frame is, little-endian:
+//   u32 length   bytes after this field (4 + 4 * count)
+//   u8  version  kAgentProtocolVersion
+//   u8  kind     AgentFrameKind
+//   u16 count    number of float32 values
+//   f32 values[count]
+constexpr uint8_t kAgentProtocolVersion = 1;
+constexpr const char* kAgentBinaryProtocolName = "binary-v1";
+constexpr size_t kAgentFrameHeaderBytes = 8;
+constexpr size_t kAgentActionValues = kActionValues;
+constexpr int kAgentMaxActionChunk = 64;
+
+enum class AgentFrameKind : uint8_t {
+    Observation = 1, // client -> server
+    Action = 2       // server -> client
+};
+
+struct AgentFrameHeader {
+    AgentFrameKind kind;
+    uint16_t count;
+};
+
+// Replaces `out` with one frame. Throws std::invalid_argument for more than
+// 65535 values.
+void encode_agent_frame(AgentFrameKind kind, std::span<const float> values, std::vector<uint8_t>& out);
+
+// Throws std::runtime_error on a version, kind or length mismatch.
+AgentFrameHeader decode_agent_frame_header(std::span<const uint8_t, kAgentFrameHeaderBytes> bytes);
+
+// Reads header.count little-endian float32 values.
+void decode_agent_frame_values(std::span<const uint8_t> payload, std::span<float> out);
+
+// Replaces `out` with the actions (decode_action) of a reply holding 8 * n values. Throws
+// std::runtime_error unless 1 <= n <= max_chunk.
+void actions_from_agent_values(std::span<const float> values, int max_chunk, std::vector<Action>& out);
+
+} // namespace lv
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "agent_client.hpp"
+#include "spsc_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace lv {
+
+// Runs an AgentClient on its own I/O thread so a slow or stalled agent cannot
+// hold up the caller's frame. Requests and replies cross over lock-free SPSC
+// queues with at most one request outstanding. Each tick waits at most
+// `deadline` for a reply it needs; past that the previous action is repeated
+// and the tick counts as missed. A reply that arrives after its tick's
+// deadline is still used (skipping the actions of its chunk that are already
+// in the past) and counts as late.
+class AsyncAgent {
+  public:
+    AsyncAgent(std::unique_ptr<AgentClient> client, std::chrono::microseconds deadline);
+    // Cancels a request still waiting on the server (AgentClient::cancel), so
+    // a stalled agent cannot hold up destruction, then joins the I/O thread.
+    ~AsyncAgent();
+
+    AsyncAgent(const AsyncAgent&) = delete;
+    AsyncAgent& operator=(const AsyncAgent&) = delete;
+
+    // Action for the tick about to run from `state`, one call per tick. Asks
+    // for a new reply under the same rules as AgentClient::next_action_or_throw.
+    // Rethrows the exception that stopped the I/O thread, if any.
+    template <typename Observe>
+    Action next_action_or_throw(const GameState& state, Observe&& observe) {
+        rethrow_if_failed();
+        if (chunk_pos_ >= chunk_.size() || state.play_state != last_play_state_ ||
+            state.player.health < last_health_) {
+            chunk_.clear();
+            chunk_pos_ = 0;
+            if (!in_flight_) send(observe());
+        }
+        last_play_state_ = state.play_state;
+        last_health_ = state.player.health;
+        if (in_flight_) await_reply();
+
+        if (chunk_pos_ < chunk_.size()) {
+            last_action_ = chunk_[chunk_pos_++];
+        } else {
+            missed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        ++tick_;
+        return last_action_;
+    }
+
+    // Requests sent, ticks that fell back to the previous action, and replies
+    // that arrived after their deadline. Safe to read from any thread.
+    uint64_t queries() const { return queries_.load(std::memory_order_relaxed); }
+    uint64_t missed() const { return missed_.load(std::memory_order_relaxed); }
+    uint64_t late() const { return late_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Request {
+        uint64_t tick = 0;
+        std::vector<float> obs;
+    };
+    struct Reply {
+        uint64_t tick = 0;
+        std::vector<Action> actions;
+    };
+
+    void send(std::vector<float> obs);
+    void await_reply();
+    void take_reply(Reply& reply);
+    void rethrow_if_failed();
+    void io_loop();
+
+    std::unique_ptr<AgentClient> client_;
+    std::chrono::microseconds deadline_;
+
+    SpscQueue<Request, 2> requests_;
+    SpscQueue<Reply, 2> replies_;
+    std::atomic<uint32_t> wakeups_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;
+    std::thread io_thread_;
+
+    // Caller-thread state.
+    std::vector<Action> chunk_;
+    size_t chunk_pos_ = 0;
+    Action last_action_{};
+    PlayState last_play_state_ = PlayState::Playing;
+    float last_health_ = 0.0f;
+    bool in_flight_ = false;
+    uint64_t tick_ = 0;
+    std::atomic<uint64_t> queries_{0};
+    std::atomic<uint64_t> missed_{0};
+    std::atomic<uint64_t> late_{0};
+};
+
+} // namespace lv
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lv {
+
+// Replay and state files are little-endian with no padding; the fields are
+// written straight from memory, which is only correct on little-endian hosts.
+static_assert(std::endian::native == std::endian::little, "byte_io assumes a little-endian host");
+
+// Appends fixed-width fields and LEB128 varints to a byte vector.
+class ByteWriter {
+  public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const size_t at = out_.size();
+        out_.resize(at + sizeof(T));
+        std::memcpy(out_.data() + at, &value, sizeof(T));
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Zigzag, so small negative deltas stay short too.
+    void svarint(int64_t value) {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+  private:
+    std::vector<uint8_t>& out_;
+};
+
+// Bounds-checked reads matching ByteWriter. Throws std::runtime_error naming
+// `what` when the data ends early or a varint is malformed.
+class ByteReader {
+  public:
+    ByteReader(std::span<const uint8_t> bytes, std::string what) : bytes_(bytes), what_(std::move(what)) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = *take(1);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        fail("malformed varint");
+    }
+
+    int64_t svarint() {
+        const uint64_t raw = varint();
+        return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    }
+
+    std::span<const uint8_t> bytes(size_t n) { return {take(n), n}; }
+
+    size_t position() const { return pos_; }
+    size_t remaining() const { return bytes_.size() - pos_; }
+
+    [[noreturn]] void fail(const std::string& why) const { throw std::runtime_error(what_ + ": " + why); }
+
+  private:
+    const uint8_t* take(size_t n) {
+        if (remaining() < n) fail("truncated");
+        const uint8_t* p = bytes_.data() + pos_;
+        pos_ += n;
+        return p;
+    }
+
+    std::span<const uint8_t> bytes_;
+    std::string what_;
+    size_t pos_ = 0;
+};
+
+} // namespace lv
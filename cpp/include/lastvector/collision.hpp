@@ -11,4 +11,7 @@ bool circle_vs_aabb_overlap(Vec2 center, float radius, const Obstacle& box);
 float ray_intersect_aabb(Vec2 origin, Vec2 dir, const Obstacle& box);
 float ray_intersect_circle(Vec2 origin, Vec2 dir, Vec2 center, float radius);
 
+// Replaces a non-finite position with `fallback`, then clamps it inside the arena.
+void sanitize_position(Vec2& pos, Vec2 fallback, float radius, Vec2 arena_size);
+
 } // namespace lv
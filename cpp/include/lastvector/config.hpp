@@ -17,6 +17,8 @@ constexpr float kEpisodeLimitSeconds = 180.0f;
 constexpr float kPlayerRadius = 10.0f;
 constexpr float kZombieRadius = 10.0f;
 constexpr int kUpgradeChoiceTimeoutTicks = 120; // 2 seconds at 60Hz
+constexpr int kZombieReorderIntervalTicks = 60;  // Morton re-sort of GameState::zombies
+constexpr float kObstacleFieldCellSize = 32.0f;
 
 enum class RunMode {
     Rendered,
@@ -29,4 +31,59 @@ enum class PlayState : uint8_t {
     Dead
 };
 
+enum class NeighborSearch : uint8_t {
+    BruteForce,
+    VerletList
+};
+
+// How the observation rays find their first zombie hit. Both give identical
+// distances; GridDDA walks a uniform zombie grid along each ray.
+enum class ZombieRaySearch : uint8_t {
+    BruteForce,
+    GridDDA
+};
+
+// GaussSeidel applies each pair push in place, so results depend on visit order.
+// Jacobi sums every zombie's pushes against the positions from the start of the
+// pass into a separate buffer and applies them afterwards; each zombie's sum runs
+// in a fixed neighbour order, so it parallelises with results independent of
+// the thread count.
+enum class SeparationSolver : uint8_t {
+    GaussSeidel,
+    Jacobi
+};
+
+// Per-simulator settings, fixed at construction. Defaults reproduce the
+// constants above. The observation layout (zombie_obs_count, ray_count) must be
+// one of the layouts compiled into the simulator (see visit_obs_layout).
+struct SimConfig {
+    float arena_width = kArenaWidth;
+    float arena_height = kArenaHeight;
+    float episode_limit_seconds = kEpisodeLimitSeconds;
+
+    // difficulty = episode time / difficulty_ramp_seconds; spawn rate and the
+    // live-zombie cap grow linearly with it.
+    float difficulty_ramp_seconds = 90.0f;
+    float spawn_rate_base = 1.0f; // zombies per second
+    float spawn_rate_per_difficulty = 1.2f;
+    int max_alive_base = 16;
+    float max_alive_per_difficulty = 18.0f;
+    int max_alive_cap = 0; // 0 = no hard cap
+
+    int zombie_obs_count = kZombieObsCount;
+    int ray_count = kRayCount;
+    ZombieRaySearch zombie_ray_search = ZombieRaySearch::GridDDA;
+    // Cell size of the static obstacle distance field; <= 0 tests every
+    // obstacle directly instead.
+    float obstacle_field_cell_size = kObstacleFieldCellSize;
+    // Egocentric occupancy grid (Simulator::occupancy_into): cells per side and
+    // world units per cell.
+    int occupancy_grid_size = 64;
+    float occupancy_cell_size = 16.0f;
+
+    NeighborSearch neighbor_search = NeighborSearch::VerletList;
+    SeparationSolver separation_solver = SeparationSolver::GaussSeidel;
+    int separation_threads = 1; // Jacobi only
+};
+
 } // namespace lv
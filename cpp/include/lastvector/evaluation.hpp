@@ -0,0 +1,83 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lv {
+
+class MlpPolicy;
+class TrajectoryWriter;
+
+struct EvalConfig {
+    SimConfig sim{};
+    uint64_t first_seed = 0;
+    int episodes = 100;  // seeds first_seed .. first_seed + episodes - 1
+    int threads = 1;     // simulator stepping; inference runs on the calling thread
+    int batch = 64;      // episodes advanced in lockstep and inferred together
+    int max_ticks = 0;   // per-episode cap on steps, 0 = until the episode ends
+};
+
+struct EpisodeResult {
+    uint64_t seed = 0;
+    double reward = 0.0;
+    int steps = 0;      // step() calls
+    uint64_t ticks = 0; // GameState::tick at the end, as the single-run line prints it
+    float survival_s = 0.0f;
+    int kills = 0;
+    int shots_fired = 0;
+    int hits = 0;
+    float accuracy = 0.0f;
+    bool died = false;
+};
+
+// Raw policy outputs for a batch: obs[n][obs_dim] -> actions[n][8], in the
+// Box action space; each row goes through decode_action, as in the Python env.
+using BatchPolicy = std::function<void(std::span<const float> obs, size_t n, std::span<float> actions)>;
+
+// Plays every seed to the end with a deterministic policy. Up to `batch`
+// episodes run at once: their observations go to one policy call, then the
+// simulators step in parallel on `threads` threads, and a finished episode's
+// slot moves on to the next seed. Results are in seed order and do not depend
+// on threads or batch as long as the policy treats rows independently.
+// Throws std::invalid_argument for a bad config; exceptions from the policy
+// propagate.
+std::vector<EpisodeResult> evaluate_policy(const EvalConfig& config, const BatchPolicy& policy);
+
+struct SweepConfig {
+    SimConfig sim{};
+    uint64_t first_seed = 0;
+    uint64_t last_seed = 0; // inclusive
+    int threads = 1;
+    int max_ticks = 0; // per-episode cap on steps, 0 = until the episode ends
+    // Receives every step of every episode when set, with env = the thread
+    // that played it. Row order across threads is not deterministic.
+    TrajectoryWriter* dataset = nullptr;
+};
+
+struct SweepEpisode {
+    EpisodeResult result;
+    double wall_s = 0.0; // time spent in this episode, policy included
+};
+
+// Runs one independent episode per seed, balancing episodes of very different
+// lengths across `threads` threads with ThreadPool::parallel_for_each. A null
+// policy plays the headless default (stand still, take the first upgrade);
+// otherwise every thread acts with its own copy of `policy`. on_episode is
+// called once per seed, in seed order, never concurrently, as soon as that
+// seed and every earlier one have finished. Throws std::invalid_argument for a
+// bad config; an exception from on_episode or a simulator ends the sweep and
+// propagates.
+void run_sweep(const SweepConfig& config, const MlpPolicy* policy,
+               const std::function<void(const SweepEpisode&)>& on_episode);
+
+// {"episodes": n, "summary": {metric: {mean, std, min, p5, p25, p50, p75,
+// p95, max}}, "per_seed": [...]} for reward, survival_s, kills and accuracy.
+std::string eval_report_json(const std::vector<EpisodeResult>& results);
+
+} // namespace lv
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+
+namespace lv {
+
+enum class FrameFormat : uint8_t {
+    Ppm,  // one binary PPM (P6) file per frame in a directory
+    Raw,  // RGB24 frames appended to one file (ffmpeg -f rawvideo -pix_fmt rgb24)
+    Pipe  // RGB24 frames streamed into a shell command's stdin
+};
+
+// Sink for SoftwareRenderer frames. The spec selects the format:
+//   ppm:DIR      DIR/frame_000000.ppm, DIR/frame_000001.ppm, ...
+//   raw:FILE     FILE
+//   pipe:CMD     popen(CMD), e.g. "pipe:ffmpeg -f rawvideo -pix_fmt rgb24 -s 640x360 -r 60 -i - out.mp4"
+// Throws std::invalid_argument for a malformed spec and std::runtime_error
+// when the output cannot be opened or written.
+class FrameWriter {
+  public:
+    FrameWriter(const std::string& spec, int width, int height);
+    ~FrameWriter();
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // `frame` holds width * height packed RGB24 pixels.
+    void write(std::span<const uint8_t> frame);
+    // Flushes and closes the output; for pipes, waits for the command and
+    // throws if it failed. Called by the destructor (errors ignored there).
+    void close();
+
+    FrameFormat format() const { return format_; }
+    uint64_t frames_written() const { return frames_; }
+
+  private:
+    FrameFormat format_ = FrameFormat::Raw;
+    std::string target_;
+    int width_;
+    int height_;
+    std::FILE* file_ = nullptr;
+    uint64_t frames_ = 0;
+};
+
+} // namespace lv
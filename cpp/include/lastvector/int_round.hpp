@@ -0,0 +1,18 @@
+#pragma once
+
+// Internal helpers shared by the occupancy grid and the software renderer.
+
+namespace lv {
+
+// floor/ceil to int without the libm call; inputs must be finite and well inside int range.
+inline int floor_int(float v) {
+    const int i = static_cast<int>(v);
+    return i - (v < static_cast<float>(i));
+}
+
+inline int ceil_int(float v) {
+    const int i = static_cast<int>(v);
+    return i + (v > static_cast<float>(i));
+}
+
+} // namespace lv
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "action.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lv {
+
+enum class MlpActivation : uint32_t {
+    Tanh = 0, // SB3 MlpPolicy default
+    Relu = 1
+};
+
+// Deterministic actor of a Stable-Baselines3 MlpPolicy (Linear + activation
+// hidden layers, then the linear action_net producing the action mean), loaded
+// from the flat file written by python/export_policy.py. Little-endian:
+//   u32 magic "LVMP", u32 version 1, u32 obs_dim, u32 action_dim,
+//   u32 layer_count, u32 activation (MlpActivation)
+//   per layer: u32 inputs, u32 outputs, f32 weight[outputs][inputs], f32 bias[outputs]
+// The last layer has no activation. Each output is summed in input order
+// regardless of batch size, so batched and single forward passes agree
+// bit for bit.
+class MlpPolicy {
+  public:
+    // Throws std::runtime_error when the file is missing or malformed.
+    explicit MlpPolicy(const std::string& path);
+
+    size_t obs_dim() const { return obs_dim_; }
+    size_t action_dim() const { return action_dim_; }
+    size_t layer_count() const { return layers_.size(); }
+    MlpActivation activation() const { return activation_; }
+
+    // Row-major obs[batch][obs_dim] -> out[batch][action_dim]. Throws
+    // std::invalid_argument on a size mismatch. Uses internal scratch, so one
+    // MlpPolicy serves one thread at a time.
+    void forward(std::span<const float> obs, size_t batch, std::span<float> out);
+
+    // One observation to a game action (requires action_dim() == 8).
+    Action act(std::span<const float> obs);
+
+  private:
+    struct Layer {
+        size_t inputs = 0;
+        size_t outputs = 0;
+        size_t stride = 0;          // outputs rounded up to the output block
+        std::vector<float> weights; // transposed: weights[i * stride + o]
+        std::vector<float> bias;    // padded to stride
+    };
+
+    size_t obs_dim_ = 0;
+    size_t action_dim_ = 0;
+    MlpActivation activation_ = MlpActivation::Tanh;
+    std::vector<Layer> layers_;
+    std::vector<float> scratch_a_;
+    std::vector<float> scratch_b_;
+};
+
+} // namespace lv
@@ -1,11 +1,208 @@
 #pragma once
 
+#include "config.hpp"
+#include "obstacle_field.hpp"
 #include "state.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace lv {
 
+// Field offsets of the flat observation vector. Every block is fixed size, so
+// the builder writes each value straight to its slot.
+template <int NZombies, int NRays>
+struct ObservationLayout {
+    static constexpr int kZombies = NZombies;
+    static constexpr int kRays = NRays;
+
+    static constexpr int kPlayerFields = 11;
+    static constexpr int kZombieFields = 5; // rel x, rel y, distance, rel vel x, rel vel y
+    static constexpr int kRayFields = 2;    // obstacle t, zombie t
+    static constexpr int kUpgradeOfferFields = 3;
+    static constexpr int kUpgradeLevelFields = static_cast<int>(UpgradeId::Count);
+
+    static constexpr int kPlayerOffset = 0;
+    static constexpr int kZombieOffset = kPlayerOffset + kPlayerFields;
+    static constexpr int kRayOffset = kZombieOffset + NZombies * kZombieFields;
+    static constexpr int kDifficultyOffset = kRayOffset + NRays * kRayFields;
+    static constexpr int kChoosingUpgradeOffset = kDifficultyOffset + 1;
+    static constexpr int kUpgradeOfferOffset = kChoosingUpgradeOffset + 1;
+    static constexpr int kUpgradeLevelOffset = kUpgradeOfferOffset + kUpgradeOfferFields;
+    static constexpr int kDim = kUpgradeLevelOffset + kUpgradeLevelFields;
+
+    static constexpr int zombie_offset(int slot) { return kZombieOffset + slot * kZombieFields; }
+    static constexpr int ray_offset(int ray) { return kRayOffset + ray * kRayFields; }
+
+    using Buffer = std::array<float, kDim>;
+};
+
+// Compiled observation layouts as X(zombies, rays).
+#define LV_FOR_EACH_OBS_LAYOUT(X) \
+    X(8, 16) X(8, 32) X(8, 64) X(16, 16) X(16, 32) X(16, 64) X(32, 16) X(32, 32) X(32, 64)
+
+constexpr int observation_dim_for(int zombie_obs_count, int ray_count) {
+    return ObservationLayout<0, 0>::kDim + zombie_obs_count * ObservationLayout<0, 0>::kZombieFields +
+           ray_count * ObservationLayout<0, 0>::kRayFields;
+}
+
+// Unit ray directions, evenly spaced counter-clockwise from +x.
+template <int NRays>
+const std::array<Vec2, NRays>& ray_directions() {
+    static const std::array<Vec2, NRays> dirs = [] {
+        constexpr float kTwoPi = 6.28318530718f;
+        std::array<Vec2, NRays> out{};
+        for (int i = 0; i < NRays; ++i) {
+            const float theta = (static_cast<float>(i) / static_cast<float>(NRays)) * kTwoPi;
+            out[static_cast<size_t>(i)] = {std::cos(theta), std::sin(theta)};
+        }
+        return out;
+    }();
+    return dirs;
+}
+
+// Player-relative zombie data gathered in a single pass over GameState::zombies.
+// Holds everything the observation and reward need from the zombie list: the
+// nearest NZombies zombies (sorted by squared distance, ties broken by
+// Zombie::id so storage order never matters) and the first zombie hit along
+// each of the NRays observation rays.
+template <int NZombies, int NRays>
+struct BasicZombieSweep {
+    int nearest_count = 0;
+    std::array<uint32_t, NZombies> nearest_index{};
+    std::array<uint32_t, NZombies> nearest_id{};
+    std::array<float, NZombies> nearest_dist_sq{};
+    std::array<float, NRays> ray_t{};
+
+    BasicZombieSweep() { ray_t.fill(std::numeric_limits<float>::infinity()); }
+
+    void add(uint32_t index, uint32_t id, float dx, float dy, float dist_sq) {
+        add_nearest(index, id, dist_sq);
+        add_rays(dx, dy, dist_sq);
+    }
+    void add_nearest(uint32_t index, uint32_t id, float dist_sq);
+    void add_rays(float dx, float dy, float dist_sq);
+    // True when the player overlaps a nearest zombie; every ray then reads 0.
+    bool in_contact() const { return nearest_count > 0 && nearest_dist_sq[0] - kZombieRadius * kZombieRadius <= 0.0f; }
+    float nearest_distance(float fallback) const;
+};
+
+using ZombieSweep = BasicZombieSweep<kZombieObsCount, kRayCount>;
+
+template <int NZombies, int NRays>
+void BasicZombieSweep<NZombies, NRays>::add_nearest(uint32_t index, uint32_t id, float dist_sq) {
+    const auto closer = [&](int slot) {
+        const size_t s = static_cast<size_t>(slot);
+        return dist_sq < nearest_dist_sq[s] || (dist_sq == nearest_dist_sq[s] && id < nearest_id[s]);
+    };
+    if (nearest_count < NZombies || closer(nearest_count - 1)) {
+        int slot = std::min(nearest_count, NZombies - 1);
+        while (slot > 0 && closer(slot - 1)) {
+            nearest_dist_sq[slot] = nearest_dist_sq[slot - 1];
+            nearest_index[slot] = nearest_index[slot - 1];
+            nearest_id[slot] = nearest_id[slot - 1];
+            --slot;
+        }
+        nearest_dist_sq[slot] = dist_sq;
+        nearest_index[slot] = index;
+        nearest_id[slot] = id;
+        nearest_count = std::min(nearest_count + 1, NZombies);
+    }
+}
+
+template <int NZombies, int NRays>
+void BasicZombieSweep<NZombies, NRays>::add_rays(float dx, float dy, float dist_sq) {
+    // Same arithmetic as ray_intersect_circle with origin - center == -(dx, dy),
+    // so the minima match the per-ray brute-force test bit for bit.
+    const float c = dist_sq - kZombieRadius * kZombieRadius;
+    if (c <= 0.0f) {
+        ray_t.fill(0.0f);
+        return;
+    }
+    const auto& dirs = ray_directions<NRays>();
+    for (int i = 0; i < NRays; ++i) {
+        const Vec2 dir = dirs[static_cast<size_t>(i)];
+        const float proj = dx * dir.x + dy * dir.y;
+        const float disc = proj * proj - c;
+        if (disc < 0.0f) continue;
+        const float sqrt_disc = std::sqrt(disc);
+        float t = proj - sqrt_disc;
+        if (t < 0.0f) {
+            t = proj + sqrt_disc;
+            if (t < 0.0f) continue;
+        }
+        ray_t[static_cast<size_t>(i)] = std::min(ray_t[static_cast<size_t>(i)], t);
+    }
+}
+
+template <int NZombies, int NRays>
+float BasicZombieSweep<NZombies, NRays>::nearest_distance(float fallback) const {
+    if (nearest_count == 0) return fallback;
+    return std::min(fallback, std::sqrt(nearest_dist_sq[0]));
+}
+
+template <int NZombies, int NRays>
+BasicZombieSweep<NZombies, NRays> sweep_zombies(const GameState& state) {
+    BasicZombieSweep<NZombies, NRays> sweep;
+    const Vec2 p = state.player.pos;
+    for (size_t i = 0; i < state.zombies.size(); ++i) {
+        const float dx = state.zombies[i].pos.x - p.x;
+        const float dy = state.zombies[i].pos.y - p.y;
+        sweep.add(static_cast<uint32_t>(i), state.zombies[i].id, dx, dy, dx * dx + dy * dy);
+    }
+    return sweep;
+}
+
+// Writes every field of the observation into `out`. Obstacle rays are traced
+// through `field` when given (it must hold state.obstacles), otherwise tested
+// against every obstacle; both give the same values. Defined in
+// observation.cpp for the layouts in LV_FOR_EACH_OBS_LAYOUT.
+template <int NZombies, int NRays>
+void write_observation(const GameState& state,
+                       const BasicZombieSweep<NZombies, NRays>& sweep,
+                       const ObstacleField* field,
+                       std::span<float, ObservationLayout<NZombies, NRays>::kDim> out);
+
+template <int NZombies, int NRays>
+std::vector<float> build_observation(const GameState& state,
+                                     const BasicZombieSweep<NZombies, NRays>& sweep,
+                                     const ObstacleField* field = nullptr) {
+    std::vector<float> obs(ObservationLayout<NZombies, NRays>::kDim);
+    write_observation(state, sweep, field, std::span<float, ObservationLayout<NZombies, NRays>::kDim>(obs));
+    return obs;
+}
+
+template <int NZombies, int NRays>
+std::vector<float> build_observation(const GameState& state) {
+    return build_observation(state, sweep_zombies<NZombies, NRays>(state));
+}
+
 std::vector<float> build_observation(const GameState& state);
 
+// Calls fn.template operator()<NZombies, NRays>() for a compiled observation
+// layout, so callers pick a specialization once instead of branching per tick.
+// Throws std::invalid_argument for any other layout.
+template <typename Fn>
+decltype(auto) visit_obs_layout(int zombie_obs_count, int ray_count, Fn&& fn) {
+#define LV_VISIT_OBS_LAYOUT(Z, R) \
+    if (zombie_obs_count == (Z) && ray_count == (R)) return fn.template operator()<Z, R>();
+    LV_FOR_EACH_OBS_LAYOUT(LV_VISIT_OBS_LAYOUT)
+#undef LV_VISIT_OBS_LAYOUT
+    throw std::invalid_argument("unsupported observation layout: " + std::to_string(zombie_obs_count) +
+                                " zombies x " + std::to_string(ray_count) + " rays");
+}
+
+#define LV_DECLARE_OBS_LAYOUT(Z, R) \
+    extern template void write_observation<Z, R>(const GameState&, const BasicZombieSweep<Z, R>&, \
+                                                 const ObstacleField*, std::span<float, ObservationLayout<Z, R>::kDim>);
+LV_FOR_EACH_OBS_LAYOUT(LV_DECLARE_OBS_LAYOUT)
+#undef LV_DECLARE_OBS_LAYOUT
+
 } // namespace lv
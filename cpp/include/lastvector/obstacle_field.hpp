@@ -0,0 +1,53 @@
+#pragma once
+
+#include "state.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lv {
+
+// Distance field of the static obstacles, sampled per grid cell. Each cell
+// stores a clearance (the exact distance from the closest point of the cell to
+// the closest obstacle, 0 inside or touching one) plus the obstacles within
+// kObstacleFieldReach of the cell. Far from the surface the clearance alone
+// answers queries; near it the cell's candidates are tested exactly with the
+// same AABB routines as the brute-force loops, so results match them bit for
+// bit. The arena boundary is not part of the field.
+class ObstacleField {
+  public:
+    ObstacleField() = default;
+
+    // Rebuilds only when the obstacle set or cell size changed. cell_size <= 0
+    // clears the field and every query falls back to testing all obstacles.
+    void build(const std::vector<Obstacle>& obstacles, Vec2 arena_size, float cell_size);
+
+    bool empty() const { return cols_ == 0; }
+    const std::vector<Obstacle>& obstacles() const { return obstacles_; }
+
+    // Same result as min(ray_intersect_aabb) over every obstacle, capped at
+    // `t_limit` (pass the arena exit distance).
+    float raycast(Vec2 origin, Vec2 dir, float t_limit) const;
+
+    // Same result as circle_vs_aabb_resolve against every obstacle in order.
+    void resolve_circle(Vec2& center, float radius) const;
+
+  private:
+    std::vector<Obstacle> obstacles_;
+    Vec2 arena_size_{};
+    float cell_size_ = 0.0f;
+    float inv_cell_size_ = 0.0f;
+    int cols_ = 0;
+    int rows_ = 0;
+    std::vector<float> clearance_;
+    std::vector<uint32_t> candidate_start_; // CSR offsets, cols_ * rows_ + 1 entries
+    std::vector<uint16_t> candidates_;      // obstacle indices, ascending per cell
+
+    size_t cell_index(Vec2 p) const;
+    std::span<const uint16_t> candidates(size_t cell) const {
+        return {candidates_.data() + candidate_start_[cell], candidates_.data() + candidate_start_[cell + 1]};
+    }
+};
+
+} // namespace lv
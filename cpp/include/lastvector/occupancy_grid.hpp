@@ -0,0 +1,61 @@
+#pragma once
+
+#include "state.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lv {
+
+constexpr int kOccupancyGridSize = 64;
+constexpr float kOccupancyCellSize = 16.0f;
+
+enum class OccupancyChannel : uint8_t {
+    Obstacles, // obstacles and everything outside the arena
+    Zombies,
+    Bullets,
+    RingOfFire, // disc of the Ring of Fire damage radius, empty until the upgrade is taken
+    Count
+};
+constexpr int kOccupancyChannels = static_cast<int>(OccupancyChannel::Count);
+
+// Egocentric top-down occupancy observation: kOccupancyChannels planes of
+// size x size uint8 cells (0 or 255, channel-major, rows top to bottom), each
+// cell cell_size world units wide. The window is snapped to the world cell
+// grid with the player's cell at (size / 2, size / 2), so the obstacle plane
+// is a crop of a layer rasterized once per obstacle layout. Shapes are filled
+// a row span at a time: a cell is set when its center lies inside the shape,
+// plus the cell holding the shape's center so small bullets never vanish.
+class OccupancyGrid {
+  public:
+    // Throws std::invalid_argument unless size > 0 and cell_size > 0.
+    OccupancyGrid(int size, float cell_size);
+
+    int size() const { return size_; }
+    float cell_size() const { return cell_size_; }
+    size_t dim() const { return static_cast<size_t>(kOccupancyChannels) * size_ * size_; }
+
+    // Rasterizes the obstacle layer over the arena plus a wall border; only
+    // reruns when the obstacles or arena changed.
+    void build_static(const std::vector<Obstacle>& obstacles, Vec2 arena_size);
+
+    // Writes every channel for the current state. Throws std::invalid_argument
+    // unless out.size() == dim().
+    void write(const GameState& state, std::span<uint8_t> out) const;
+
+  private:
+    int size_;
+    float cell_size_;
+    float inv_cell_size_;
+
+    std::vector<Obstacle> obstacles_;
+    Vec2 arena_size_{};
+    int border_ = 0; // wall cells around the arena in static_layer_
+    int static_cols_ = 0;
+    int static_rows_ = 0;
+    std::vector<uint8_t> static_layer_;
+};
+
+} // namespace lv
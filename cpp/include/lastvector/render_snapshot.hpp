@@ -0,0 +1,62 @@
+#pragma once
+
+#include "state.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lv {
+
+// What a renderer needs from one simulation tick, copied out of the
+// GameState so the simulation can move on while it is drawn.
+struct RenderSnapshot {
+    uint64_t tick = 0;     // GameState::tick, which stands still while an upgrade is picked
+    uint64_t sequence = 0; // steps since the publisher started, set by the publisher
+    float episode_time_s = 0.0f;
+    float difficulty_scalar = 0.0f;
+    PlayState play_state = PlayState::Playing;
+    Vec2 arena_size{};
+    Player player{};
+    Vec2 aim{}; // aim of the action that produced this tick, for the camera
+    int kills = 0;
+    std::array<UpgradeId, 3> upgrade_offer{};
+    std::vector<Zombie> zombies;
+    std::vector<Bullet> bullets;
+    std::vector<Obstacle> obstacles;
+    std::chrono::steady_clock::time_point published{};
+};
+
+// Overwrites `out` in place, reusing its vectors' capacity.
+void capture_snapshot(const GameState& state, Vec2 aim, RenderSnapshot& out);
+
+// Builds the scenes drawn between two snapshots. Keeps the previous
+// snapshot's zombie positions sorted by id across frames and only rebuilds
+// them when that snapshot changes, so the render path neither allocates nor
+// sorts per frame. One instance per render loop.
+class SnapshotInterpolator {
+  public:
+    // The scene `alpha` of the way from `prev` (0) to `cur` (1), which may be
+    // several ticks apart. The player and the zombies present in both (matched
+    // by id) are lerped; zombies and bullets only in `cur` (bullets carry no
+    // id) are moved back along their velocity; everything else comes from
+    // `cur`. Overwrites `out` in place, reusing its vectors' capacity.
+    void interpolate(const RenderSnapshot& prev, const RenderSnapshot& cur, float alpha, RenderSnapshot& out);
+
+  private:
+    // `prev` is identified by its sequence number and publish time.
+    uint64_t prev_sequence_ = 0;
+    std::chrono::steady_clock::time_point prev_published_{};
+    bool have_prev_ = false;
+    std::vector<std::pair<uint32_t, Vec2>> prev_pos_;
+};
+
+// Fraction of the publish interval between `prev` and `cur` that has passed
+// since `cur` was published, in [0, 1]. Drawing at this alpha shows the
+// simulation one snapshot behind, moving smoothly between snapshots.
+float interpolation_alpha(const RenderSnapshot& prev, const RenderSnapshot& cur,
+                          std::chrono::steady_clock::time_point now);
+
+} // namespace lv
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "action.hpp"
+#include "config.hpp"
+#include "sim.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lv {
+
+// Replay files (.lvr) hold one episode: the seed and SimConfig, then the
+// action of every step, quantized and delta-coded, with a Simulator keyframe
+// (save_state) before every keyframe_interval-th step. Keyframes open
+// self-contained blocks (action deltas restart at zero), and an index of
+// block offsets closes the file, so a reader maps it read-only and seeks to
+// any step by loading the nearest keyframe at or before it and stepping at
+// most keyframe_interval - 1 times. All integers are little-endian.
+//
+//   header   u32 magic "LVRP", u32 version, u64 seed, u32 keyframe_interval,
+//            SimConfig fields
+//   blocks   u32 state size, state bytes, action records
+//   index    per block: u64 first step, u64 file offset
+//   trailer  u64 final state hash, u64 index offset, u64 step count,
+//            u32 block count, u32 "LVRE"
+//
+// An action record is a flags byte (shoot, sprint, reload, upgrade choice + 1,
+// move changed, aim changed) followed by zigzag varint deltas of the int16
+// move and aim when they changed, then the low 32 bits of
+// Simulator::state_hash() before the step. Idle ticks take five bytes.
+// Version 1 files (no hashes, no final hash in the trailer) still play.
+
+// The action a replay stores for `action`: move clamped to [-1, 1] and aim
+// scaled to unit max-norm (the simulator only uses its direction), both on a
+// 1/32767 grid; an upgrade choice outside [0, 2] becomes -1. Stepping the
+// recorded action instead of the original is what makes replays exact.
+Action quantize_action(const Action& action);
+
+class ReplayWriter {
+  public:
+    static constexpr uint32_t kDefaultKeyframeInterval = 600;
+
+    // Throws std::runtime_error if the file cannot be created and
+    // std::invalid_argument for keyframe_interval < 1.
+    ReplayWriter(const std::string& path, const SimConfig& config, uint64_t seed,
+                 uint32_t keyframe_interval = kDefaultKeyframeInterval);
+    // Closes the file if close() was not called, ignoring write errors.
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    // Records the step `sim` is about to take and returns the action to take
+    // instead of `action` (quantize_action(action)). `sim` must be the same
+    // simulator on every call, stepped once with each returned action.
+    Action record(const Simulator& sim, const Action& action);
+
+    uint64_t steps() const { return steps_; }
+    uint64_t bytes_written() const { return offset_ + buffer_.size(); }
+
+    // Writes the index and trailer; `final_state`, the simulator after the
+    // last recorded step, adds its state hash. Throws std::runtime_error on
+    // I/O errors.
+    void close(const Simulator* final_state = nullptr);
+
+  private:
+    void flush();
+
+    std::ofstream file_;
+    std::string path_;
+    uint32_t keyframe_interval_;
+    std::vector<uint8_t> buffer_;
+    std::vector<uint8_t> state_;
+    uint64_t offset_ = 0; // bytes already handed to file_
+    uint64_t steps_ = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> index_; // (first step, block offset)
+    std::array<int16_t, 4> last_{}; // move x/y, aim x/y of the previous record
+    bool closed_ = false;
+};
+
+// Where a replayed run first left the recorded one.
+struct ReplayDivergence {
+    uint64_t step = 0; // the state before this step differs
+    uint64_t tick = 0; // GameState::tick of that state in the replay
+    std::string what;
+};
+
+// Plays a replay file back through its own Simulator. The file is mapped
+// read-only; nothing is decoded ahead of the current step.
+class ReplayPlayer {
+  public:
+    // Throws std::runtime_error when the file is missing, truncated (for
+    // example because the recording process died before close()) or not a
+    // replay of this version.
+    explicit ReplayPlayer(const std::string& path);
+    ~ReplayPlayer();
+
+    ReplayPlayer(const ReplayPlayer&) = delete;
+    ReplayPlayer& operator=(const ReplayPlayer&) = delete;
+
+    uint64_t seed() const { return seed_; }
+    const SimConfig& config() const { return sim_->config(); }
+    uint32_t keyframe_interval() const { return keyframe_interval_; }
+    uint64_t length() const { return length_; } // recorded steps
+    // Steps played so far; sim() is the state before step position().
+    uint64_t position() const { return position_; }
+    bool at_end() const { return position_ == length_; }
+    const Simulator& sim() const { return *sim_; }
+    // Whether the file records per-step state hashes (version 2 and later).
+    bool has_checksums() const { return version_ >= 2; }
+
+    // Moves to the state before `step` (0..length()). Throws std::out_of_range
+    // past the end.
+    void seek(uint64_t step);
+    // Plays the next recorded step; false when there is none left.
+    bool step();
+
+    // For callers that step the simulator themselves, e.g. on a SimThread:
+    // the recorded action of step position(), advancing position(). The
+    // caller must step simulator() with it before the next call. Throws
+    // std::out_of_range at the end.
+    Action next_action();
+    Simulator& simulator() { return *sim_; }
+
+    // Replays the whole file from the first keyframe, checking the simulator
+    // against every recorded state hash, every later keyframe and the final
+    // hash. Returns the first divergence, or nothing when the run reproduces
+    // exactly; either way position() is left where it stopped. Throws
+    // std::runtime_error for a replay without checksums.
+    std::optional<ReplayDivergence> verify();
+
+  private:
+    void enter_block(size_t block, bool load_keyframe);
+    std::span<const uint8_t> keyframe_state(size_t block) const;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::string path_;
+    uint32_t version_ = 0;
+    uint64_t seed_ = 0;
+    uint32_t keyframe_interval_ = 0;
+    uint64_t final_hash_ = 0; // 0 when not recorded
+    uint64_t length_ = 0;
+    std::vector<uint64_t> block_offsets_;
+    size_t block_ = 0;
+    size_t actions_end_ = 0; // where block_'s action records stop
+    std::optional<Simulator> sim_; // built from the header's SimConfig
+    uint64_t position_ = 0;
+    size_t cursor_ = 0;
+    std::array<int16_t, 4> last_{};
+    uint32_t step_hash_ = 0; // recorded hash before the step next_action() returned
+};
+
+} // namespace lv
@@ -7,9 +7,9 @@ namespace lv {
 
 class DeterministicRng {
   public:
-    explicit DeterministicRng(uint64_t seed = 0) : eng_(seed) {}
+    explicit DeterministicRng(uint64_t seed = 0) : eng_{std::mt19937_64(seed), 0} {}
 
-    void reseed(uint64_t seed) { eng_.seed(seed); }
+    void reseed(uint64_t seed) { eng_ = {std::mt19937_64(seed), 0}; }
 
     float uniform(float lo, float hi) {
         std::uniform_real_distribution<float> dist(lo, hi);
@@ -21,8 +21,32 @@ class DeterministicRng {
         return dist(eng_);
     }
 
+    // Engine outputs consumed since the last reseed. With the seed this is the
+    // whole generator state: restore(seed, draws()) continues the same stream.
+    uint64_t draws() const { return eng_.draws; }
+    void restore(uint64_t seed, uint64_t draws) {
+        reseed(seed);
+        eng_.engine.discard(draws);
+        eng_.draws = draws;
+    }
+
   private:
-    std::mt19937_64 eng_;
+    // mt19937_64 that counts its outputs; distributions may take more than
+    // one output per value (rejection sampling), so values drawn would not do.
+    struct CountingEngine {
+        using result_type = std::mt19937_64::result_type;
+        static constexpr result_type min() { return std::mt19937_64::min(); }
+        static constexpr result_type max() { return std::mt19937_64::max(); }
+        result_type operator()() {
+            ++draws;
+            return engine();
+        }
+
+        std::mt19937_64 engine;
+        uint64_t draws;
+    };
+
+    CountingEngine eng_;
 };
 
 } // namespace lv
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "action.hpp"
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace lv {
+
+class MlpPolicy;
+class ThreadPool;
+
+struct RolloutConfig {
+    SimConfig sim{};
+    int envs = 8;            // N simulators advanced in lockstep
+    int steps = 2048;        // T steps per collect()
+    uint64_t first_seed = 0; // env i plays seeds first_seed + i, + i + envs, + i + 2 * envs, ...
+    int threads = 1;         // simulator stepping; the policy runs on the calling thread
+};
+
+// An episode that ended during the last collect().
+struct RolloutEpisode {
+    uint32_t env = 0;
+    uint32_t step = 0; // rollout step of its last transition
+    uint64_t seed = 0;
+    double reward = 0.0; // undiscounted return over the whole episode
+    int length = 0;      // steps, including those of earlier rollouts
+    float survival_s = 0.0f;
+    int kills = 0;
+    int shots_fired = 0;
+    int hits = 0;
+    float accuracy = 0.0f;
+    float damage_dealt = 0.0f;
+    float damage_taken = 0.0f;
+    bool truncated = false; // time limit rather than death
+};
+
+// Called once per rollout step with that step's (N, obs_dim) observations;
+// writes the (N, 8) raw policy outputs to `actions`.
+using RolloutPolicy = std::function<void(size_t step, std::span<const float> obs, std::span<float> actions)>;
+
+// Collects on-policy rollouts from N simulators straight into contiguous,
+// preallocated (T, N, ...) arrays laid out like Stable-Baselines3's
+// RolloutBuffer, so a trainer consumes a whole rollout without per-step
+// Python or per-env bookkeeping. Each step makes one batched policy call,
+// then the simulators step in parallel; an env whose episode ends records
+// it in episodes() and resets to its next seed, and the following row
+// starts the new episode. The simulators carry on from one collect() to
+// the next. Results do not depend on the thread count.
+class RolloutCollector {
+  public:
+    // Throws std::invalid_argument for a bad config or sim config.
+    explicit RolloutCollector(const RolloutConfig& config);
+    ~RolloutCollector();
+
+    RolloutCollector(const RolloutCollector&) = delete;
+    RolloutCollector& operator=(const RolloutCollector&) = delete;
+
+    size_t envs() const { return envs_.size(); }
+    size_t steps() const { return steps_; }
+    size_t obs_dim() const { return obs_dim_; }
+    static constexpr size_t action_dim() { return kActionValues; }
+
+    // Fills every buffer below for the next T steps. Raw policy outputs are
+    // stored as given and only go through decode_action, as in
+    // LastVectorEnv, when stepping, so they can be scored by the policy that
+    // produced them. Exceptions from
+    // the policy propagate and leave the buffers partly written.
+    void collect(const RolloutPolicy& policy);
+    // The deterministic action means of an exported actor (no exploration
+    // noise). Throws std::invalid_argument for a policy of another shape.
+    void collect(MlpPolicy& policy);
+
+    // Views into the collector; overwritten by the next collect().
+    std::span<const float> observations() const; // (T, N, obs_dim), before each step
+    std::span<const float> last_observations() const; // (N, obs_dim), after the last step
+    std::span<const float> actions() const { return actions_; }   // (T, N, 8) raw policy outputs
+    std::span<const float> rewards() const { return rewards_; }   // (T, N)
+    std::span<const uint8_t> terminated() const { return terminated_; } // (T, N)
+    std::span<const uint8_t> truncated() const { return truncated_; }   // (T, N)
+    // (T, N): observation t is the first of its episode.
+    std::span<const uint8_t> episode_starts() const { return episode_starts_; }
+    // Episodes that ended, in (step, env) order.
+    const std::vector<RolloutEpisode>& episodes() const { return episodes_; }
+    // (episodes, obs_dim): the observation each of them ended on, which the
+    // next row no longer shows; a truncated episode's value is bootstrapped
+    // from it.
+    std::span<const float> final_observations() const { return final_obs_; }
+
+  private:
+    struct Env;
+
+    void step_env(size_t step, size_t env);
+
+    size_t steps_ = 0;
+    size_t obs_dim_ = 0;
+    std::vector<std::unique_ptr<Env>> envs_;
+    std::unique_ptr<ThreadPool> pool_;
+
+    std::vector<float> obs_; // (T + 1, N, obs_dim); row T is last_observations()
+    std::vector<float> actions_;
+    std::vector<float> rewards_;
+    std::vector<uint8_t> terminated_;
+    std::vector<uint8_t> truncated_;
+    std::vector<uint8_t> episode_starts_;
+    std::vector<uint8_t> next_starts_; // (N,) episode_starts of the next collect()'s first row
+    std::vector<RolloutEpisode> episodes_;
+    std::vector<float> final_obs_;
+};
+
+} // namespace lv
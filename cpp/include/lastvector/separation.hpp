@@ -0,0 +1,66 @@
+#pragma once
+
+#include "config.hpp"
+#include "state.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace lv {
+
+constexpr float kZombieSeparationRadius = 22.0f;
+constexpr float kZombieNeighborSkin = 12.0f;
+
+// Verlet neighbor list for zombie separation. Holds every pair closer than
+// cutoff + skin and is rebuilt only when the zombie set changes or some zombie
+// has drifted more than skin/2 from where it was at the last build; while no
+// zombie has, every pair it leaves out is beyond the cutoff. Pairs are stored
+// in the (i, j), i < j order the brute-force loop visits them.
+class ZombieNeighborList {
+  public:
+    ZombieNeighborList(float cutoff, float skin);
+
+    void invalidate() { valid_ = false; }
+    void refresh(const std::vector<Zombie>& zombies);
+    // Zombie i at `pos` may have a pair the list misses.
+    bool drifted(size_t i, Vec2 pos) const;
+
+    const std::vector<std::pair<uint32_t, uint32_t>>& pairs() const { return pairs_; }
+    // Neighbours of zombie i in ascending index order.
+    std::span<const uint32_t> adjacent(size_t i) const {
+        return {adjacency_.data() + offsets_[i], adjacency_.data() + offsets_[i + 1]};
+    }
+    uint64_t rebuild_count() const { return rebuilds_; }
+
+  private:
+    float cutoff_;
+    float skin_;
+    bool valid_ = false;
+    uint64_t rebuilds_ = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs_;
+    std::vector<Vec2> anchors_;
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> adjacency_;
+
+    void rebuild(const std::vector<Zombie>& zombies);
+};
+
+// Sorts zombies along a Z-order (Morton) curve of their grid cells, ties broken
+// by Zombie::id, so spatial neighbours sit close together in memory.
+void sort_zombies_by_morton(std::vector<Zombie>& zombies);
+
+// Zombie-zombie and zombie-player overlap resolution (two passes). `pool` is
+// only used by the Jacobi solver and may be null.
+void separate_zombies(std::vector<Zombie>& zombies,
+                      Vec2& player_pos,
+                      Vec2 arena_size,
+                      NeighborSearch search,
+                      ZombieNeighborList& neighbors,
+                      SeparationSolver solver = SeparationSolver::GaussSeidel,
+                      ThreadPool* pool = nullptr);
+
+} // namespace lv
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "agent_protocol.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace lv {
+
+enum class ShmMailboxRole : uint8_t {
+    Server, // creates the segment and answers requests
+    Client  // attaches to an existing segment and sends requests
+};
+
+// Request/response exchange between the game and a local agent through a
+// POSIX shared-memory segment (/dev/shm/<name>). Each direction is a single
+// slot holding one agent frame (agent_protocol.hpp) plus a sequence counter:
+// the writer fills the slot, bumps the counter and wakes the peer with a
+// futex; the reader spins briefly and then sleeps on the counter. Exactly one
+// request is in flight at a time, so each slot has a single producer and a
+// single consumer. Layout (little-endian, see shm_mailbox.cpp) is shared with
+// python/agent_server.py.
+class ShmMailbox {
+  public:
+    static constexpr size_t kSlotCapacity = kAgentFrameHeaderBytes + 65535 * sizeof(float);
+
+    // Server: creates or replaces the segment and advertises `model`.
+    // Client: attaches; throws std::runtime_error if the segment is missing,
+    // incompatible or already has a client.
+    ShmMailbox(const std::string& name, ShmMailboxRole role, const std::string& model = {});
+    ~ShmMailbox();
+    ShmMailbox(const ShmMailbox&) = delete;
+    ShmMailbox& operator=(const ShmMailbox&) = delete;
+
+    const std::string& model() const { return model_; }
+
+    // Client side. wait_response() throws std::runtime_error if the server
+    // process exits or cancel() was called; the returned frame stays valid
+    // until the next request.
+    void post_request(std::span<const uint8_t> frame);
+    std::span<const uint8_t> wait_response();
+    // Makes a wait_response() on another thread, and every later one, throw.
+    void cancel();
+
+    // Server side. Returns an empty span when no request arrived within
+    // timeout_ms; otherwise the request frame, valid until post_response().
+    std::span<const uint8_t> wait_request(int timeout_ms);
+    void post_response(std::span<const uint8_t> frame);
+
+  private:
+    struct Header;
+
+    std::string name_;
+    ShmMailboxRole role_;
+    std::string model_;
+    int fd_ = -1;
+    void* base_ = nullptr;
+    size_t size_ = 0;
+    uint32_t request_seen_ = 0;
+    uint32_t response_seen_ = 0;
+    std::atomic<bool> cancelled_{false};
+
+    Header* header() const { return static_cast<Header*>(base_); }
+    uint8_t* request_slot() const;
+    uint8_t* response_slot() const;
+};
+
+} // namespace lv
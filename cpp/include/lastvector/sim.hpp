@@ -2,41 +2,99 @@
 
 #include "action.hpp"
 #include "env_api.hpp"
+#include "observation.hpp"
+#include "obstacle_field.hpp"
+#include "occupancy_grid.hpp"
 #include "rng.hpp"
+#include "separation.hpp"
 #include "state.hpp"
+#include "zombie_ray_grid.hpp"
 
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
 
 namespace lv {
 
+// Runtime settings come from SimConfig; the observation layout is resolved to a
+// template specialization at construction, so the per-tick zombie sweep and
+// observation loops run over compile-time counts.
 class Simulator {
   public:
     Simulator();
+    // Throws std::invalid_argument for an invalid config or an observation
+    // layout that is not compiled in.
+    explicit Simulator(const SimConfig& config);
 
     std::vector<float> reset(uint64_t seed);
     StepResult step(const Action& action);
 
     static constexpr int action_dim() { return 8; }
-    static constexpr int observation_dim() {
-        return 11 + (kZombieObsCount * 5) + (kRayCount * 2) + 2 + 3 + static_cast<int>(UpgradeId::Count);
-    }
+    int observation_dim() const { return observation_dim_for(config_.zombie_obs_count, config_.ray_count); }
+    std::vector<float> observation() const;
+    // Writes the current observation into `out` without allocating. Throws
+    // std::invalid_argument unless out.size() == observation_dim().
+    void observe_into(std::span<float> out) const;
 
+    // Egocentric occupancy grid of the current state, an alternative to the
+    // vector observation for convolutional policies (see OccupancyGrid).
+    // occupancy_into throws std::invalid_argument unless out.size() ==
+    // occupancy_dim().
+    size_t occupancy_dim() const { return occupancy_grid_.dim(); }
+    std::vector<uint8_t> occupancy() const;
+    void occupancy_into(std::span<uint8_t> out) const;
+
+    const SimConfig& config() const { return config_; }
     const GameState& state() const { return state_; }
 
+    // Everything step() depends on (the GameState, the RNG position and the
+    // upgrade timeout) in a compact little-endian encoding, appended to `out`.
+    // Replay keyframes are made of these.
+    void save_state(std::vector<uint8_t>& out) const;
+    // Continues exactly where the saved simulator was: stepping both with the
+    // same actions gives identical states. Throws std::runtime_error for
+    // malformed data or a state saved with a different arena size.
+    void load_state(std::span<const uint8_t> bytes);
+
+    // 64-bit hash of the state reached by the last reset(), step() or
+    // load_state(): player, zombies, bullets, upgrades, stats, timers and the
+    // RNG position, over the exact float bits. Zombies and bullets are hashed
+    // as sets, so reordering them (the periodic Morton sort) does not change
+    // it. Two simulators that agree on it every tick followed the same
+    // trajectory; replays record it to detect desyncs.
+    uint64_t state_hash() const { return state_hash_; }
+
   private:
+    using StepFn = StepResult (Simulator::*)(const Action&);
+    using ObserveFn = void (*)(const GameState&, const ObstacleField&, std::span<float>);
+
+    SimConfig config_{};
+    StepFn step_fn_ = nullptr;
+    ObserveFn observe_fn_ = nullptr;
     GameState state_{};
     DeterministicRng rng_{0};
     int upgrade_pause_ticks_ = 0;
+    uint64_t state_hash_ = 0;
+    ZombieNeighborList zombie_neighbors_{kZombieSeparationRadius, kZombieNeighborSkin};
+    std::unique_ptr<ThreadPool> separation_pool_;
+    ZombieRayGrid zombie_ray_grid_{kZombieRayGridCellSize};
+    ObstacleField obstacle_field_;
+    OccupancyGrid occupancy_grid_;
 
     void init_obstacles();
+    void update_state_hash();
     void roll_upgrade_offer();
     void spawn_zombie();
     void update_player(const Action& action);
     void update_zombies();
     void update_bullets();
-    void apply_ring_of_fire();
+    template <int NZombies, int NRays>
+    BasicZombieSweep<NZombies, NRays> sweep_zombies();
+    template <int NZombies, int NRays>
+    StepResult step_layout(const Action& action);
     void handle_upgrade_choice(const Action& action);
-    float compute_reward(const RuntimeStats& prev) const;
+    float compute_reward(const RuntimeStats& prev, float nearest_zombie) const;
 };
 
 } // namespace lv
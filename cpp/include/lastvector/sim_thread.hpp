@@ -0,0 +1,75 @@
+#pragma once
+
+#include "render_snapshot.hpp"
+#include "sim.hpp"
+#include "triple_buffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <thread>
+
+namespace lv {
+
+// Steps a Simulator on its own thread at a steady kFixedDt per tick, or
+// `speed` ticks per kFixedDt for fast-forward, and publishes a RenderSnapshot
+// after every tick through a TripleBuffer. The render thread reads the newest
+// pair of snapshots with poll() and never blocks the simulation, nor the
+// other way round. A simulation that falls more than a quarter second behind
+// its schedule drops the backlog instead of running a burst to catch up.
+class SimThread {
+  public:
+    static constexpr int kMaxSpeed = 64;
+
+    // Called on the simulation thread: the action for the next tick, and
+    // (optionally) a hook after each step. An exception from either stops
+    // the thread; rethrow_if_failed() passes it on.
+    using ActFn = std::function<Action(const Simulator&)>;
+    using StepFn = std::function<void(const Simulator&)>;
+
+    // `sim` must outlive the SimThread and is only touched by its thread
+    // until stop() returns. max_ticks = 0 runs until the episode ends.
+    SimThread(Simulator& sim, ActFn act, StepFn after_step = {}, int speed = 1, int max_ticks = 0);
+    ~SimThread();
+
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    // Clamped to [1, kMaxSpeed]; takes effect from the next tick.
+    void set_speed(int speed);
+    int speed() const { return speed_.load(std::memory_order_relaxed); }
+
+    // Reader side, one thread. Picks up the newest snapshot, if there is one
+    // since the last call, shifting the old current() to previous().
+    bool poll();
+    const RenderSnapshot& previous() const { return previous_; }
+    const RenderSnapshot& current() const { return current_; }
+
+    // True once the episode ended, max_ticks ran or the thread failed.
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+    void rethrow_if_failed() const;
+    uint64_t ticks() const { return ticks_.load(std::memory_order_relaxed); }
+
+    // Joins the thread; the simulator is the caller's again afterwards.
+    void stop();
+
+  private:
+    void run();
+
+    Simulator& sim_;
+    ActFn act_;
+    StepFn after_step_;
+    int max_ticks_;
+    std::atomic<int> speed_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> finished_{false};
+    std::atomic<uint64_t> ticks_{0};
+    std::exception_ptr error_;
+    TripleBuffer<RenderSnapshot> snapshots_;
+    RenderSnapshot previous_;
+    RenderSnapshot current_;
+    std::thread thread_;
+};
+
+} // namespace lv
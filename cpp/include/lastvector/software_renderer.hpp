@@ -0,0 +1,36 @@
+#pragma once
+
+#include "state.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace lv {
+
+// Headless top-down view of a GameState: the same scene as the raylib client
+// (arena border, obstacles, zombies, bullets, player) drawn on the CPU into a
+// packed RGB24 buffer, rows top to bottom. The view is centred on the player
+// and `view_width` world units wide. Shapes are filled one row span at a time;
+// a span is written as one pixel and then doubled with memcpy, so wide fills
+// run as vector copies.
+class SoftwareRenderer {
+  public:
+    // Throws std::invalid_argument unless width, height and view_width are positive.
+    SoftwareRenderer(int width, int height, float view_width = 1280.0f);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    size_t frame_bytes() const { return static_cast<size_t>(width_) * height_ * 3; }
+
+    // `hud` adds health and stamina bars in the top-left corner. Throws
+    // std::invalid_argument unless out.size() == frame_bytes().
+    void render(const GameState& state, std::span<uint8_t> out, bool hud = true) const;
+
+  private:
+    int width_;
+    int height_;
+    float scale_; // pixels per world unit
+};
+
+} // namespace lv
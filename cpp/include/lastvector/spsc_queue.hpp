@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace lv {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Indices grow without wrapping (size_t will not overflow in
+// practice) and each lives on its own cache line so the two sides do not
+// false-share.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+    // Producer. Returns false, leaving `value` untouched, when the queue is full.
+    bool try_push(T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+        slots_[tail & (Capacity - 1)] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer.
+    std::optional<T> try_pop() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return std::nullopt;
+        std::optional<T> value(std::move(slots_[head & (Capacity - 1)]));
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+  private:
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::array<T, Capacity> slots_{};
+};
+
+} // namespace lv
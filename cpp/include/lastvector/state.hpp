@@ -30,6 +30,7 @@ struct Player {
 };
 
 struct Zombie {
+    uint32_t id = 0; // spawn sequence number; the stable ordering key for hit resolution
     Vec2 pos{};
     Vec2 vel{};
     float hp = 30.0f;
@@ -43,6 +44,7 @@ struct Bullet {
     float radius = 4.0f;
     float damage = 22.0f;
     int pierce = 0;
+    uint64_t expire_tick = 0; // tick on which the bullet reaches an obstacle (UINT64_MAX if none)
 };
 
 struct Obstacle {
@@ -66,6 +68,7 @@ struct GameState {
     float episode_time_s = 0.0f;
     PlayState play_state = PlayState::Playing;
     float difficulty_scalar = 0.0f;
+    Vec2 arena_size{kArenaWidth, kArenaHeight};
 
     Player player{};
     std::vector<Zombie> zombies;
@@ -79,6 +82,7 @@ struct GameState {
         UpgradeId::PiercingRounds,
     };
 
+    uint32_t next_zombie_id = 0;
     float spawn_budget = 0.0f;
     float upgrade_clock = 0.0f;
 
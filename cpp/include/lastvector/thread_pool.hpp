@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lv {
+
+// Fixed set of worker threads for data-parallel loops. parallel_for always
+// splits the range the same way for a given thread count, and callers must not
+// let results depend on which thread ran a chunk.
+class ThreadPool {
+  public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Runs fn(begin, end) over one contiguous chunk of [0, count) per thread
+    // (one item each on min(count, size()) threads when count < size()) and
+    // blocks until all chunks are done. The calling thread takes the first chunk.
+    void parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn);
+
+    // Runs fn(i, thread) for every i in [0, count) and blocks until all are
+    // done, for items of very uneven cost. Each thread starts on its own
+    // contiguous chunk, taking items from the front; a thread that runs dry
+    // steals the back half of the largest chunk left. `thread` is in
+    // [0, size()). Which thread runs an item is not deterministic.
+    void parallel_for_each(size_t count, const std::function<void(size_t, int)>& fn);
+
+  private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t, size_t)>* job_ = nullptr;
+    size_t job_count_ = 0;
+    uint64_t generation_ = 0;
+    int pending_ = 0;
+    bool stop_ = false;
+
+    void worker_loop(int chunk);
+    std::pair<size_t, size_t> chunk_range(int chunk) const;
+};
+
+} // namespace lv
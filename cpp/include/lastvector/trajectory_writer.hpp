@@ -0,0 +1,114 @@
+#pragma once
+
+#include "action.hpp"
+#include "env_api.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lv {
+
+// The StepInfo::scalars recorded by default, in column order.
+std::vector<std::string> default_trajectory_metrics();
+
+struct TrajectorySpec {
+    int obs_dim = 0;
+    std::vector<std::string> metrics = default_trajectory_metrics();
+    uint64_t shard_rows = uint64_t{1} << 20; // rows per shard file
+    uint64_t grow_rows = uint64_t{1} << 14;  // shard files grow by this many rows at a time
+    std::chrono::milliseconds flush_interval{1000};
+};
+
+// One transition: the observation before the step, the action stepped and
+// what the step returned. The next observation is the following row with the
+// same (env, seed).
+struct TrajectoryRow {
+    uint64_t seed = 0;
+    uint32_t env = 0;  // stream id, e.g. the vector env index or sweep thread
+    uint32_t step = 0; // steps since reset
+    std::span<const float> obs;
+    Action action{};
+    float reward = 0.0f;
+    bool terminated = false;
+    bool truncated = false;
+    std::span<const float> metrics; // spec.metrics.size() values; empty = NaN
+};
+
+// Streams transitions into DIR/shard_000000.npy, shard_000001.npy, ... Each
+// shard is a .npy file holding one structured array of fixed-stride records:
+//   obs f4[obs_dim], action f4[8], metrics f4[M] (omitted when M = 0),
+//   reward f4, seed u8, env u4, step u4, terminated b1, truncated b1, 2 pad
+// so np.load(path, mmap_mode="r") maps it without parsing and
+// shard["obs"] is a zero-copy view. Shards are mapped MAP_SHARED over their
+// whole capacity up front and the file grows in grow_rows steps, so appending
+// is a memcpy. A background thread msyncs new rows every flush_interval and
+// then updates each .npy header's row count and DIR/index.json (shard files,
+// row counts, metric names), so a reader only ever sees complete rows. close()
+// trims the last shard to its rows. append() is thread-safe: several
+// simulators may stream into one writer. Errors (including those of the
+// flush thread, reported by the next call) are std::runtime_error.
+class TrajectoryWriter {
+  public:
+    // Creates DIR if needed. Throws std::invalid_argument for a bad spec and
+    // std::runtime_error if DIR already holds a dataset.
+    TrajectoryWriter(const std::string& dir, TrajectorySpec spec);
+    // Closes if close() was not called, ignoring errors.
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    void append(const TrajectoryRow& row);
+    // The row for `result`, the step taken from `obs` with `action`; metrics
+    // come from result.info.scalars.
+    void append(uint64_t seed, uint32_t env, uint32_t step, std::span<const float> obs, const Action& action,
+                const StepResult& result);
+
+    // Makes every appended row durable and visible to readers now.
+    void flush();
+    void close();
+
+    const TrajectorySpec& spec() const { return spec_; }
+    size_t row_bytes() const { return row_bytes_; }
+    uint64_t rows() const;
+
+  private:
+    struct Shard;
+
+    void check_open() const;
+    Shard& writable_shard();
+    void flush_loop();
+    // Syncs rows written so far and publishes them; `final` also trims and
+    // unmaps the last shard.
+    void sync(bool final);
+    void write_index(bool complete) const;
+
+    std::string dir_;
+    TrajectorySpec spec_;
+    size_t row_bytes_;
+    std::string descr_;
+    size_t header_bytes_;
+    std::vector<float> nan_metrics_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    uint64_t rows_ = 0;
+    bool closed_ = false;
+
+    std::mutex sync_mutex_; // one sync() at a time
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::exception_ptr flush_error_;
+    std::thread flusher_;
+};
+
+} // namespace lv
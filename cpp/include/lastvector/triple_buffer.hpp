@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace lv {
+
+// Latest-value handoff from one writer thread to one reader thread without
+// locks or waiting. The writer fills back() and publish()es it; the reader
+// calls acquire() and reads front(). Each side owns one of the three buffers
+// and they trade through the third, so neither ever sees a buffer the other is
+// touching. Values the reader did not get to in time are overwritten.
+template <typename T>
+class TripleBuffer {
+  public:
+    // Writer.
+    T& back() { return buffers_[back_]; }
+    void publish() { back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndex; }
+
+    // Reader. Returns true when front() changed to a newer value.
+    bool acquire() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+    const T& front() const { return buffers_[front_]; }
+
+  private:
+    static constexpr uint8_t kIndex = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<T, 3> buffers_{};
+    std::atomic<uint8_t> middle_{1};
+    uint8_t back_ = 0;  // writer only
+    uint8_t front_ = 2; // reader only
+};
+
+} // namespace lv
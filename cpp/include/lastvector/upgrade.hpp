@@ -33,5 +33,7 @@ struct UpgradeState {
 
 std::vector<UpgradeDef> build_upgrade_catalog();
 void apply_upgrade(UpgradeState& state, UpgradeId id);
+// Damage radius around the player at the given Ring of Fire level (> 0).
+float ring_of_fire_radius(int level);
 
 } // namespace lv
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "state.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lv {
+
+constexpr float kZombieRayGridCellSize = 96.0f;
+
+// Uniform grid of zombie positions for the observation rays. Each zombie is
+// stored in every cell its (slightly padded) circle bounds touch, so any point
+// of a zombie circle lies in a cell that lists it. cast() walks each ray
+// through the grid with a 2D DDA and stops once the closest hit so far lies
+// before the far edge of the current cell; cost scales with the ray length in
+// cells instead of the zombie count. Hit distances use the same arithmetic as
+// BasicZombieSweep::add, so they match the brute-force test bit for bit.
+class ZombieRayGrid {
+  public:
+    explicit ZombieRayGrid(float cell_size);
+
+    void build(const std::vector<Zombie>& zombies, Vec2 arena_size);
+
+    // Lowers ray_t[i] to the first zombie hit along dirs[i] from `origin`.
+    // Assumes `origin` is outside every zombie (the caller handles contact).
+    void cast(Vec2 origin, std::span<const Vec2> dirs, std::span<float> ray_t) const;
+
+  private:
+    struct CellRange {
+        int x0, x1, y0, y1;
+    };
+
+    float cell_size_;
+    float inv_cell_size_;
+    int cols_ = 0;
+    int rows_ = 0;
+    std::vector<uint32_t> cell_start_; // CSR offsets, cols_ * rows_ + 1 entries
+    std::vector<Vec2> cell_zombies_;   // zombie positions grouped by cell
+    std::vector<uint32_t> fill_;
+
+    float cast_one(Vec2 origin, Vec2 dir, float t_best) const;
+};
+
+} // namespace lv
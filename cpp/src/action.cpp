@@ -0,0 +1,30 @@
+#include "lastvector/action.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lv {
+
+Action decode_action(std::span<const float, kActionValues> values) {
+    const auto axis = [](float v) { return std::isfinite(v) ? std::clamp(v, -1.0f, 1.0f) : 0.0f; };
+    // NaN compares false, so it leaves a button released.
+    const auto button = [](float v) { return v >= 0.5f; };
+
+    Action action{};
+    action.move_x = axis(values[0]);
+    action.move_y = axis(values[1]);
+    action.aim_x = axis(values[2]);
+    action.aim_y = axis(values[3]);
+    action.shoot = button(values[4]);
+    action.sprint = button(values[5]);
+    action.reload = button(values[6]);
+
+    const float choice = values[7];
+    if (std::isfinite(choice) && choice >= -0.5f) {
+        // Clamped before rounding, so an overshooting 2.7 still picks the third upgrade.
+        action.upgrade_choice = static_cast<int>(std::round(std::clamp(choice, 0.0f, 2.0f)));
+    }
+    return action;
+}
+
+} // namespace lv
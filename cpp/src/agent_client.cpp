@@ -0,0 +1,416 @@
+#include "lastvector/agent_client.hpp"
+#include "lastvector/agent_protocol.hpp"
+#include "lastvector/shm_mailbox.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace lv {
+
+namespace {
+
+int connect_tcp_or_throw(const std::string& host, uint16_t port) {
+    struct addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* result = nullptr;
+    const std::string port_str = std::to_string(port);
+    const int rv = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result);
+    if (rv != 0) {
+        throw std::runtime_error("getaddrinfo failed: " + std::string(gai_strerror(rv)));
+    }
+
+    int fd = -1;
+    for (auto* rp = result; rp != nullptr; rp = rp->ai_next) {
+        const int candidate = ::socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        if (candidate < 0) {
+            continue;
+        }
+        if (::connect(candidate, rp->ai_addr, rp->ai_addrlen) == 0) {
+            fd = candidate;
+            break;
+        }
+        ::close(candidate);
+    }
+
+    ::freeaddrinfo(result);
+
+    if (fd < 0) {
+        throw std::runtime_error("unable to connect to agent at " + host + ":" + std::to_string(port));
+    }
+
+    // One small request and reply per tick: never wait for Nagle coalescing.
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int connect_unix_or_throw(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("unix socket path must be 1-" + std::to_string(sizeof(addr.sun_path) - 1) +
+                                 " characters: '" + path + "'");
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("socket() failed: " + std::string(std::strerror(errno)));
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error("unable to connect to agent at unix:" + path + ": " + std::strerror(err));
+    }
+    return fd;
+}
+
+class SocketAgentClient final : public AgentClient {
+  public:
+    // Takes ownership of a connected stream socket.
+    SocketAgentClient(int fd, bool allow_binary, int max_chunk)
+        : fd_(fd), allow_binary_(allow_binary), max_chunk_(max_chunk) {}
+    ~SocketAgentClient() override { ::close(fd_); }
+    SocketAgentClient(const SocketAgentClient&) = delete;
+    SocketAgentClient& operator=(const SocketAgentClient&) = delete;
+
+    std::string handshake_or_throw() override {
+        std::string hello = "{\"type\":\"hello\"";
+        if (allow_binary_) {
+            hello += std::string(",\"protocols\":[\"") + kAgentBinaryProtocolName + "\",\"json\"]";
+        }
+        if (max_chunk_ > 1) {
+            hello += ",\"max_chunk\":" + std::to_string(max_chunk_);
+        }
+        send_line_or_throw(hello + "}\n");
+        const std::string line = recv_line_or_throw();
+        binary_ = allow_binary_ && extract_json_string_field(line, "protocol") == kAgentBinaryProtocolName;
+        const std::string model = extract_json_string_field(line, "model");
+        if (model.empty()) {
+            return "unknown";
+        }
+        return model;
+    }
+
+    const char* protocol() const override { return binary_ ? kAgentBinaryProtocolName : "json"; }
+
+    // A blocked recv() or send() returns once both directions are shut down;
+    // the descriptor itself stays open until the destructor.
+    void cancel() override { ::shutdown(fd_, SHUT_RDWR); }
+
+    void infer_chunk_or_throw(std::span<const float> obs, std::vector<Action>& out) override {
+        if (!binary_) {
+            send_line_or_throw(build_observation_json(obs));
+            actions_from_agent_values(parse_action_values(recv_line_or_throw()), max_chunk_, out);
+            return;
+        }
+
+        obs_scratch_.resize(obs.size());
+        std::transform(obs.begin(), obs.end(), obs_scratch_.begin(),
+                       [](float v) { return std::isfinite(v) ? v : 0.0f; });
+        encode_agent_frame(AgentFrameKind::Observation, obs_scratch_, frame_);
+        send_all_or_throw(frame_.data(), frame_.size());
+
+        std::array<uint8_t, kAgentFrameHeaderBytes> header{};
+        recv_exact_or_throw(header.data(), header.size());
+        const AgentFrameHeader parsed = decode_agent_frame_header(header);
+        if (parsed.kind != AgentFrameKind::Action ||
+            parsed.count > kAgentActionValues * static_cast<size_t>(max_chunk_)) {
+            throw std::runtime_error("agent reply is not an action frame of at most " + std::to_string(max_chunk_) +
+                                     " actions");
+        }
+        payload_.resize(parsed.count * sizeof(float));
+        recv_exact_or_throw(payload_.data(), payload_.size());
+        values_.resize(parsed.count);
+        decode_agent_frame_values(payload_, values_);
+        actions_from_agent_values(values_, max_chunk_, out);
+    }
+
+  private:
+    void send_line_or_throw(const std::string& payload) { send_all_or_throw(payload.data(), payload.size()); }
+
+    void send_all_or_throw(const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const char*>(data);
+        std::size_t sent = 0;
+        while (sent < size) {
+            const auto n = ::send(fd_, bytes + sent, size - sent, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("send() failed: " + std::string(std::strerror(errno)));
+            }
+            if (n == 0) {
+                throw std::runtime_error("send() returned 0 bytes");
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+    }
+
+    // Binary frames are read straight into `dst`, after whatever the line
+    // reader had already buffered.
+    void recv_exact_or_throw(uint8_t* dst, std::size_t size) {
+        const std::size_t buffered = std::min(size, recv_buffer_.size());
+        std::memcpy(dst, recv_buffer_.data(), buffered);
+        recv_buffer_.erase(0, buffered);
+        std::size_t got = buffered;
+        while (got < size) {
+            const auto n = ::recv(fd_, dst + got, size - got, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("recv() failed: " + std::string(std::strerror(errno)));
+            }
+            if (n == 0) {
+                throw std::runtime_error("agent disconnected");
+            }
+            got += static_cast<std::size_t>(n);
+        }
+    }
+
+    std::string recv_line_or_throw() {
+        while (true) {
+            const auto newline_pos = recv_buffer_.find('\n');
+            if (newline_pos != std::string::npos) {
+                std::string line = recv_buffer_.substr(0, newline_pos);
+                recv_buffer_.erase(0, newline_pos + 1);
+                return line;
+            }
+
+            char chunk[2048];
+            const auto n = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("recv() failed: " + std::string(std::strerror(errno)));
+            }
+            if (n == 0) {
+                throw std::runtime_error("agent disconnected");
+            }
+            recv_buffer_.append(chunk, static_cast<std::size_t>(n));
+            if (recv_buffer_.size() > 1U << 20U) {
+                throw std::runtime_error("incoming message too large");
+            }
+        }
+    }
+
+    static std::string build_observation_json(std::span<const float> obs) {
+        std::ostringstream oss;
+        oss.precision(7);
+        oss << "{\"obs\":[";
+        for (std::size_t i = 0; i < obs.size(); ++i) {
+            if (i > 0) {
+                oss << ',';
+            }
+            const float value = std::isfinite(obs[i]) ? obs[i] : 0.0f;
+            oss << value;
+        }
+        oss << "]}\n";
+        return oss.str();
+    }
+
+    static std::vector<float> parse_action_values(const std::string& json) {
+        const std::size_t key_pos = json.find("\"action\"");
+        if (key_pos == std::string::npos) {
+            throw std::runtime_error("agent response missing action field");
+        }
+        const std::size_t open = json.find('[', key_pos);
+        const std::size_t close = (open == std::string::npos) ? std::string::npos : json.find(']', open);
+        if (open == std::string::npos || close == std::string::npos || close <= open) {
+            throw std::runtime_error("agent response has invalid action array");
+        }
+
+        std::vector<float> values;
+        std::size_t cursor = open + 1;
+        while (true) {
+            while (cursor < close && std::isspace(static_cast<unsigned char>(json[cursor]))) {
+                ++cursor;
+            }
+            if (cursor >= close) {
+                throw std::runtime_error("agent action array ended early");
+            }
+
+            char* end_ptr = nullptr;
+            const float parsed = std::strtof(json.c_str() + cursor, &end_ptr);
+            if (end_ptr == json.c_str() + cursor || !std::isfinite(parsed)) {
+                throw std::runtime_error("agent action contains non-numeric entry");
+            }
+            values.push_back(parsed);
+            cursor = static_cast<std::size_t>(end_ptr - json.c_str());
+
+            while (cursor < close && std::isspace(static_cast<unsigned char>(json[cursor]))) {
+                ++cursor;
+            }
+            if (cursor >= close) {
+                break;
+            }
+            if (json[cursor] != ',') {
+                throw std::runtime_error("agent action array missing comma separator");
+            }
+            ++cursor;
+        }
+        return values;
+    }
+
+    static std::string extract_json_string_field(const std::string& json, std::string_view field) {
+        std::string quoted_key;
+        quoted_key.reserve(field.size() + 2);
+        quoted_key.append(1, '"').append(field).append(1, '"');
+        const std::size_t key_pos = json.find(quoted_key);
+        if (key_pos == std::string::npos) {
+            return {};
+        }
+        const std::size_t colon_pos = json.find(':', key_pos + quoted_key.size());
+        if (colon_pos == std::string::npos) {
+            return {};
+        }
+        const std::size_t q1 = json.find('"', colon_pos + 1);
+        if (q1 == std::string::npos) {
+            return {};
+        }
+        const std::size_t q2 = json.find('"', q1 + 1);
+        if (q2 == std::string::npos || q2 <= q1 + 1) {
+            return {};
+        }
+        return json.substr(q1 + 1, q2 - q1 - 1);
+    }
+
+    int fd_ = -1;
+    bool allow_binary_ = true;
+    int max_chunk_ = 1;
+    bool binary_ = false;
+    std::string recv_buffer_;
+    std::vector<float> obs_scratch_;
+    std::vector<uint8_t> frame_;
+    std::vector<uint8_t> payload_;
+    std::vector<float> values_;
+};
+
+class ShmAgentClient final : public AgentClient {
+  public:
+    // The mailbox has no hello, so max_chunk only bounds what the server may
+    // send; agent_server.py answers shm requests with one action.
+    ShmAgentClient(const std::string& name, int max_chunk)
+        : mailbox_(name, ShmMailboxRole::Client), max_chunk_(max_chunk) {}
+
+    std::string handshake_or_throw() override { return mailbox_.model().empty() ? "unknown" : mailbox_.model(); }
+    const char* protocol() const override { return kAgentBinaryProtocolName; }
+    void cancel() override { mailbox_.cancel(); }
+
+    void infer_chunk_or_throw(std::span<const float> obs, std::vector<Action>& out) override {
+        obs_scratch_.resize(obs.size());
+        std::transform(obs.begin(), obs.end(), obs_scratch_.begin(),
+                       [](float v) { return std::isfinite(v) ? v : 0.0f; });
+        encode_agent_frame(AgentFrameKind::Observation, obs_scratch_, frame_);
+        mailbox_.post_request(frame_);
+
+        const std::span<const uint8_t> reply = mailbox_.wait_response();
+        const AgentFrameHeader parsed = decode_agent_frame_header(reply.first<kAgentFrameHeaderBytes>());
+        if (parsed.kind != AgentFrameKind::Action ||
+            parsed.count > kAgentActionValues * static_cast<size_t>(max_chunk_)) {
+            throw std::runtime_error("agent reply is not an action frame of at most " + std::to_string(max_chunk_) +
+                                     " actions");
+        }
+        values_.resize(parsed.count);
+        decode_agent_frame_values(reply.subspan(kAgentFrameHeaderBytes), values_);
+        actions_from_agent_values(values_, max_chunk_, out);
+    }
+
+  private:
+    ShmMailbox mailbox_;
+    int max_chunk_;
+    std::vector<float> values_;
+    std::vector<float> obs_scratch_;
+    std::vector<uint8_t> frame_;
+};
+
+} // namespace
+
+Action AgentClient::infer_or_throw(std::span<const float> obs) {
+    std::vector<Action> actions;
+    infer_chunk_or_throw(obs, actions);
+    return actions.front();
+}
+
+std::string AgentEndpoint::describe() const {
+    switch (transport) {
+    case AgentTransport::Tcp:
+        return host + ":" + std::to_string(port);
+    case AgentTransport::Unix:
+        return "unix:" + path;
+    case AgentTransport::Shm:
+        return "shm:" + path;
+    }
+    return {};
+}
+
+std::optional<AgentEndpoint> parse_agent_endpoint(const std::string& text) {
+    for (const auto& [prefix, transport] : {std::pair{std::string_view("unix:"), AgentTransport::Unix},
+                                            std::pair{std::string_view("shm:"), AgentTransport::Shm}}) {
+        if (text.starts_with(prefix)) {
+            if (text.size() == prefix.size()) return std::nullopt;
+            AgentEndpoint endpoint;
+            endpoint.transport = transport;
+            endpoint.path = text.substr(prefix.size());
+            return endpoint;
+        }
+    }
+
+    const auto colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= text.size()) {
+        return std::nullopt;
+    }
+    const std::string host = text.substr(0, colon);
+    const std::string port_text = text.substr(colon + 1);
+    try {
+        const long port = std::stol(port_text);
+        if (port <= 0 || port > 65535) {
+            return std::nullopt;
+        }
+        AgentEndpoint endpoint;
+        endpoint.host = host;
+        endpoint.port = static_cast<uint16_t>(port);
+        return endpoint;
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+std::unique_ptr<AgentClient> connect_agent(const AgentEndpoint& endpoint, bool allow_binary, int max_chunk) {
+    if (max_chunk < 1 || max_chunk > kAgentMaxActionChunk) {
+        throw std::invalid_argument("agent max_chunk must be in [1, " + std::to_string(kAgentMaxActionChunk) + "]");
+    }
+    switch (endpoint.transport) {
+    case AgentTransport::Tcp:
+        return std::make_unique<SocketAgentClient>(connect_tcp_or_throw(endpoint.host, endpoint.port), allow_binary,
+                                                   max_chunk);
+    case AgentTransport::Unix:
+        return std::make_unique<SocketAgentClient>(connect_unix_or_throw(endpoint.path), allow_binary, max_chunk);
+    case AgentTransport::Shm:
+        return std::make_unique<ShmAgentClient>(endpoint.path, max_chunk);
+    }
+    throw std::runtime_error("unknown agent transport");
+}
+
+} // namespace lv
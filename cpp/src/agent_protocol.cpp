@@ -0,0 +1,91 @@
+#include "lastvector/agent_protocol.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace lv {
+
+namespace {
+
+void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+uint32_t get_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+} // namespace
+
+void encode_agent_frame(AgentFrameKind kind, std::span<const float> values, std::vector<uint8_t>& out) {
+    if (values.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument("agent frame holds at most 65535 values, got " + std::to_string(values.size()));
+    }
+    const auto count = static_cast<uint16_t>(values.size());
+    out.resize(kAgentFrameHeaderBytes + values.size() * sizeof(float));
+    uint8_t* p = out.data();
+    put_u32(p, static_cast<uint32_t>(4 + values.size() * sizeof(float)));
+    p[4] = kAgentProtocolVersion;
+    p[5] = static_cast<uint8_t>(kind);
+    p[6] = static_cast<uint8_t>(count);
+    p[7] = static_cast<uint8_t>(count >> 8);
+
+    uint8_t* dst = p + kAgentFrameHeaderBytes;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(dst, values.data(), values.size() * sizeof(float));
+    } else {
+        for (size_t i = 0; i < values.size(); ++i) put_u32(dst + 4 * i, std::bit_cast<uint32_t>(values[i]));
+    }
+}
+
+AgentFrameHeader decode_agent_frame_header(std::span<const uint8_t, kAgentFrameHeaderBytes> bytes) {
+    const uint32_t length = get_u32(bytes.data());
+    const uint8_t version = bytes[4];
+    const uint8_t kind = bytes[5];
+    const auto count = static_cast<uint16_t>(bytes[6] | bytes[7] << 8);
+    if (version != kAgentProtocolVersion) {
+        throw std::runtime_error("agent frame has protocol version " + std::to_string(version) + ", expected " +
+                                 std::to_string(kAgentProtocolVersion));
+    }
+    if (kind != static_cast<uint8_t>(AgentFrameKind::Observation) && kind != static_cast<uint8_t>(AgentFrameKind::Action)) {
+        throw std::runtime_error("agent frame has unknown kind " + std::to_string(kind));
+    }
+    if (length != 4 + static_cast<uint32_t>(count) * sizeof(float)) {
+        throw std::runtime_error("agent frame length " + std::to_string(length) + " does not match " +
+                                 std::to_string(count) + " values");
+    }
+    return {static_cast<AgentFrameKind>(kind), count};
+}
+
+void decode_agent_frame_values(std::span<const uint8_t> payload, std::span<float> out) {
+    if (payload.size() != out.size() * sizeof(float)) {
+        throw std::runtime_error("agent frame payload has " + std::to_string(payload.size()) + " bytes, expected " +
+                                 std::to_string(out.size() * sizeof(float)));
+    }
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out.data(), payload.data(), payload.size());
+    } else {
+        for (size_t i = 0; i < out.size(); ++i) out[i] = std::bit_cast<float>(get_u32(payload.data() + 4 * i));
+    }
+}
+
+void actions_from_agent_values(std::span<const float> values, int max_chunk, std::vector<Action>& out) {
+    const size_t n = values.size() / kAgentActionValues;
+    if (values.size() % kAgentActionValues != 0 || n < 1 || n > static_cast<size_t>(max_chunk)) {
+        throw std::runtime_error("agent reply has " + std::to_string(values.size()) + " values, expected 8 * n for 1 <= n <= " +
+                                 std::to_string(max_chunk));
+    }
+    out.resize(n);
+    for (size_t i = 0; i < n; ++i) out[i] = decode_action(values.subspan(i * kAgentActionValues).first<kAgentActionValues>());
+}
+
+} // namespace lv
@@ -0,0 +1,96 @@
+#include "lastvector/async_agent.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace lv {
+
+AsyncAgent::AsyncAgent(std::unique_ptr<AgentClient> client, std::chrono::microseconds deadline)
+    : client_(std::move(client)), deadline_(deadline) {
+    if (!client_) throw std::invalid_argument("AsyncAgent needs a client");
+    if (deadline_.count() < 0) throw std::invalid_argument("AsyncAgent deadline must be >= 0");
+    io_thread_ = std::thread([this] { io_loop(); });
+}
+
+AsyncAgent::~AsyncAgent() {
+    stop_.store(true, std::memory_order_release);
+    wakeups_.fetch_add(1, std::memory_order_release);
+    wakeups_.notify_one();
+    client_->cancel();
+    io_thread_.join();
+}
+
+void AsyncAgent::send(std::vector<float> obs) {
+    Request request{tick_, std::move(obs)};
+    // Only one request is ever outstanding, so the queue has room.
+    if (!requests_.try_push(request)) throw std::logic_error("AsyncAgent request queue is full");
+    wakeups_.fetch_add(1, std::memory_order_release);
+    wakeups_.notify_one();
+    in_flight_ = true;
+    queries_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncAgent::await_reply() {
+    const auto deadline = std::chrono::steady_clock::now() + deadline_;
+    int spins = 0;
+    while (true) {
+        if (auto reply = replies_.try_pop()) {
+            take_reply(*reply);
+            return;
+        }
+        rethrow_if_failed();
+        if (std::chrono::steady_clock::now() >= deadline) return;
+        // Replies usually land within tens of microseconds; yield for those,
+        // then sleep in short steps so a slow agent does not burn a core.
+        if (++spins < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+void AsyncAgent::take_reply(Reply& reply) {
+    in_flight_ = false;
+    if (reply.actions.empty()) return;
+    // The reply's first action was meant for reply.tick; the ones for ticks
+    // that already ran with the fallback are stale.
+    const uint64_t behind = tick_ - reply.tick;
+    if (behind > 0) late_.fetch_add(1, std::memory_order_relaxed);
+    if (behind < reply.actions.size()) {
+        chunk_ = std::move(reply.actions);
+        chunk_pos_ = static_cast<size_t>(behind);
+    } else {
+        last_action_ = reply.actions.back();
+        chunk_.clear();
+        chunk_pos_ = 0;
+    }
+}
+
+void AsyncAgent::rethrow_if_failed() {
+    if (failed_.load(std::memory_order_acquire)) std::rethrow_exception(error_);
+}
+
+void AsyncAgent::io_loop() {
+    while (true) {
+        const uint32_t seen = wakeups_.load(std::memory_order_acquire);
+        if (stop_.load(std::memory_order_acquire)) return;
+        std::optional<Request> request = requests_.try_pop();
+        if (!request) {
+            wakeups_.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        Reply reply{request->tick, {}};
+        try {
+            client_->infer_chunk_or_throw(request->obs, reply.actions);
+        } catch (...) {
+            error_ = std::current_exception();
+            failed_.store(true, std::memory_order_release);
+            return;
+        }
+        replies_.try_push(reply);
+    }
+}
+
+} // namespace lv
@@ -0,0 +1,651 @@
+#include "lastvector/agent_client.hpp"
+#include "lastvector/agent_protocol.hpp"
+#include "lastvector/async_agent.hpp"
+#include "lastvector/collision.hpp"
+#include "lastvector/mlp_policy.hpp"
+#include "lastvector/config.hpp"
+#include "lastvector/observation.hpp"
+#include "lastvector/obstacle_field.hpp"
+#include "lastvector/occupancy_grid.hpp"
+#include "lastvector/rng.hpp"
+#include "lastvector/separation.hpp"
+#include "lastvector/shm_mailbox.hpp"
+#include "lastvector/sim.hpp"
+#include "lastvector/software_renderer.hpp"
+#include "lastvector/state.hpp"
+#include "lastvector/thread_pool.hpp"
+#include "lastvector/zombie_ray_grid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+struct BenchOptions {
+    int ticks = 600;
+    std::string filter;
+};
+
+// A horde scattered around the player in spawn (i.e. spatially random) order.
+// density 1 packs it as tightly as separation allows.
+std::vector<lv::Zombie> make_horde(int count, uint64_t seed, float density = 1.0f) {
+    lv::DeterministicRng rng(seed);
+    const float spread = 14.0f * std::sqrt(static_cast<float>(count) / density);
+    std::vector<lv::Zombie> zombies(static_cast<size_t>(count));
+    uint32_t next_id = 0;
+    for (auto& z : zombies) {
+        z.id = next_id++;
+        const float angle = rng.uniform(0.0f, 6.28318530718f);
+        const float dist = spread * std::sqrt(rng.uniform(0.0f, 1.0f));
+        z.pos = {lv::kPlayerSpawnX + std::cos(angle) * dist, lv::kPlayerSpawnY + std::sin(angle) * dist};
+    }
+    return zombies;
+}
+
+void chase_player(std::vector<lv::Zombie>& zombies, lv::Vec2 player) {
+    for (auto& z : zombies) {
+        const float dx = player.x - z.pos.x;
+        const float dy = player.y - z.pos.y;
+        const float l = std::sqrt(dx * dx + dy * dy);
+        if (l <= 1e-6f) continue;
+        z.pos.x += dx / l * 155.0f * lv::kFixedDt;
+        z.pos.y += dy / l * 155.0f * lv::kFixedDt;
+    }
+}
+
+struct SeparationRun {
+    double ns_per_tick = 0.0;
+    uint64_t rebuilds = 0;
+    std::vector<lv::Zombie> zombies;
+};
+
+struct SeparationSetup {
+    lv::NeighborSearch search = lv::NeighborSearch::VerletList;
+    lv::SeparationSolver solver = lv::SeparationSolver::GaussSeidel;
+    int threads = 1;
+    int reorder_interval = 0;
+    float density = 1.0f;
+};
+
+SeparationRun run_separation(int count, int ticks, const SeparationSetup& setup) {
+    SeparationRun run;
+    run.zombies = make_horde(count, 7, setup.density);
+    lv::Vec2 player{lv::kPlayerSpawnX, lv::kPlayerSpawnY};
+    lv::ZombieNeighborList neighbors(lv::kZombieSeparationRadius, lv::kZombieNeighborSkin);
+    std::unique_ptr<lv::ThreadPool> pool;
+    if (setup.threads > 1) pool = std::make_unique<lv::ThreadPool>(setup.threads);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        if (setup.reorder_interval > 0 && t % setup.reorder_interval == 0) {
+            lv::sort_zombies_by_morton(run.zombies);
+            neighbors.invalidate();
+        }
+        chase_player(run.zombies, player);
+        lv::separate_zombies(run.zombies, player, {lv::kArenaWidth, lv::kArenaHeight}, setup.search, neighbors, setup.solver, pool.get());
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+
+    run.ns_per_tick = std::chrono::duration<double, std::nano>(t1 - t0).count() / ticks;
+    run.rebuilds = neighbors.rebuild_count();
+    return run;
+}
+
+bool same_positions(const std::vector<lv::Zombie>& a, const std::vector<lv::Zombie>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::memcmp(&a[i].pos, &b[i].pos, sizeof(lv::Vec2)) != 0) return false;
+    }
+    return true;
+}
+
+void bench_separation(const BenchOptions& opts) {
+    for (const int count : {16, 32, 64, 128, 256, 1024}) {
+        const auto brute = run_separation(count, opts.ticks, {.search = lv::NeighborSearch::BruteForce});
+        const auto verlet = run_separation(count, opts.ticks, {.search = lv::NeighborSearch::VerletList});
+        std::cout << "separation zombies=" << std::setw(5) << count << std::fixed << std::setprecision(1)
+                  << "  brute_ns/tick=" << std::setw(11) << brute.ns_per_tick
+                  << "  verlet_ns/tick=" << std::setw(10) << verlet.ns_per_tick
+                  << "  speedup=" << std::setprecision(2) << brute.ns_per_tick / verlet.ns_per_tick
+                  << "  rebuilds=" << verlet.rebuilds
+                  << "  identical=" << (same_positions(brute.zombies, verlet.zombies) ? "yes" : "no") << '\n';
+    }
+}
+
+// Spawn order is spatially random; compare against periodic Morton re-sorting.
+void bench_morton(const BenchOptions& opts) {
+    constexpr float kDensity = 0.15f;
+    for (const int count : {1024, 4096, 8192}) {
+        const auto spawn_order = run_separation(count, opts.ticks, {.density = kDensity});
+        const auto morton = run_separation(
+            count, opts.ticks, {.reorder_interval = lv::kZombieReorderIntervalTicks, .density = kDensity});
+        std::cout << "morton     zombies=" << std::setw(5) << count << std::fixed << std::setprecision(1)
+                  << "  spawn_order_ns/tick=" << std::setw(11) << spawn_order.ns_per_tick
+                  << "  morton_ns/tick=" << std::setw(11) << morton.ns_per_tick
+                  << "  speedup=" << std::setprecision(2) << spawn_order.ns_per_tick / morton.ns_per_tick << '\n';
+    }
+}
+
+// Jacobi separation across thread counts; positions must match the 1-thread run bit for bit.
+void bench_jacobi(const BenchOptions& opts) {
+    std::vector<int> thread_counts = {1, 2, 4, 8};
+    const int hw_threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (hw_threads > thread_counts.back()) thread_counts.push_back(hw_threads);
+    for (const int count : {1024, 4096}) {
+        const auto gauss_seidel = run_separation(count, opts.ticks, {.density = 0.3f});
+        std::cout << "jacobi     zombies=" << std::setw(5) << count << std::fixed << std::setprecision(1)
+                  << "  gauss_seidel_ns/tick=" << gauss_seidel.ns_per_tick << '\n';
+
+        SeparationRun reference;
+        for (const int threads : thread_counts) {
+            auto run = run_separation(count, opts.ticks,
+                                      {.solver = lv::SeparationSolver::Jacobi, .threads = threads, .density = 0.3f});
+            if (threads == 1) reference = run;
+            std::cout << "jacobi     zombies=" << std::setw(5) << count << "  threads=" << std::setw(2) << threads
+                      << std::setprecision(1) << "  ns/tick=" << std::setw(11) << run.ns_per_tick
+                      << "  identical_to_1_thread=" << (same_positions(reference.zombies, run.zombies) ? "yes" : "no")
+                      << '\n';
+        }
+    }
+}
+
+// Observation-ray zombie hits (the nearest-k part of the sweep is shared and not
+// timed): every zombie against every ray versus building the grid and walking
+// it. Distances must match bit for bit.
+template <int NRays>
+void bench_zombie_rays_layout(const BenchOptions& opts) {
+    using Sweep = lv::BasicZombieSweep<lv::kZombieObsCount, NRays>;
+    const lv::Vec2 player{lv::kPlayerSpawnX, lv::kPlayerSpawnY};
+    const lv::Vec2 arena{lv::kArenaWidth, lv::kArenaHeight};
+    for (const int count : {16, 32, 64, 128, 256, 1024, 4096}) {
+        auto zombies = make_horde(count, 11, 0.05f);
+        lv::ZombieRayGrid grid(lv::kZombieRayGridCellSize);
+        lv::ZombieNeighborList neighbors(lv::kZombieSeparationRadius, lv::kZombieNeighborSkin);
+        double brute_ns = 0.0;
+        double grid_ns = 0.0;
+        bool identical = true;
+        for (int t = 0; t < opts.ticks; ++t) {
+            lv::Vec2 pushed_player = player;
+            chase_player(zombies, player);
+            lv::separate_zombies(zombies, pushed_player, arena, lv::NeighborSearch::VerletList, neighbors);
+            for (auto& z : zombies) lv::sanitize_position(z.pos, player, lv::kZombieRadius, arena);
+            // Zombies touching the player zero every ray; keep them out so both paths do real work.
+            const size_t erased = std::erase_if(zombies, [&](const lv::Zombie& z) {
+                const float dx = z.pos.x - player.x;
+                const float dy = z.pos.y - player.y;
+                return dx * dx + dy * dy <= 4.0f * lv::kZombieRadius * lv::kZombieRadius;
+            });
+            if (erased > 0) neighbors.invalidate();
+
+            auto t0 = std::chrono::steady_clock::now();
+            Sweep brute;
+            for (size_t i = 0; i < zombies.size(); ++i) {
+                const float dx = zombies[i].pos.x - player.x;
+                const float dy = zombies[i].pos.y - player.y;
+                brute.add_rays(dx, dy, dx * dx + dy * dy);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            Sweep walked;
+            grid.build(zombies, arena);
+            grid.cast(player, lv::ray_directions<NRays>(), walked.ray_t);
+            auto t2 = std::chrono::steady_clock::now();
+
+            brute_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            grid_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+            identical = identical && std::memcmp(brute.ray_t.data(), walked.ray_t.data(), sizeof(brute.ray_t)) == 0;
+        }
+        std::cout << "zombie_rays rays=" << std::setw(2) << NRays << " zombies=" << std::setw(5) << count << std::fixed
+                  << std::setprecision(1) << "  brute_ns/tick=" << std::setw(10) << brute_ns / opts.ticks
+                  << "  grid_ns/tick=" << std::setw(9) << grid_ns / opts.ticks
+                  << "  speedup=" << std::setprecision(2) << brute_ns / grid_ns
+                  << "  identical=" << (identical ? "yes" : "no") << '\n';
+    }
+}
+
+void bench_zombie_rays(const BenchOptions& opts) {
+    bench_zombie_rays_layout<16>(opts);
+    bench_zombie_rays_layout<64>(opts);
+}
+
+// Obstacle rays and circle pushes: every obstacle versus the static distance
+// field, on the game's layout and on a cluttered arena. Results must match.
+void bench_obstacles(const BenchOptions& opts) {
+    const lv::Vec2 arena{lv::kArenaWidth, lv::kArenaHeight};
+    const lv::Simulator sim;
+    std::vector<lv::Obstacle> clutter;
+    lv::DeterministicRng layout_rng(5);
+    for (int i = 0; i < 240; ++i) {
+        clutter.push_back({layout_rng.uniform(0.0f, arena.x - 120.0f), layout_rng.uniform(0.0f, arena.y - 120.0f),
+                           layout_rng.uniform(20.0f, 120.0f), layout_rng.uniform(20.0f, 120.0f)});
+    }
+
+    const auto& dirs = lv::ray_directions<lv::kRayCount>();
+    const lv::Obstacle bounds{0.0f, 0.0f, arena.x, arena.y};
+    for (const auto& [name, obstacles] : {std::pair{"game", sim.state().obstacles}, std::pair{"clutter", clutter}}) {
+        lv::ObstacleField field;
+        field.build(obstacles, arena, lv::kObstacleFieldCellSize);
+
+        constexpr int kPointsPerTick = 64;
+        lv::DeterministicRng rng(9);
+        double brute_ns = 0.0;
+        double field_ns = 0.0;
+        bool identical = true;
+        for (int t = 0; t < opts.ticks; ++t) {
+            std::vector<lv::Vec2> points(kPointsPerTick);
+            for (auto& p : points) p = {rng.uniform(10.0f, arena.x - 10.0f), rng.uniform(10.0f, arena.y - 10.0f)};
+
+            std::vector<float> brute_t;
+            std::vector<lv::Vec2> brute_pos = points;
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < points.size(); ++i) {
+                for (const lv::Vec2 dir : dirs) {
+                    float hit = lv::ray_intersect_aabb(points[i], dir, bounds);
+                    for (const auto& o : obstacles) hit = std::min(hit, lv::ray_intersect_aabb(points[i], dir, o));
+                    brute_t.push_back(hit);
+                }
+                for (const auto& o : obstacles) lv::circle_vs_aabb_resolve(brute_pos[i], lv::kZombieRadius, o);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            std::vector<float> field_t;
+            std::vector<lv::Vec2> field_pos = points;
+            for (size_t i = 0; i < points.size(); ++i) {
+                for (const lv::Vec2 dir : dirs) {
+                    field_t.push_back(field.raycast(points[i], dir, lv::ray_intersect_aabb(points[i], dir, bounds)));
+                }
+                field.resolve_circle(field_pos[i], lv::kZombieRadius);
+            }
+            auto t2 = std::chrono::steady_clock::now();
+
+            brute_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            field_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+            identical = identical && brute_t == field_t &&
+                        std::memcmp(brute_pos.data(), field_pos.data(), brute_pos.size() * sizeof(lv::Vec2)) == 0;
+        }
+        const double samples = static_cast<double>(opts.ticks) * kPointsPerTick;
+        std::cout << "obstacles  layout=" << std::setw(7) << name << " boxes=" << std::setw(3) << obstacles.size()
+                  << std::fixed << std::setprecision(1) << "  brute_ns/point=" << std::setw(8) << brute_ns / samples
+                  << "  field_ns/point=" << std::setw(7) << field_ns / samples
+                  << "  speedup=" << std::setprecision(2) << brute_ns / field_ns
+                  << "  identical=" << (identical ? "yes" : "no") << '\n';
+    }
+}
+
+// Occupancy grid versus the default vector observation on the same states, as a
+// reference for what one grid costs per step.
+void bench_occupancy(const BenchOptions& opts) {
+    const lv::Simulator sim;
+    lv::OccupancyGrid grid(lv::kOccupancyGridSize, lv::kOccupancyCellSize);
+    grid.build_static(sim.state().obstacles, sim.state().arena_size);
+    std::vector<uint8_t> out(grid.dim());
+
+    for (const int count : {64, 512, 4096}) {
+        lv::GameState state = sim.state();
+        state.zombies = make_horde(count, 11, 0.05f);
+        lv::DeterministicRng rng(13);
+        for (int i = 0; i < 32; ++i) {
+            lv::Bullet b;
+            b.pos = {lv::kPlayerSpawnX + rng.uniform(-500.0f, 500.0f), lv::kPlayerSpawnY + rng.uniform(-500.0f, 500.0f)};
+            state.bullets.push_back(b);
+        }
+        state.upgrades.levels[static_cast<size_t>(lv::UpgradeId::RingOfFire)] = 2;
+
+        double grid_ns = 0.0;
+        double vector_ns = 0.0;
+        uint64_t occupied = 0;
+        float checksum = 0.0f;
+        for (int t = 0; t < opts.ticks; ++t) {
+            chase_player(state.zombies, state.player.pos);
+            auto t0 = std::chrono::steady_clock::now();
+            grid.write(state, out);
+            auto t1 = std::chrono::steady_clock::now();
+            const auto obs = lv::build_observation(state);
+            auto t2 = std::chrono::steady_clock::now();
+            grid_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            vector_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+            occupied += static_cast<uint64_t>(std::count(out.begin(), out.end(), uint8_t{255}));
+            checksum += obs[0];
+        }
+        std::cout << "occupancy  zombies=" << std::setw(4) << count << "  grid=" << lv::kOccupancyGridSize << 'x'
+                  << lv::kOccupancyGridSize << 'x' << lv::kOccupancyChannels << std::fixed << std::setprecision(1)
+                  << "  grid_ns=" << std::setw(8) << grid_ns / opts.ticks << "  vector_obs_ns=" << std::setw(8)
+                  << vector_ns / opts.ticks << "  occupied/grid=" << std::setw(6)
+                  << static_cast<double>(occupied) / opts.ticks << (checksum < 0.0f ? " " : "") << '\n';
+    }
+}
+
+// Software renderer frame rate on a mid-game state with a horde in view.
+void bench_render(const BenchOptions& opts) {
+    lv::Simulator sim;
+    lv::GameState state = sim.state();
+    state.zombies = make_horde(400, 17, 0.05f);
+    lv::DeterministicRng rng(19);
+    for (int i = 0; i < 48; ++i) {
+        lv::Bullet b;
+        b.pos = {lv::kPlayerSpawnX + rng.uniform(-600.0f, 600.0f), lv::kPlayerSpawnY + rng.uniform(-350.0f, 350.0f)};
+        state.bullets.push_back(b);
+    }
+
+    for (const auto& [w, h] : {std::pair{160, 90}, std::pair{640, 360}, std::pair{1280, 720}}) {
+        const lv::SoftwareRenderer renderer(w, h);
+        std::vector<uint8_t> frame(renderer.frame_bytes());
+        uint64_t checksum = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int t = 0; t < opts.ticks; ++t) {
+            chase_player(state.zombies, state.player.pos);
+            renderer.render(state, frame);
+            checksum += frame[frame.size() / 2];
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        const double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / opts.ticks;
+        std::cout << "render  frame=" << std::setw(4) << w << 'x' << std::setw(3) << h << std::fixed
+                  << std::setprecision(1) << "  us/frame=" << std::setw(7) << us << "  fps=" << std::setw(8)
+                  << 1e6 / us << (checksum == 0 ? " " : "") << '\n';
+    }
+}
+
+// Stream-socket stand-in for agent_server.py: accepts one client, answers the
+// hello with binary-v1 and returns a zero action for every observation frame,
+// after delay(frame index) when given.
+void serve_echo_agent(int listen_fd, std::function<std::chrono::microseconds(uint64_t)> delay = {}) {
+    const int fd = ::accept(listen_fd, nullptr, nullptr);
+    ::close(listen_fd);
+    if (fd < 0) return;
+    const auto recv_exact = [fd](uint8_t* p, size_t n) {
+        while (n > 0) {
+            const ssize_t got = ::recv(fd, p, n, 0);
+            if (got <= 0) return false;
+            p += got;
+            n -= static_cast<size_t>(got);
+        }
+        return true;
+    };
+    uint8_t c = 0;
+    while (recv_exact(&c, 1) && c != '\n') {
+    }
+    const std::string hello = std::string("{\"type\":\"hello\",\"model\":\"echo\",\"protocol\":\"") +
+                              lv::kAgentBinaryProtocolName + "\"}\n";
+    ::send(fd, hello.data(), hello.size(), MSG_NOSIGNAL);
+
+    std::vector<uint8_t> reply;
+    lv::encode_agent_frame(lv::AgentFrameKind::Action, std::array<float, lv::kAgentActionValues>{}, reply);
+    std::array<uint8_t, lv::kAgentFrameHeaderBytes> header{};
+    std::vector<uint8_t> payload;
+    for (uint64_t frame = 0; recv_exact(header.data(), header.size()); ++frame) {
+        payload.resize(lv::decode_agent_frame_header(header).count * sizeof(float));
+        if (!recv_exact(payload.data(), payload.size())) break;
+        if (delay) std::this_thread::sleep_for(delay(frame));
+        if (::send(fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) break;
+    }
+    ::close(fd);
+}
+
+// Round-trip latency of one observation/action exchange per transport against
+// an in-process echo peer, so the numbers exclude any model cost.
+void bench_agent_transport(const BenchOptions& opts) {
+    const std::vector<float> obs(lv::Simulator().observation().size(), 0.25f);
+    const std::string unix_path = "/tmp/lv_bench_" + std::to_string(::getpid()) + ".sock";
+    const std::string shm_name = "lv_bench_" + std::to_string(::getpid());
+
+    for (const lv::AgentTransport transport : {lv::AgentTransport::Tcp, lv::AgentTransport::Unix, lv::AgentTransport::Shm}) {
+        lv::AgentEndpoint endpoint;
+        endpoint.transport = transport;
+        std::thread peer;
+        std::atomic<bool> stop{false};
+
+        if (transport == lv::AgentTransport::Shm) {
+            endpoint.path = shm_name;
+            std::promise<void> ready;
+            auto ready_future = ready.get_future();
+            peer = std::thread([&] {
+                lv::ShmMailbox mailbox(shm_name, lv::ShmMailboxRole::Server, "echo");
+                std::vector<uint8_t> reply;
+                lv::encode_agent_frame(lv::AgentFrameKind::Action, std::array<float, lv::kAgentActionValues>{}, reply);
+                ready.set_value();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    if (!mailbox.wait_request(10).empty()) mailbox.post_response(reply);
+                }
+            });
+            ready_future.wait();
+        } else {
+            int listen_fd = -1;
+            if (transport == lv::AgentTransport::Tcp) {
+                listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr{};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                socklen_t len = sizeof(addr);
+                ::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len);
+                ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+                endpoint.host = "127.0.0.1";
+                endpoint.port = ntohs(addr.sin_port);
+            } else {
+                listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                sockaddr_un addr{};
+                addr.sun_family = AF_UNIX;
+                std::memcpy(addr.sun_path, unix_path.c_str(), unix_path.size() + 1);
+                ::unlink(unix_path.c_str());
+                ::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+                endpoint.path = unix_path;
+            }
+            ::listen(listen_fd, 1);
+            peer = std::thread([listen_fd] { serve_echo_agent(listen_fd); });
+        }
+
+        std::vector<double> rtt_us(static_cast<size_t>(opts.ticks));
+        {
+            auto client = lv::connect_agent(endpoint);
+            client->handshake_or_throw();
+            for (int i = 0; i < 100; ++i) client->infer_or_throw(obs);
+            for (double& us : rtt_us) {
+                auto t0 = std::chrono::steady_clock::now();
+                client->infer_or_throw(obs);
+                auto t1 = std::chrono::steady_clock::now();
+                us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+            }
+        }
+        stop.store(true, std::memory_order_relaxed);
+        peer.join();
+        if (transport == lv::AgentTransport::Unix) ::unlink(unix_path.c_str());
+
+        std::sort(rtt_us.begin(), rtt_us.end());
+        const auto pct = [&](double q) { return rtt_us[static_cast<size_t>(q * static_cast<double>(rtt_us.size() - 1))]; };
+        const char* label = transport == lv::AgentTransport::Tcp ? "tcp " : transport == lv::AgentTransport::Unix ? "unix" : "shm ";
+        std::cout << "agent_transport  " << label << std::fixed << std::setprecision(1) << "  p50_us=" << std::setw(7) << pct(0.5)
+                  << "  p99_us=" << std::setw(7) << pct(0.99) << "  max_us=" << std::setw(8) << rtt_us.back() << '\n';
+    }
+}
+
+// Time the game loop spends per tick getting an action from an agent that
+// answers in 1 ms but stalls for 40 ms on every 50th request, blocking on
+// each reply versus AsyncAgent with an 8 ms deadline.
+void bench_agent_async(const BenchOptions& opts) {
+    const std::vector<float> obs(lv::Simulator().observation().size(), 0.25f);
+    const std::string unix_path = "/tmp/lv_bench_" + std::to_string(::getpid()) + ".sock";
+    const auto jitter = [](uint64_t frame) {
+        return std::chrono::microseconds(frame % 50 == 49 ? 40000 : 1000);
+    };
+    const int ticks = std::min(opts.ticks, 600);
+
+    for (const bool async : {false, true}) {
+        const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, unix_path.c_str(), unix_path.size() + 1);
+        ::unlink(unix_path.c_str());
+        ::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        ::listen(listen_fd, 1);
+        std::thread peer(serve_echo_agent, listen_fd, jitter);
+
+        lv::AgentEndpoint endpoint;
+        endpoint.transport = lv::AgentTransport::Unix;
+        endpoint.path = unix_path;
+        std::vector<double> wait_ms(static_cast<size_t>(ticks));
+        uint64_t late = 0;
+        uint64_t missed = 0;
+        {
+            auto client = lv::connect_agent(endpoint);
+            client->handshake_or_throw();
+            std::optional<lv::AsyncAgent> agent;
+            if (async) agent.emplace(std::move(client), std::chrono::milliseconds(8));
+            const lv::GameState state{};
+            for (double& ms : wait_ms) {
+                auto t0 = std::chrono::steady_clock::now();
+                if (agent.has_value()) {
+                    agent->next_action_or_throw(state, [&] { return obs; });
+                } else {
+                    client->next_action_or_throw(state, [&] { return obs; });
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            }
+            if (agent.has_value()) {
+                late = agent->late();
+                missed = agent->missed();
+            }
+        }
+        peer.join();
+        ::unlink(unix_path.c_str());
+
+        std::sort(wait_ms.begin(), wait_ms.end());
+        const auto pct = [&](double q) { return wait_ms[static_cast<size_t>(q * static_cast<double>(wait_ms.size() - 1))]; };
+        std::cout << "agent_async  " << (async ? "async" : "sync ") << std::fixed << std::setprecision(2)
+                  << "  p50_ms=" << std::setw(6) << pct(0.5) << "  p99_ms=" << std::setw(6) << pct(0.99)
+                  << "  max_ms=" << std::setw(6) << wait_ms.back() << "  late=" << late << "  missed=" << missed << '\n';
+    }
+}
+
+// Writes a random SB3-sized actor (obs -> 64 -> 64 -> 8, tanh) in the
+// export_policy.py format and returns its path.
+std::string write_random_policy(size_t obs_dim) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("lv_bench_policy_" + std::to_string(::getpid()) + ".bin")).string();
+    std::ofstream out(path, std::ios::binary);
+    const auto u32 = [&](uint32_t v) { out.write(reinterpret_cast<const char*>(&v), sizeof(v)); };
+    const std::vector<std::pair<size_t, size_t>> shapes = {{obs_dim, 64}, {64, 64}, {64, 8}};
+    u32(0x504d564c);
+    u32(1);
+    u32(static_cast<uint32_t>(obs_dim));
+    u32(8);
+    u32(static_cast<uint32_t>(shapes.size()));
+    u32(0);
+    lv::DeterministicRng rng(23);
+    for (const auto& [in, outputs] : shapes) {
+        u32(static_cast<uint32_t>(in));
+        u32(static_cast<uint32_t>(outputs));
+        const float scale = 1.0f / std::sqrt(static_cast<float>(in));
+        for (size_t i = 0; i < in * outputs + outputs; ++i) {
+            const float w = rng.uniform(-scale, scale);
+            out.write(reinterpret_cast<const char*>(&w), sizeof(w));
+        }
+    }
+    return path;
+}
+
+// Native actor forward pass per observation at several batch sizes.
+void bench_mlp(const BenchOptions& opts) {
+    const size_t obs_dim = lv::Simulator().observation().size();
+    const std::string path = write_random_policy(obs_dim);
+    lv::MlpPolicy policy(path);
+    std::filesystem::remove(path);
+
+    lv::DeterministicRng rng(29);
+    for (const size_t batch : {size_t{1}, size_t{16}, size_t{256}}) {
+        std::vector<float> obs(batch * obs_dim);
+        for (float& v : obs) v = rng.uniform(-1.0f, 1.0f);
+        std::vector<float> out(batch * policy.action_dim());
+        float checksum = 0.0f;
+        const int reps = std::max(1, opts.ticks * 16 / static_cast<int>(batch));
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) {
+            policy.forward(obs, batch, out);
+            checksum += out[0];
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (static_cast<double>(reps) * batch);
+        std::cout << "mlp  " << obs_dim << "-64-64-8  batch=" << std::setw(3) << batch << std::fixed
+                  << std::setprecision(1) << "  ns/obs=" << std::setw(8) << ns << "  obs/s=" << std::setw(10)
+                  << 1e9 / ns << (checksum == 0.0f ? " " : "") << '\n';
+    }
+}
+
+struct BenchCase {
+    const char* name;
+    std::function<void(const BenchOptions&)> run;
+};
+
+void print_usage() {
+    std::cout << "Usage: last_vector_bench [--ticks N] [--filter NAME]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--ticks" && i + 1 < argc) {
+                opts.ticks = std::stoi(argv[++i]);
+            } else if (arg == "--filter" && i + 1 < argc) {
+                opts.filter = argv[++i];
+            } else if (arg == "--help" || arg == "-h") {
+                print_usage();
+                return 0;
+            } else {
+                std::cerr << "Unknown or incomplete argument: " << arg << '\n';
+                print_usage();
+                return 2;
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Failed to parse CLI arguments: " << ex.what() << '\n';
+        return 2;
+    }
+
+    if (opts.ticks < 1) {
+        std::cerr << "--ticks must be >= 1\n";
+        return 2;
+    }
+
+    const std::vector<BenchCase> cases = {
+        {"separation", bench_separation},
+        {"morton", bench_morton},
+        {"jacobi", bench_jacobi},
+        {"zombie_rays", bench_zombie_rays},
+        {"obstacles", bench_obstacles},
+        {"occupancy", bench_occupancy},
+        {"render", bench_render},
+        {"agent_transport", bench_agent_transport},
+        {"agent_async", bench_agent_async},
+        {"mlp", bench_mlp},
+    };
+
+    for (const auto& bench : cases) {
+        if (!opts.filter.empty() && opts.filter != bench.name) continue;
+        bench.run(opts);
+    }
+    return 0;
+}
@@ -18,6 +18,14 @@ bool point_inside_aabb(Vec2 p, const Obstacle& box) {
 
 } // namespace
 
+void sanitize_position(Vec2& pos, Vec2 fallback, float radius, Vec2 arena_size) {
+    if (!std::isfinite(pos.x) || !std::isfinite(pos.y)) {
+        pos = fallback;
+    }
+    pos.x = std::clamp(pos.x, radius, arena_size.x - radius);
+    pos.y = std::clamp(pos.y, radius, arena_size.y - radius);
+}
+
 Vec2 closest_point_on_aabb(Vec2 point, const Obstacle& box) {
     return {
         std::clamp(point.x, box.x, box.x + box.w),
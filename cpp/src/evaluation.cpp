@@ -0,0 +1,258 @@
+#include "lastvector/evaluation.hpp"
+#include "lastvector/agent_protocol.hpp"
+#include "lastvector/mlp_policy.hpp"
+#include "lastvector/sim.hpp"
+#include "lastvector/thread_pool.hpp"
+#include "lastvector/trajectory_writer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace lv {
+
+namespace {
+
+struct EvalSlot {
+    std::unique_ptr<Simulator> sim;
+    std::vector<float> obs;
+    size_t episode = 0;
+    EpisodeResult result;
+    bool active = false;
+    bool done = false;
+};
+
+void record_step(EpisodeResult& r, const StepResult& res) {
+    r.reward += res.reward;
+    r.steps += 1;
+    r.kills = res.info.kills;
+    r.shots_fired = res.info.shots_fired;
+    r.hits = res.info.hits;
+    r.accuracy = res.info.accuracy;
+}
+
+void record_end(EpisodeResult& r, const GameState& state) {
+    r.ticks = state.tick;
+    r.survival_s = state.episode_time_s;
+    r.died = state.play_state == PlayState::Dead;
+}
+
+void step_slot(EvalSlot& slot, std::span<const float> raw, int max_ticks) {
+    StepResult res = slot.sim->step(decode_action(raw.first<kActionValues>()));
+
+    record_step(slot.result, res);
+    slot.obs = std::move(res.observation);
+    slot.done = res.terminated || res.truncated || (max_ticks > 0 && slot.result.steps >= max_ticks);
+    if (slot.done) record_end(slot.result, slot.sim->state());
+}
+
+EpisodeResult play_episode(Simulator& sim, uint64_t seed, MlpPolicy* policy, int max_ticks, TrajectoryWriter* dataset,
+                           uint32_t env) {
+    EpisodeResult r;
+    r.seed = seed;
+    std::vector<float> obs = sim.reset(seed);
+    while (max_ticks == 0 || r.steps < max_ticks) {
+        Action action{};
+        if (policy != nullptr) {
+            action = policy->act(obs);
+        } else if (sim.state().play_state == PlayState::ChoosingUpgrade) {
+            action.upgrade_choice = 0;
+        }
+        StepResult res = sim.step(action);
+        if (dataset != nullptr) dataset->append(seed, env, static_cast<uint32_t>(r.steps), obs, action, res);
+        record_step(r, res);
+        obs = std::move(res.observation);
+        if (res.terminated || res.truncated) break;
+    }
+    record_end(r, sim.state());
+    return r;
+}
+
+// Linear interpolation between closest ranks (numpy's default).
+double percentile(const std::vector<double>& sorted, double q) {
+    const double pos = q * static_cast<double>(sorted.size() - 1);
+    const size_t lo = static_cast<size_t>(pos);
+    const size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+}
+
+void write_summary(std::ostringstream& out, std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    double mean = 0.0;
+    for (const double v : values) mean += v;
+    mean /= static_cast<double>(values.size());
+    double var = 0.0;
+    for (const double v : values) var += (v - mean) * (v - mean);
+    const double std_dev = std::sqrt(var / static_cast<double>(values.size()));
+
+    out << "{\"mean\":" << mean << ",\"std\":" << std_dev << ",\"min\":" << values.front();
+    for (const auto& [name, q] : {std::pair{"p5", 0.05}, std::pair{"p25", 0.25}, std::pair{"p50", 0.5},
+                                  std::pair{"p75", 0.75}, std::pair{"p95", 0.95}}) {
+        out << ",\"" << name << "\":" << percentile(values, q);
+    }
+    out << ",\"max\":" << values.back() << '}';
+}
+
+} // namespace
+
+std::vector<EpisodeResult> evaluate_policy(const EvalConfig& config, const BatchPolicy& policy) {
+    if (config.episodes < 1) throw std::invalid_argument("evaluation needs episodes >= 1");
+    if (config.threads < 1) throw std::invalid_argument("evaluation needs threads >= 1");
+    if (config.batch < 1) throw std::invalid_argument("evaluation needs batch >= 1");
+    if (config.max_ticks < 0) throw std::invalid_argument("evaluation needs max_ticks >= 0");
+
+    const auto episodes = static_cast<size_t>(config.episodes);
+    std::vector<EpisodeResult> results(episodes);
+    std::vector<EvalSlot> slots(std::min(episodes, static_cast<size_t>(config.batch)));
+    size_t next_episode = 0;
+    const auto start_episode = [&](EvalSlot& slot) {
+        slot.episode = next_episode++;
+        slot.result = {};
+        slot.result.seed = config.first_seed + slot.episode;
+        slot.obs = slot.sim->reset(slot.result.seed);
+        slot.active = true;
+        slot.done = false;
+    };
+    for (EvalSlot& slot : slots) {
+        slot.sim = std::make_unique<Simulator>(config.sim);
+        start_episode(slot);
+    }
+
+    ThreadPool pool(config.threads);
+    const size_t obs_dim = static_cast<size_t>(slots.front().sim->observation_dim());
+    std::vector<size_t> live;
+    std::vector<float> obs;
+    std::vector<float> actions;
+    while (true) {
+        live.clear();
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].active) live.push_back(i);
+        }
+        if (live.empty()) break;
+
+        const size_t n = live.size();
+        obs.resize(n * obs_dim);
+        actions.assign(n * kAgentActionValues, 0.0f);
+        for (size_t k = 0; k < n; ++k) {
+            std::memcpy(obs.data() + k * obs_dim, slots[live[k]].obs.data(), obs_dim * sizeof(float));
+        }
+        policy(obs, n, actions);
+
+        pool.parallel_for(n, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                step_slot(slots[live[k]], std::span<const float>(actions).subspan(k * kAgentActionValues, kAgentActionValues),
+                          config.max_ticks);
+            }
+        });
+
+        for (const size_t i : live) {
+            EvalSlot& slot = slots[i];
+            if (!slot.done) continue;
+            results[slot.episode] = slot.result;
+            if (next_episode < episodes) {
+                start_episode(slot);
+            } else {
+                slot.active = false;
+            }
+        }
+    }
+    return results;
+}
+
+void run_sweep(const SweepConfig& config, const MlpPolicy* policy,
+               const std::function<void(const SweepEpisode&)>& on_episode) {
+    if (config.last_seed < config.first_seed) throw std::invalid_argument("sweep needs first_seed <= last_seed");
+    if (config.threads < 1) throw std::invalid_argument("sweep needs threads >= 1");
+    if (config.max_ticks < 0) throw std::invalid_argument("sweep needs max_ticks >= 0");
+
+    const uint64_t span = config.last_seed - config.first_seed;
+    if (span >= std::numeric_limits<size_t>::max()) throw std::invalid_argument("sweep seed range is too large");
+    const size_t count = static_cast<size_t>(span) + 1;
+
+    ThreadPool pool(config.threads);
+    std::vector<std::unique_ptr<Simulator>> sims(static_cast<size_t>(pool.size()));
+    std::vector<std::optional<MlpPolicy>> policies(sims.size());
+    for (size_t t = 0; t < sims.size(); ++t) {
+        sims[t] = std::make_unique<Simulator>(config.sim);
+        if (policy != nullptr) policies[t].emplace(*policy);
+    }
+
+    // Finished episodes wait here until every earlier seed is reported.
+    std::mutex report_mutex;
+    std::vector<std::optional<SweepEpisode>> finished(count);
+    size_t next_report = 0;
+    std::exception_ptr error;
+
+    pool.parallel_for_each(count, [&](size_t index, int thread) {
+        {
+            std::lock_guard<std::mutex> lock(report_mutex);
+            if (error) return;
+        }
+        try {
+            const auto t = static_cast<size_t>(thread);
+            const auto start = std::chrono::steady_clock::now();
+            SweepEpisode episode;
+            episode.result = play_episode(*sims[t], config.first_seed + index,
+                                          policies[t] ? &*policies[t] : nullptr, config.max_ticks, config.dataset,
+                                          static_cast<uint32_t>(thread));
+            episode.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(report_mutex);
+            if (error) return;
+            finished[index] = episode;
+            while (next_report < count && finished[next_report]) {
+                on_episode(*finished[next_report]);
+                finished[next_report].reset();
+                next_report += 1;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(report_mutex);
+            if (!error) error = std::current_exception();
+        }
+    });
+    if (error) std::rethrow_exception(error);
+}
+
+std::string eval_report_json(const std::vector<EpisodeResult>& results) {
+    if (results.empty()) throw std::invalid_argument("eval_report_json needs at least one episode");
+
+    std::ostringstream out;
+    out.precision(9);
+    out << "{\"episodes\":" << results.size() << ",\"summary\":{";
+    const auto metric = [&](const char* name, auto field) {
+        std::vector<double> values;
+        values.reserve(results.size());
+        for (const EpisodeResult& r : results) values.push_back(static_cast<double>(field(r)));
+        out << '"' << name << "\":";
+        write_summary(out, std::move(values));
+    };
+    metric("reward", [](const EpisodeResult& r) { return r.reward; });
+    out << ',';
+    metric("survival_s", [](const EpisodeResult& r) { return r.survival_s; });
+    out << ',';
+    metric("kills", [](const EpisodeResult& r) { return r.kills; });
+    out << ',';
+    metric("accuracy", [](const EpisodeResult& r) { return r.accuracy; });
+    out << "},\"per_seed\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const EpisodeResult& r = results[i];
+        out << (i > 0 ? "," : "") << "{\"seed\":" << r.seed << ",\"reward\":" << r.reward
+            << ",\"survival_s\":" << r.survival_s << ",\"kills\":" << r.kills << ",\"accuracy\":" << r.accuracy
+            << ",\"shots_fired\":" << r.shots_fired << ",\"hits\":" << r.hits << ",\"steps\":" << r.steps
+            << ",\"ticks\":" << r.ticks
+            << ",\"died\":" << (r.died ? "true" : "false") << '}';
+    }
+    out << "]}";
+    return out.str();
+}
+
+} // namespace lv
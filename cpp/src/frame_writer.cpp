@@ -0,0 +1,90 @@
+#include "lastvector/frame_writer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/wait.h>
+
+namespace lv {
+
+namespace {
+
+std::runtime_error io_error(const std::string& what, const std::string& target) {
+    return std::runtime_error("FrameWriter: " + what + " '" + target + "': " + std::strerror(errno));
+}
+
+} // namespace
+
+FrameWriter::FrameWriter(const std::string& spec, int width, int height) : width_(width), height_(height) {
+    if (width <= 0 || height <= 0) throw std::invalid_argument("FrameWriter: frame size must be positive");
+    const size_t colon = spec.find(':');
+    if (colon == std::string::npos || colon + 1 >= spec.size()) {
+        throw std::invalid_argument("FrameWriter: expected ppm:DIR, raw:FILE or pipe:COMMAND, got '" + spec + "'");
+    }
+    const std::string kind = spec.substr(0, colon);
+    target_ = spec.substr(colon + 1);
+
+    if (kind == "ppm") {
+        format_ = FrameFormat::Ppm;
+        std::error_code ec;
+        std::filesystem::create_directories(target_, ec);
+        if (ec) throw std::runtime_error("FrameWriter: cannot create '" + target_ + "': " + ec.message());
+    } else if (kind == "raw") {
+        format_ = FrameFormat::Raw;
+        file_ = std::fopen(target_.c_str(), "wb");
+        if (file_ == nullptr) throw io_error("cannot open", target_);
+    } else if (kind == "pipe") {
+        format_ = FrameFormat::Pipe;
+        file_ = popen(target_.c_str(), "w");
+        if (file_ == nullptr) throw io_error("cannot start", target_);
+    } else {
+        throw std::invalid_argument("FrameWriter: unknown frame format '" + kind + "'");
+    }
+}
+
+FrameWriter::~FrameWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void FrameWriter::write(std::span<const uint8_t> frame) {
+    const size_t bytes = static_cast<size_t>(width_) * height_ * 3;
+    if (frame.size() != bytes) {
+        throw std::invalid_argument("FrameWriter: frame has " + std::to_string(frame.size()) + " bytes, expected " +
+                                    std::to_string(bytes));
+    }
+
+    if (format_ == FrameFormat::Ppm) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%06llu.ppm", static_cast<unsigned long long>(frames_));
+        const std::string path = (std::filesystem::path(target_) / name).string();
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (f == nullptr) throw io_error("cannot open", path);
+        const bool ok = std::fprintf(f, "P6\n%d %d\n255\n", width_, height_) > 0 &&
+                        std::fwrite(frame.data(), 1, frame.size(), f) == frame.size();
+        if (std::fclose(f) != 0 || !ok) throw io_error("cannot write", path);
+    } else {
+        if (file_ == nullptr) throw std::runtime_error("FrameWriter: write after close");
+        if (std::fwrite(frame.data(), 1, frame.size(), file_) != frame.size()) throw io_error("cannot write", target_);
+    }
+    ++frames_;
+}
+
+void FrameWriter::close() {
+    if (file_ == nullptr) return;
+    std::FILE* f = file_;
+    file_ = nullptr;
+    if (format_ == FrameFormat::Pipe) {
+        const int status = pclose(f);
+        if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error("FrameWriter: command '" + target_ + "' failed");
+        }
+    } else if (std::fclose(f) != 0) {
+        throw io_error("cannot write", target_);
+    }
+}
+
+} // namespace lv
@@ -1,290 +1,222 @@
+#include "lastvector/agent_client.hpp"
+#include "lastvector/agent_protocol.hpp"
+#include "lastvector/async_agent.hpp"
+#include "lastvector/evaluation.hpp"
+#include "lastvector/frame_writer.hpp"
+#include "lastvector/mlp_policy.hpp"
 #include "lastvector/observation.hpp"
+#include "lastvector/render_snapshot.hpp"
+#include "lastvector/replay.hpp"
 #include "lastvector/sim.hpp"
+#include "lastvector/sim_thread.hpp"
+#include "lastvector/software_renderer.hpp"
+#include "lastvector/trajectory_writer.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <cerrno>
+#include <chrono>
 #include <cmath>
+#include <csignal>
 #include <cstdint>
 #include <cstring>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <sys/socket.h>
-#include <sys/types.h>
-#include <unistd.h>
-
 #ifdef LASTVECTOR_WITH_RAYLIB
 #include <raylib.h>
 #endif
 
 namespace {
 
-class TcpAgentClient {
-  public:
-    TcpAgentClient(std::string host, std::uint16_t port) : host_(std::move(host)), port_(port) {}
-
-    TcpAgentClient(const TcpAgentClient&) = delete;
-    TcpAgentClient& operator=(const TcpAgentClient&) = delete;
-
-    TcpAgentClient(TcpAgentClient&& other) noexcept
-        : host_(std::move(other.host_)),
-          port_(other.port_),
-          fd_(other.fd_),
-          recv_buffer_(std::move(other.recv_buffer_)) {
-        other.fd_ = -1;
-    }
-
-    TcpAgentClient& operator=(TcpAgentClient&& other) noexcept {
-        if (this == &other) {
-            return *this;
-        }
-        if (fd_ >= 0) {
-            ::close(fd_);
-        }
-        host_ = std::move(other.host_);
-        port_ = other.port_;
-        fd_ = other.fd_;
-        recv_buffer_ = std::move(other.recv_buffer_);
-        other.fd_ = -1;
-        return *this;
+// "WxH" -> (W, H); nullopt when malformed.
+std::optional<std::pair<float, float>> parse_size(const std::string& text) {
+    const size_t x = text.find('x');
+    if (x == std::string::npos) return std::nullopt;
+    try {
+        return std::pair{std::stof(text.substr(0, x)), std::stof(text.substr(x + 1))};
+    } catch (...) {
+        return std::nullopt;
     }
+}
 
-    ~TcpAgentClient() {
-        if (fd_ >= 0) {
-            ::close(fd_);
-        }
+// "A..B" -> (A, B), inclusive; nullopt when malformed or B < A.
+std::optional<std::pair<std::uint64_t, std::uint64_t>> parse_seed_range(const std::string& text) {
+    const size_t dots = text.find("..");
+    if (dots == std::string::npos || dots == 0 || dots + 2 >= text.size()) return std::nullopt;
+    try {
+        size_t used = 0;
+        const std::string first = text.substr(0, dots);
+        const std::string last = text.substr(dots + 2);
+        const auto a = std::stoull(first, &used);
+        if (used != first.size()) return std::nullopt;
+        const auto b = std::stoull(last, &used);
+        if (used != last.size() || b < a) return std::nullopt;
+        return std::pair{a, b};
+    } catch (...) {
+        return std::nullopt;
     }
+}
 
-    void connect_or_throw() {
-        struct addrinfo hints {};
-        hints.ai_family = AF_UNSPEC;
-        hints.ai_socktype = SOCK_STREAM;
-
-        struct addrinfo* result = nullptr;
-        const std::string port_str = std::to_string(port_);
-        const int rv = ::getaddrinfo(host_.c_str(), port_str.c_str(), &hints, &result);
-        if (rv != 0) {
-            throw std::runtime_error("getaddrinfo failed: " + std::string(gai_strerror(rv)));
-        }
-
-        for (auto* rp = result; rp != nullptr; rp = rp->ai_next) {
-            const int candidate = ::socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-            if (candidate < 0) {
-                continue;
-            }
-            if (::connect(candidate, rp->ai_addr, rp->ai_addrlen) == 0) {
-                fd_ = candidate;
-                break;
-            }
-            ::close(candidate);
+// Per-episode lines of a --seeds sweep: the single-run "seed= ticks= ..."
+// line on stdout, or CSV / JSON Lines chosen by the --results extension.
+class SweepWriter {
+  public:
+    explicit SweepWriter(const std::string& path) {
+        if (path.empty()) return;
+        const std::string ext = std::filesystem::path(path).extension().string();
+        if (ext == ".csv") {
+            format_ = Format::Csv;
+        } else if (ext == ".jsonl" || ext == ".json") {
+            format_ = Format::JsonLines;
+        } else {
+            throw std::invalid_argument("--results must end in .csv or .jsonl");
         }
-
-        ::freeaddrinfo(result);
-
-        if (fd_ < 0) {
-            throw std::runtime_error("unable to connect to agent at " + host_ + ":" + std::to_string(port_));
+        file_.open(path);
+        if (!file_) throw std::runtime_error("cannot open " + path);
+        file_.precision(9);
+        if (format_ == Format::Csv) {
+            file_ << "seed,ticks,steps,kills,dead,reward,survival_s,shots_fired,hits,accuracy,wall_s\n";
         }
     }
 
-    std::string handshake_or_throw() {
-        send_line_or_throw("{\"type\":\"hello\"}\n");
-        const std::string line = recv_line_or_throw();
-        const std::string model = extract_json_string_field(line, "model");
-        if (model.empty()) {
-            return "unknown";
+    void write(const lv::SweepEpisode& episode) {
+        const lv::EpisodeResult& r = episode.result;
+        switch (format_) {
+        case Format::Text:
+            std::cout << "seed=" << r.seed << " ticks=" << r.ticks << " kills=" << r.kills
+                      << " dead=" << (r.died ? 1 : 0) << '\n';
+            return;
+        case Format::Csv:
+            file_ << r.seed << ',' << r.ticks << ',' << r.steps << ',' << r.kills << ',' << (r.died ? 1 : 0) << ','
+                  << r.reward << ',' << r.survival_s << ',' << r.shots_fired << ',' << r.hits << ',' << r.accuracy
+                  << ',' << episode.wall_s << '\n';
+            break;
+        case Format::JsonLines:
+            file_ << "{\"seed\":" << r.seed << ",\"ticks\":" << r.ticks << ",\"steps\":" << r.steps
+                  << ",\"kills\":" << r.kills << ",\"dead\":" << (r.died ? "true" : "false") << ",\"reward\":" << r.reward
+                  << ",\"survival_s\":" << r.survival_s << ",\"shots_fired\":" << r.shots_fired
+                  << ",\"hits\":" << r.hits << ",\"accuracy\":" << r.accuracy << ",\"wall_s\":" << episode.wall_s
+                  << "}\n";
+            break;
         }
-        return model;
-    }
-
-    lv::Action infer_or_throw(const std::vector<float>& obs) {
-        send_line_or_throw(build_observation_json(obs));
-        const std::string response = recv_line_or_throw();
-        const auto action_values = parse_action_values(response);
-
-        lv::Action action{};
-        action.move_x = clamp(action_values[0], -1.0f, 1.0f);
-        action.move_y = clamp(action_values[1], -1.0f, 1.0f);
-        action.aim_x = clamp(action_values[2], -1.0f, 1.0f);
-        action.aim_y = clamp(action_values[3], -1.0f, 1.0f);
-        action.shoot = action_values[4] > 0.5f;
-        action.sprint = action_values[5] > 0.5f;
-        action.reload = action_values[6] > 0.5f;
-
-        const int raw_upgrade = static_cast<int>(std::lround(action_values[7]));
-        action.upgrade_choice = (raw_upgrade >= 0 && raw_upgrade <= 2) ? raw_upgrade : -1;
-        return action;
+        // Flushed per episode so a long sweep can be watched while it runs.
+        file_.flush();
+        if (!file_) throw std::runtime_error("failed to write sweep results");
     }
 
   private:
-    static float clamp(float value, float lo, float hi) {
-        return std::max(lo, std::min(hi, value));
-    }
-
-    void send_line_or_throw(const std::string& payload) {
-        std::size_t sent = 0;
-        while (sent < payload.size()) {
-            const auto n = ::send(fd_, payload.data() + sent, payload.size() - sent, 0);
-            if (n < 0) {
-                if (errno == EINTR) {
-                    continue;
-                }
-                throw std::runtime_error("send() failed: " + std::string(std::strerror(errno)));
-            }
-            if (n == 0) {
-                throw std::runtime_error("send() returned 0 bytes");
-            }
-            sent += static_cast<std::size_t>(n);
-        }
-    }
+    enum class Format { Text, Csv, JsonLines };
+    Format format_ = Format::Text;
+    std::ofstream file_;
+};
 
-    std::string recv_line_or_throw() {
+// The window's side of the SimThread pipeline without a window: 60 times a
+// second it takes the newest snapshots and interpolates them as the raylib
+// loop does, drawing nothing, and throws std::logic_error if the snapshots
+// it sees go backwards or interpolation loses entities.
+class NullRenderer {
+  public:
+    void run(lv::SimThread& sim_thread) {
+        const auto frame_length = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / 60.0));
+        auto next_frame = std::chrono::steady_clock::now();
         while (true) {
-            const auto newline_pos = recv_buffer_.find('\n');
-            if (newline_pos != std::string::npos) {
-                std::string line = recv_buffer_.substr(0, newline_pos);
-                recv_buffer_.erase(0, newline_pos + 1);
-                return line;
+            // Read before poll() so the final snapshot is still picked up.
+            const bool done = sim_thread.finished();
+            const bool fresh = sim_thread.poll();
+            sim_thread.rethrow_if_failed();
+            if (fresh) check_order(sim_thread.previous(), sim_thread.current());
+
+            const auto now = std::chrono::steady_clock::now();
+            interpolator_.interpolate(sim_thread.previous(), sim_thread.current(),
+                                      lv::interpolation_alpha(sim_thread.previous(), sim_thread.current(), now),
+                                      view_);
+            if (view_.zombies.size() != sim_thread.current().zombies.size() ||
+                view_.bullets.size() != sim_thread.current().bullets.size()) {
+                throw std::logic_error("interpolated snapshot lost entities");
             }
+            frames_ += 1;
+            if (done && !fresh) return;
 
-            char chunk[2048];
-            const auto n = ::recv(fd_, chunk, sizeof(chunk), 0);
-            if (n < 0) {
-                if (errno == EINTR) {
-                    continue;
-                }
-                throw std::runtime_error("recv() failed: " + std::string(std::strerror(errno)));
-            }
-            if (n == 0) {
-                throw std::runtime_error("agent disconnected");
-            }
-            recv_buffer_.append(chunk, static_cast<std::size_t>(n));
-            if (recv_buffer_.size() > 1U << 20U) {
-                throw std::runtime_error("incoming message too large");
-            }
+            next_frame += frame_length;
+            std::this_thread::sleep_until(next_frame);
         }
     }
 
-    static std::string build_observation_json(const std::vector<float>& obs) {
-        std::ostringstream oss;
-        oss.precision(7);
-        oss << "{\"obs\":[";
-        for (std::size_t i = 0; i < obs.size(); ++i) {
-            if (i > 0) {
-                oss << ',';
-            }
-            const float value = std::isfinite(obs[i]) ? obs[i] : 0.0f;
-            oss << value;
-        }
-        oss << "]}\n";
-        return oss.str();
-    }
+    uint64_t frames() const { return frames_; }
+    uint64_t snapshots() const { return snapshots_; }
+    // Ticks published while the renderer was between frames.
+    uint64_t unseen_ticks() const { return unseen_ticks_; }
 
-    static std::array<float, 8> parse_action_values(const std::string& json) {
-        const std::size_t key_pos = json.find("\"action\"");
-        if (key_pos == std::string::npos) {
-            throw std::runtime_error("agent response missing action field");
-        }
-        const std::size_t open = json.find('[', key_pos);
-        const std::size_t close = (open == std::string::npos) ? std::string::npos : json.find(']', open);
-        if (open == std::string::npos || close == std::string::npos || close <= open) {
-            throw std::runtime_error("agent response has invalid action array");
+  private:
+    void check_order(const lv::RenderSnapshot& prev, const lv::RenderSnapshot& cur) {
+        if (cur.sequence <= prev.sequence || cur.tick < prev.tick || cur.published < prev.published) {
+            throw std::logic_error("snapshot " + std::to_string(cur.sequence) + " arrived after snapshot " +
+                                   std::to_string(prev.sequence));
         }
+        snapshots_ += 1;
+        unseen_ticks_ += cur.sequence - prev.sequence - 1;
+    }
 
-        std::array<float, 8> values{};
-        std::size_t cursor = open + 1;
-        for (std::size_t i = 0; i < values.size(); ++i) {
-            while (cursor < close && std::isspace(static_cast<unsigned char>(json[cursor]))) {
-                ++cursor;
-            }
-            if (cursor >= close) {
-                throw std::runtime_error("agent action array ended early");
-            }
-
-            char* end_ptr = nullptr;
-            const float parsed = std::strtof(json.c_str() + cursor, &end_ptr);
-            if (end_ptr == json.c_str() + cursor || !std::isfinite(parsed)) {
-                throw std::runtime_error("agent action contains non-numeric entry");
-            }
-            values[i] = parsed;
-            cursor = static_cast<std::size_t>(end_ptr - json.c_str());
+    lv::SnapshotInterpolator interpolator_;
+    lv::RenderSnapshot view_;
+    uint64_t frames_ = 0;
+    uint64_t snapshots_ = 0;
+    uint64_t unseen_ticks_ = 0;
+};
 
-            while (cursor < close && std::isspace(static_cast<unsigned char>(json[cursor]))) {
-                ++cursor;
-            }
+// Software-rendered frames of every `every`-th tick, written to a FrameWriter.
+class FrameRecorder {
+  public:
+    FrameRecorder(const std::string& spec, int width, int height, int every)
+        : renderer_(width, height), writer_(spec, width, height), frame_(renderer_.frame_bytes()), every_(every) {}
 
-            if (i + 1 < values.size()) {
-                if (cursor >= close || json[cursor] != ',') {
-                    throw std::runtime_error("agent action array missing comma separator");
-                }
-                ++cursor;
-            }
-        }
-        return values;
+    void capture(const lv::GameState& state) {
+        if (state.tick % static_cast<uint64_t>(every_) != 0) return;
+        renderer_.render(state, frame_);
+        writer_.write(frame_);
     }
 
-    static std::string extract_json_string_field(const std::string& json, std::string_view field) {
-        const std::string quoted_key = "\"" + std::string(field) + "\"";
-        const std::size_t key_pos = json.find(quoted_key);
-        if (key_pos == std::string::npos) {
-            return {};
-        }
-        const std::size_t colon_pos = json.find(':', key_pos + quoted_key.size());
-        if (colon_pos == std::string::npos) {
-            return {};
-        }
-        const std::size_t q1 = json.find('"', colon_pos + 1);
-        if (q1 == std::string::npos) {
-            return {};
-        }
-        const std::size_t q2 = json.find('"', q1 + 1);
-        if (q2 == std::string::npos || q2 <= q1 + 1) {
-            return {};
-        }
-        return json.substr(q1 + 1, q2 - q1 - 1);
+    uint64_t finish() {
+        writer_.close();
+        return writer_.frames_written();
     }
 
-    std::string host_;
-    std::uint16_t port_ = 0;
-    int fd_ = -1;
-    std::string recv_buffer_;
-};
-
-struct AgentEndpoint {
-    std::string host;
-    std::uint16_t port = 0;
+  private:
+    lv::SoftwareRenderer renderer_;
+    lv::FrameWriter writer_;
+    std::vector<uint8_t> frame_;
+    int every_;
 };
 
-std::optional<AgentEndpoint> parse_agent_endpoint(const std::string& text) {
-    const auto colon = text.rfind(':');
-    if (colon == std::string::npos || colon == 0 || colon + 1 >= text.size()) {
-        return std::nullopt;
-    }
-    const std::string host = text.substr(0, colon);
-    const std::string port_text = text.substr(colon + 1);
-    try {
-        const long port = std::stol(port_text);
-        if (port <= 0 || port > 65535) {
-            return std::nullopt;
-        }
-        return AgentEndpoint{host, static_cast<std::uint16_t>(port)};
-    } catch (...) {
-        return std::nullopt;
-    }
-}
-
 void print_usage() {
-    std::cout << "Usage: last_vector [--headless|--rendered] [--seed N] [--max-steps N] [--agent HOST:PORT]\n";
+    std::cout << "Usage: last_vector [--headless|--rendered] [--null-render] [--fast-forward N]\n"
+                 "                   [--seed N] [--max-steps N] [--agent ENDPOINT]\n"
+                 "                   [--agent-protocol auto|json] [--agent-chunk K] [--agent-deadline-ms MS]\n"
+                 "                   [--policy FILE] [--eval N] [--eval-json FILE] [--threads N]\n"
+                 "                   [--seeds A..B] [--results FILE.csv|FILE.jsonl]\n"
+                 "                   [--arena WxH] [--max-alive N]\n"
+                 "                   [--record ppm:DIR|raw:FILE|pipe:CMD] [--frame-size WxH] [--record-every N]\n"
+                 "                   [--replay-out FILE] [--keyframe-every N] [--replay FILE] [--replay-from STEP]\n"
+                 "                   [--verify-replay FILE]\n"
+                 "                   [--dataset DIR] [--dataset-shard-rows N]\n"
+                 "ENDPOINT is HOST:PORT, unix:PATH or shm:NAME\n";
 }
 
 } // namespace
@@ -295,7 +227,30 @@ int main(int argc, char** argv) {
 #endif
     std::uint64_t seed = 1337;
     int max_steps = 36000;
-    std::optional<AgentEndpoint> agent_endpoint;
+    std::optional<lv::AgentEndpoint> agent_endpoint;
+    lv::SimConfig sim_config{};
+    std::string agent_protocol = "auto";
+    int agent_chunk = 1;
+    float agent_deadline_ms = 8.0f;
+    std::string policy_path;
+    int eval_episodes = 0;
+    std::string eval_json_path;
+    std::optional<std::pair<std::uint64_t, std::uint64_t>> seed_range;
+    std::string results_path;
+    int threads = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    std::string record_spec;
+    int frame_width = 640;
+    int frame_height = 360;
+    int record_every = 1;
+    int fast_forward = 1;
+    bool null_render = false;
+    std::string replay_out_path;
+    int keyframe_every = static_cast<int>(lv::ReplayWriter::kDefaultKeyframeInterval);
+    std::string replay_path;
+    std::uint64_t replay_from = 0;
+    std::string verify_replay_path;
+    std::string dataset_dir;
+    lv::TrajectorySpec dataset_spec;
 
     try {
         for (int i = 1; i < argc; ++i) {
@@ -314,17 +269,83 @@ int main(int argc, char** argv) {
 #ifdef LASTVECTOR_WITH_RAYLIB
                 headless = false;
 #endif
+            } else if (arg == "--fast-forward" && i + 1 < argc) {
+                fast_forward = std::stoi(argv[++i]);
+            } else if (arg == "--null-render") {
+                null_render = true;
             } else if (arg == "--seed" && i + 1 < argc) {
                 seed = std::stoull(argv[++i]);
             } else if (arg == "--max-steps" && i + 1 < argc) {
                 max_steps = std::stoi(argv[++i]);
             } else if (arg == "--agent" && i + 1 < argc) {
-                const auto parsed = parse_agent_endpoint(argv[++i]);
+                const auto parsed = lv::parse_agent_endpoint(argv[++i]);
                 if (!parsed.has_value()) {
-                    std::cerr << "Invalid --agent endpoint. Expected HOST:PORT\n";
+                    std::cerr << "Invalid --agent endpoint. Expected HOST:PORT, unix:PATH or shm:NAME\n";
                     return 2;
                 }
                 agent_endpoint = parsed;
+            } else if (arg == "--policy" && i + 1 < argc) {
+                policy_path = argv[++i];
+            } else if (arg == "--eval" && i + 1 < argc) {
+                eval_episodes = std::stoi(argv[++i]);
+            } else if (arg == "--eval-json" && i + 1 < argc) {
+                eval_json_path = argv[++i];
+            } else if (arg == "--seeds" && i + 1 < argc) {
+                seed_range = parse_seed_range(argv[++i]);
+                if (!seed_range.has_value()) {
+                    std::cerr << "Invalid --seeds range. Expected A..B with A <= B\n";
+                    return 2;
+                }
+            } else if (arg == "--results" && i + 1 < argc) {
+                results_path = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoi(argv[++i]);
+            } else if (arg == "--agent-chunk" && i + 1 < argc) {
+                agent_chunk = std::stoi(argv[++i]);
+            } else if (arg == "--agent-deadline-ms" && i + 1 < argc) {
+                agent_deadline_ms = std::stof(argv[++i]);
+            } else if (arg == "--agent-protocol" && i + 1 < argc) {
+                agent_protocol = argv[++i];
+                if (agent_protocol != "auto" && agent_protocol != "json") {
+                    std::cerr << "Invalid --agent-protocol. Expected auto or json\n";
+                    return 2;
+                }
+            } else if (arg == "--arena" && i + 1 < argc) {
+                const auto size = parse_size(argv[++i]);
+                if (!size.has_value()) {
+                    std::cerr << "Invalid --arena size. Expected WxH\n";
+                    return 2;
+                }
+                sim_config.arena_width = size->first;
+                sim_config.arena_height = size->second;
+            } else if (arg == "--max-alive" && i + 1 < argc) {
+                sim_config.max_alive_cap = std::stoi(argv[++i]);
+            } else if (arg == "--record" && i + 1 < argc) {
+                record_spec = argv[++i];
+            } else if (arg == "--frame-size" && i + 1 < argc) {
+                const auto size = parse_size(argv[++i]);
+                if (!size.has_value()) {
+                    std::cerr << "Invalid --frame-size. Expected WxH\n";
+                    return 2;
+                }
+                frame_width = static_cast<int>(size->first);
+                frame_height = static_cast<int>(size->second);
+            } else if (arg == "--record-every" && i + 1 < argc) {
+                record_every = std::stoi(argv[++i]);
+            } else if (arg == "--replay-out" && i + 1 < argc) {
+                replay_out_path = argv[++i];
+            } else if (arg == "--keyframe-every" && i + 1 < argc) {
+                keyframe_every = std::stoi(argv[++i]);
+            } else if (arg == "--replay" && i + 1 < argc) {
+                replay_path = argv[++i];
+            } else if (arg == "--replay-from" && i + 1 < argc) {
+                replay_from = std::stoull(argv[++i]);
+            } else if (arg == "--verify-replay" && i + 1 < argc) {
+                verify_replay_path = argv[++i];
+            } else if (arg == "--dataset" && i + 1 < argc) {
+                dataset_dir = argv[++i];
+            } else if (arg == "--dataset-shard-rows" && i + 1 < argc) {
+                dataset_spec.shard_rows = std::stoull(argv[++i]);
             } else if (arg == "--help" || arg == "-h") {
                 print_usage();
                 return 0;
@@ -343,25 +364,335 @@ int main(int argc, char** argv) {
         std::cerr << "--max-steps must be >= 1\n";
         return 2;
     }
+    if (agent_chunk < 1 || agent_chunk > lv::kAgentMaxActionChunk) {
+        std::cerr << "--agent-chunk must be in [1, " << lv::kAgentMaxActionChunk << "]\n";
+        return 2;
+    }
+    if (!(agent_deadline_ms >= 0.0f && agent_deadline_ms <= 1000.0f)) {
+        std::cerr << "--agent-deadline-ms must be in [0, 1000]\n";
+        return 2;
+    }
+    if (fast_forward < 1 || fast_forward > lv::SimThread::kMaxSpeed) {
+        std::cerr << "--fast-forward must be in [1, " << lv::SimThread::kMaxSpeed << "]\n";
+        return 2;
+    }
+    if (null_render && (seed_range.has_value() || eval_episodes > 0)) {
+        std::cerr << "--null-render cannot be combined with --seeds or --eval\n";
+        return 2;
+    }
+    if (record_every < 1) {
+        std::cerr << "--record-every must be >= 1\n";
+        return 2;
+    }
+    if (eval_episodes < 0 || (eval_episodes > 0 && policy_path.empty())) {
+        std::cerr << "--eval N needs N >= 1 and --policy\n";
+        return 2;
+    }
+    if (threads < 1) {
+        std::cerr << "--threads must be >= 1\n";
+        return 2;
+    }
+    if (seed_range.has_value() && (agent_endpoint.has_value() || eval_episodes > 0 || !record_spec.empty())) {
+        std::cerr << "--seeds cannot be combined with --agent, --eval or --record\n";
+        return 2;
+    }
+    if (!results_path.empty() && !seed_range.has_value()) {
+        std::cerr << "--results needs --seeds\n";
+        return 2;
+    }
+    if (!policy_path.empty() && agent_endpoint.has_value()) {
+        std::cerr << "--policy and --agent are mutually exclusive\n";
+        return 2;
+    }
+    if (keyframe_every < 1) {
+        std::cerr << "--keyframe-every must be >= 1\n";
+        return 2;
+    }
+    if (!replay_out_path.empty() && (seed_range.has_value() || eval_episodes > 0)) {
+        std::cerr << "--replay-out cannot be combined with --seeds or --eval\n";
+        return 2;
+    }
+    if (!replay_path.empty() && (agent_endpoint.has_value() || !policy_path.empty() || seed_range.has_value() ||
+                                 eval_episodes > 0 || !replay_out_path.empty())) {
+        std::cerr << "--replay cannot be combined with --agent, --policy, --seeds, --eval or --replay-out\n";
+        return 2;
+    }
+    if (replay_from > 0 && replay_path.empty()) {
+        std::cerr << "--replay-from needs --replay\n";
+        return 2;
+    }
+    if (!verify_replay_path.empty()) {
+        if (!replay_path.empty() || !replay_out_path.empty()) {
+            std::cerr << "--verify-replay cannot be combined with --replay or --replay-out\n";
+            return 2;
+        }
+        try {
+            lv::ReplayPlayer player(verify_replay_path);
+            if (const auto divergence = player.verify()) {
+                std::cout << "verify: diverged at step " << divergence->step << " (tick " << divergence->tick
+                          << "): " << divergence->what << '\n';
+                return 1;
+            }
+            std::cout << "verify: ok steps=" << player.length() << " keyframes="
+                      << (player.length() + player.keyframe_interval() - 1) / player.keyframe_interval() << '\n';
+            return 0;
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << '\n';
+            return 2;
+        }
+    }
+    bool dataset_mode_ok = !null_render && eval_episodes == 0;
+#ifdef LASTVECTOR_WITH_RAYLIB
+    dataset_mode_ok = dataset_mode_ok && (headless || seed_range.has_value());
+#endif
+    if (!dataset_dir.empty() && !dataset_mode_ok) {
+        std::cerr << "--dataset needs a --headless run, --replay or --seeds\n";
+        return 2;
+    }
 
     std::string model_name = "manual";
-    std::optional<TcpAgentClient> agent_client;
+    std::unique_ptr<lv::AgentClient> agent_client;
     if (agent_endpoint.has_value()) {
         try {
-            TcpAgentClient client(agent_endpoint->host, agent_endpoint->port);
-            client.connect_or_throw();
-            model_name = client.handshake_or_throw();
-            agent_client = std::move(client);
-            std::cout << "Connected to agent server at " << agent_endpoint->host << ':' << agent_endpoint->port
-                      << " model=" << model_name << '\n';
+            agent_client = lv::connect_agent(*agent_endpoint, agent_protocol != "json", agent_chunk);
+            model_name = agent_client->handshake_or_throw();
+            std::cout << "Connected to agent server at " << agent_endpoint->describe()
+                      << " model=" << model_name << " protocol=" << agent_client->protocol() << '\n';
         } catch (const std::exception& ex) {
             std::cerr << "Failed to connect to agent server: " << ex.what() << '\n';
             return 2;
         }
     }
 
-    lv::Simulator sim;
-    sim.reset(seed);
+    // A replay brings its own seed, config and simulator.
+    std::optional<lv::ReplayPlayer> replay;
+    double seek_seconds = 0.0;
+    std::optional<lv::Simulator> simulator;
+    try {
+        if (!replay_path.empty()) {
+            replay.emplace(replay_path);
+            const auto t0 = std::chrono::steady_clock::now();
+            replay->seek(replay_from);
+            seek_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            sim_config = replay->config();
+            seed = replay->seed();
+        } else {
+            simulator.emplace(sim_config);
+            simulator->reset(seed);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 2;
+    }
+    lv::Simulator& sim = replay.has_value() ? replay->simulator() : *simulator;
+
+    std::optional<lv::MlpPolicy> policy;
+    if (!policy_path.empty()) {
+        try {
+            policy.emplace(policy_path);
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to load policy: " << ex.what() << '\n';
+            return 2;
+        }
+        const size_t obs_dim = sim.observation().size();
+        if (policy->obs_dim() != obs_dim || policy->action_dim() != lv::kAgentActionValues) {
+            std::cerr << "Policy expects " << policy->obs_dim() << " observations and " << policy->action_dim()
+                      << " actions; this game has " << obs_dim << " and " << lv::kAgentActionValues << '\n';
+            return 2;
+        }
+        model_name = std::filesystem::path(policy_path).filename().string();
+        // --eval and --seeds keep stdout for their results.
+        (eval_episodes > 0 || seed_range.has_value() ? std::cerr : std::cout)
+            << "Loaded policy " << model_name << " layers=" << policy->layer_count() << '\n';
+    }
+
+    std::optional<lv::TrajectoryWriter> dataset;
+    if (!dataset_dir.empty()) {
+        try {
+            dataset_spec.obs_dim = sim.observation_dim();
+            dataset.emplace(dataset_dir, dataset_spec);
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to create dataset: " << ex.what() << '\n';
+            return 2;
+        }
+    }
+    const auto finish_dataset = [&]() {
+        if (!dataset.has_value()) return true;
+        try {
+            dataset->close();
+            std::cerr << "dataset_rows=" << dataset->rows()
+                      << " dataset_bytes=" << dataset->rows() * dataset->row_bytes() << '\n';
+            return true;
+        } catch (const std::exception& ex) {
+            std::cerr << "Dataset failed: " << ex.what() << '\n';
+            return false;
+        }
+    };
+
+    if (eval_episodes > 0) {
+        lv::EvalConfig eval;
+        eval.sim = sim_config;
+        eval.first_seed = seed;
+        eval.episodes = eval_episodes;
+        eval.threads = threads;
+        eval.max_ticks = max_steps;
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto results = lv::evaluate_policy(
+            eval, [&](std::span<const float> obs, size_t n, std::span<float> out) { policy->forward(obs, n, out); });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        uint64_t steps = 0;
+        for (const auto& r : results) steps += static_cast<uint64_t>(r.steps);
+
+        const std::string report = lv::eval_report_json(results);
+        if (eval_json_path.empty()) {
+            std::cout << report << '\n';
+        } else {
+            std::ofstream out(eval_json_path);
+            out << report << '\n';
+            if (!out) {
+                std::cerr << "Failed to write " << eval_json_path << '\n';
+                return 2;
+            }
+        }
+        std::cerr << "evaluated " << results.size() << " episodes (" << steps << " steps) in " << seconds << " s on "
+                  << threads << " threads, " << static_cast<double>(steps) / seconds << " steps/s\n";
+        return 0;
+    }
+
+    if (seed_range.has_value()) {
+        lv::SweepConfig sweep;
+        sweep.sim = sim_config;
+        sweep.first_seed = seed_range->first;
+        sweep.last_seed = seed_range->second;
+        sweep.threads = threads;
+        sweep.max_ticks = max_steps;
+        sweep.dataset = dataset.has_value() ? &*dataset : nullptr;
+        uint64_t episodes = 0;
+        uint64_t steps = 0;
+        uint64_t deaths = 0;
+        double episode_seconds = 0.0;
+        const auto t0 = std::chrono::steady_clock::now();
+        try {
+            SweepWriter writer(results_path);
+            lv::run_sweep(sweep, policy.has_value() ? &*policy : nullptr, [&](const lv::SweepEpisode& episode) {
+                writer.write(episode);
+                episodes += 1;
+                steps += static_cast<uint64_t>(episode.result.steps);
+                deaths += episode.result.died ? 1 : 0;
+                episode_seconds += episode.wall_s;
+            });
+        } catch (const std::exception& ex) {
+            std::cerr << "Sweep failed: " << ex.what() << '\n';
+            return 2;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "episodes=" << episodes << " steps=" << steps << " deaths=" << deaths << " threads=" << threads
+                  << " wall_s=" << seconds << " episodes_per_s=" << static_cast<double>(episodes) / seconds
+                  << " steps_per_s=" << static_cast<double>(steps) / seconds
+                  << " thread_utilization=" << episode_seconds / (seconds * threads) << '\n';
+        return finish_dataset() ? 0 : 2;
+    }
+
+    std::optional<FrameRecorder> recorder;
+    if (!record_spec.empty()) {
+        // A pipe:COMMAND that exits early should fail the write, not kill us.
+        std::signal(SIGPIPE, SIG_IGN);
+        try {
+            recorder.emplace(record_spec, frame_width, frame_height, record_every);
+            recorder->capture(sim.state());
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to start recording: " << ex.what() << '\n';
+            return 2;
+        }
+    }
+    std::optional<lv::ReplayWriter> replay_writer;
+    if (!replay_out_path.empty()) {
+        try {
+            replay_writer.emplace(replay_out_path, sim_config, seed, static_cast<uint32_t>(keyframe_every));
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to start replay: " << ex.what() << '\n';
+            return 2;
+        }
+    }
+    // Every action source goes through here: a replay stores the quantized
+    // action, so that is the one the simulator has to see.
+    const auto log_action = [&](const lv::Simulator& s, const lv::Action& action) {
+        return replay_writer.has_value() ? replay_writer->record(s, action) : action;
+    };
+    const auto finish_recording = [&]() {
+        bool ok = true;
+        if (recorder.has_value()) {
+            try {
+                std::cout << "recorded_frames=" << recorder->finish() << '\n';
+            } catch (const std::exception& ex) {
+                std::cerr << "Recording failed: " << ex.what() << '\n';
+                ok = false;
+            }
+        }
+        if (replay_writer.has_value()) {
+            try {
+                replay_writer->close(&sim);
+                std::cout << "replay_steps=" << replay_writer->steps()
+                          << " replay_bytes=" << replay_writer->bytes_written() << '\n';
+            } catch (const std::exception& ex) {
+                std::cerr << "Replay failed: " << ex.what() << '\n';
+                ok = false;
+            }
+        }
+        return ok;
+    };
+    // SimThread tick limit: the rest of the replay, else --max-steps.
+    const int tick_limit = replay.has_value() ? static_cast<int>(std::min<uint64_t>(
+                                                    replay->length() - replay->position(),
+                                                    static_cast<uint64_t>(std::numeric_limits<int>::max())))
+                                              : max_steps;
+
+    if (null_render) {
+        std::optional<lv::AsyncAgent> async_agent;
+        if (agent_client) {
+            async_agent.emplace(std::move(agent_client), std::chrono::microseconds(static_cast<int64_t>(
+                                                             agent_deadline_ms * 1000.0f)));
+        }
+        const auto choose = [&](const lv::Simulator& s) {
+            if (replay.has_value()) return replay->next_action();
+            if (policy.has_value()) return policy->act(s.observation());
+            if (async_agent.has_value()) {
+                return async_agent->next_action_or_throw(s.state(), [&] { return s.observation(); });
+            }
+            lv::Action action{};
+            if (s.state().play_state == lv::PlayState::ChoosingUpgrade) action.upgrade_choice = 0;
+            return action;
+        };
+        const auto act = [&](const lv::Simulator& s) { return log_action(s, choose(s)); };
+        const auto after_step = [&](const lv::Simulator& s) {
+            if (recorder.has_value()) recorder->capture(s.state());
+        };
+
+        const auto t0 = std::chrono::steady_clock::now();
+        NullRenderer renderer;
+        {
+            lv::SimThread sim_thread(sim, act, after_step, fast_forward, tick_limit);
+            try {
+                renderer.run(sim_thread);
+            } catch (const std::exception& ex) {
+                std::cerr << "Simulation stopped: " << ex.what() << '\n';
+                return 2;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        const auto& end_state = sim.state();
+        std::cout << "seed=" << seed << " ticks=" << end_state.tick << " kills=" << end_state.stats.kills
+                  << " dead=" << (end_state.play_state == lv::PlayState::Dead ? 1 : 0) << '\n';
+        std::cout << "frames=" << renderer.frames() << " snapshots=" << renderer.snapshots()
+                  << " unseen_ticks=" << renderer.unseen_ticks() << " sim_ticks_per_s=" << end_state.tick / seconds
+                  << '\n';
+        if (async_agent.has_value()) {
+            std::cout << "agent_queries=" << async_agent->queries() << " agent_late=" << async_agent->late()
+                      << " agent_missed=" << async_agent->missed() << '\n';
+        }
+        return finish_recording() ? 0 : 2;
+    }
 
 #ifdef LASTVECTOR_WITH_RAYLIB
     if (!headless) {
@@ -370,43 +701,79 @@ int main(int argc, char** argv) {
 
         Camera2D camera{};
         camera.offset = {GetScreenWidth() * 0.5f, GetScreenHeight() * 0.5f};
-        camera.target = {lv::kPlayerSpawnX, lv::kPlayerSpawnY};
+        camera.target = {sim.state().player.pos.x, sim.state().player.pos.y};
         camera.rotation = 0.0f;
         camera.zoom = 1.0f;
 
+        // The window never waits on the agent for longer than the deadline:
+        // inference runs on the AsyncAgent's I/O thread.
+        std::optional<lv::AsyncAgent> async_agent;
+        if (agent_client) {
+            async_agent.emplace(std::move(agent_client), std::chrono::microseconds(static_cast<int64_t>(
+                                                             agent_deadline_ms * 1000.0f)));
+        }
+
+        // Keyboard and mouse are read once per frame but consumed once per
+        // tick on the simulation thread, so one-shot presses are latched
+        // until a tick picks them up.
+        std::mutex input_mutex;
+        lv::Action input{};
+        const auto choose = [&](const lv::Simulator& s) {
+            if (replay.has_value()) return replay->next_action();
+            if (policy.has_value()) return policy->act(s.observation());
+            if (async_agent.has_value()) {
+                return async_agent->next_action_or_throw(s.state(), [&] { return s.observation(); });
+            }
+            std::lock_guard<std::mutex> lock(input_mutex);
+            const lv::Action action = input;
+            input.reload = false;
+            input.upgrade_choice = -1;
+            return action;
+        };
+        const auto act = [&](const lv::Simulator& s) { return log_action(s, choose(s)); };
+        const auto after_step = [&](const lv::Simulator& s) {
+            if (recorder.has_value()) recorder->capture(s.state());
+        };
+
+        lv::SimThread sim_thread(sim, act, after_step, fast_forward, replay.has_value() ? tick_limit : 0);
+        lv::SnapshotInterpolator interpolator;
+        lv::RenderSnapshot view;
         while (!WindowShouldClose()) {
-            lv::Action action{};
-            if (agent_client.has_value()) {
-                try {
-                    const auto obs = lv::build_observation(sim.state());
-                    action = agent_client->infer_or_throw(obs);
-                } catch (const std::exception& ex) {
-                    std::cerr << "Agent inference failed: " << ex.what() << '\n';
-                    break;
-                }
-            } else {
-                action.move_x = (IsKeyDown(KEY_D) ? 1.0f : 0.0f) - (IsKeyDown(KEY_A) ? 1.0f : 0.0f);
-                action.move_y = (IsKeyDown(KEY_S) ? 1.0f : 0.0f) - (IsKeyDown(KEY_W) ? 1.0f : 0.0f);
-                action.sprint = IsKeyDown(KEY_LEFT_SHIFT);
-                action.reload = IsKeyPressed(KEY_R);
-                action.shoot = IsMouseButtonDown(MOUSE_BUTTON_LEFT);
+            if (IsKeyPressed(KEY_RIGHT_BRACKET)) sim_thread.set_speed(sim_thread.speed() * 2);
+            if (IsKeyPressed(KEY_LEFT_BRACKET)) sim_thread.set_speed(sim_thread.speed() / 2);
 
-                const auto& state = sim.state();
-                const Vector2 mouse_world = GetScreenToWorld2D(GetMousePosition(), camera);
-                action.aim_x = (mouse_world.x - state.player.pos.x) / 300.0f;
-                action.aim_y = (mouse_world.y - state.player.pos.y) / 300.0f;
+            sim_thread.poll();
+            try {
+                sim_thread.rethrow_if_failed();
+            } catch (const std::exception& ex) {
+                std::cerr << "Simulation stopped: " << ex.what() << '\n';
+                break;
+            }
+            interpolator.interpolate(sim_thread.previous(), sim_thread.current(),
+                                     lv::interpolation_alpha(sim_thread.previous(), sim_thread.current(),
+                                                             std::chrono::steady_clock::now()),
+                                     view);
 
-                if (state.play_state == lv::PlayState::ChoosingUpgrade) {
-                    if (IsKeyPressed(KEY_ONE)) action.upgrade_choice = 0;
-                    if (IsKeyPressed(KEY_TWO)) action.upgrade_choice = 1;
-                    if (IsKeyPressed(KEY_THREE)) action.upgrade_choice = 2;
+            if (!replay.has_value() && !policy.has_value() && !async_agent.has_value()) {
+                const Vector2 mouse_world = GetScreenToWorld2D(GetMousePosition(), camera);
+                std::lock_guard<std::mutex> lock(input_mutex);
+                input.move_x = (IsKeyDown(KEY_D) ? 1.0f : 0.0f) - (IsKeyDown(KEY_A) ? 1.0f : 0.0f);
+                input.move_y = (IsKeyDown(KEY_S) ? 1.0f : 0.0f) - (IsKeyDown(KEY_W) ? 1.0f : 0.0f);
+                input.sprint = IsKeyDown(KEY_LEFT_SHIFT);
+                input.reload = input.reload || IsKeyPressed(KEY_R);
+                input.shoot = IsMouseButtonDown(MOUSE_BUTTON_LEFT);
+                input.aim_x = (mouse_world.x - view.player.pos.x) / 300.0f;
+                input.aim_y = (mouse_world.y - view.player.pos.y) / 300.0f;
+
+                if (view.play_state == lv::PlayState::ChoosingUpgrade) {
+                    if (IsKeyPressed(KEY_ONE)) input.upgrade_choice = 0;
+                    if (IsKeyPressed(KEY_TWO)) input.upgrade_choice = 1;
+                    if (IsKeyPressed(KEY_THREE)) input.upgrade_choice = 2;
                 }
             }
 
-            sim.step(action);
-
-            const auto& s = sim.state();
-            const lv::Vec2 look_dir{action.aim_x, action.aim_y};
+            const auto& s = view;
+            const lv::Vec2 look_dir = s.aim;
             const float look_len = std::sqrt(look_dir.x * look_dir.x + look_dir.y * look_dir.y);
             lv::Vec2 look_n = look_dir;
             if (look_len > 1e-5f && std::isfinite(look_len)) {
@@ -427,14 +794,15 @@ int main(int argc, char** argv) {
             ClearBackground(BLACK);
 
             BeginMode2D(camera);
-            DrawRectangleLinesEx({0.0f, 0.0f, lv::kArenaWidth, lv::kArenaHeight}, 2.0f, DARKGRAY);
+            DrawRectangleLinesEx({0.0f, 0.0f, s.arena_size.x, s.arena_size.y}, 2.0f, DARKGRAY);
             DrawCircleV({s.player.pos.x, s.player.pos.y}, 10.0f, GREEN);
             for (const auto& z : s.zombies) DrawCircleV({z.pos.x, z.pos.y}, 10.0f, RED);
             for (const auto& b : s.bullets) DrawCircleV({b.pos.x, b.pos.y}, b.radius, YELLOW);
             for (const auto& o : s.obstacles) DrawRectangleLinesEx({o.x, o.y, o.w, o.h}, 1.0f, GRAY);
 
-            for (int i = 0; i < lv::kRayCount; ++i) {
-                const float theta = (static_cast<float>(i) / static_cast<float>(lv::kRayCount)) * 6.28318530718f;
+            const int ray_count = sim.config().ray_count;
+            for (int i = 0; i < ray_count; ++i) {
+                const float theta = (static_cast<float>(i) / static_cast<float>(ray_count)) * 6.28318530718f;
                 const Vector2 ray_end{
                     s.player.pos.x + std::cos(theta) * 160.0f,
                     s.player.pos.y + std::sin(theta) * 160.0f,
@@ -444,17 +812,27 @@ int main(int argc, char** argv) {
             EndMode2D();
 
             DrawText(TextFormat("HP %.1f  STA %.1f  MAG %d/%d  Kills %d", s.player.health, s.player.stamina, s.player.mag,
-                                s.player.reserve, s.stats.kills),
+                                s.player.reserve, s.kills),
                      16, 16, 20, WHITE);
+            if (sim_thread.speed() > 1) {
+                DrawText(TextFormat("x%d", sim_thread.speed()), GetScreenWidth() - 80, 16, 24, GOLD);
+            }
 
-            if (agent_client.has_value()) {
-                DrawRectangle(14, 42, 430, 138, Fade(BLACK, 0.65f));
+            if (async_agent.has_value() || policy.has_value()) {
+                DrawRectangle(14, 42, 430, async_agent.has_value() ? 172 : 150, Fade(BLACK, 0.65f));
                 DrawText("AI MODE", 24, 50, 26, SKYBLUE);
                 DrawText(TextFormat("Model: %s", model_name.c_str()), 24, 80, 18, LIGHTGRAY);
                 DrawText(TextFormat("HP: %.1f", s.player.health), 24, 104, 18, WHITE);
-                DrawText(TextFormat("Kills: %d", s.stats.kills), 24, 126, 18, WHITE);
+                DrawText(TextFormat("Kills: %d", s.kills), 24, 126, 18, WHITE);
                 DrawText(TextFormat("Time Alive: %.1fs", s.episode_time_s), 24, 148, 18, WHITE);
                 DrawText(TextFormat("Difficulty: %.2f", s.difficulty_scalar), 24, 170, 18, WHITE);
+                if (async_agent.has_value()) {
+                    const bool lagging = async_agent->missed() > 0;
+                    DrawText(TextFormat("Agent late: %llu  missed: %llu",
+                                        static_cast<unsigned long long>(async_agent->late()),
+                                        static_cast<unsigned long long>(async_agent->missed())),
+                             24, 192, 18, lagging ? ORANGE : LIGHTGRAY);
+                }
             }
 
             if (s.play_state == lv::PlayState::ChoosingUpgrade) {
@@ -467,22 +845,33 @@ int main(int argc, char** argv) {
 
             EndDrawing();
 
-            if (s.play_state == lv::PlayState::Dead) {
+            // Quit once the final snapshot has been shown.
+            if (sim_thread.finished() && !sim_thread.poll()) {
                 break;
             }
         }
 
+        sim_thread.stop();
         CloseWindow();
-        return 0;
+        if (async_agent.has_value()) {
+            std::cout << "agent_queries=" << async_agent->queries() << " agent_late=" << async_agent->late()
+                      << " agent_missed=" << async_agent->missed() << '\n';
+        }
+        return finish_recording() ? 0 : 2;
     }
 #endif
 
-    for (int i = 0; i < max_steps; ++i) {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<float> obs;
+    for (int i = 0; replay.has_value() ? !replay->at_end() : i < max_steps; ++i) {
         lv::Action action{};
-        if (agent_client.has_value()) {
+        if (replay.has_value()) {
+            action = replay->next_action();
+        } else if (policy.has_value()) {
+            action = policy->act(sim.observation());
+        } else if (agent_client) {
             try {
-                const auto obs = lv::build_observation(sim.state());
-                action = agent_client->infer_or_throw(obs);
+                action = agent_client->next_action_or_throw(sim.state(), [&] { return sim.observation(); });
             } catch (const std::exception& ex) {
                 std::cerr << "Agent inference failed: " << ex.what() << '\n';
                 return 2;
@@ -491,7 +880,25 @@ int main(int argc, char** argv) {
             action.upgrade_choice = 0;
         }
 
+        if (dataset.has_value()) obs = sim.observation();
+        action = log_action(sim, action);
         const auto res = sim.step(action);
+        if (dataset.has_value()) {
+            try {
+                dataset->append(seed, 0, static_cast<uint32_t>(i), obs, action, res);
+            } catch (const std::exception& ex) {
+                std::cerr << "Dataset failed: " << ex.what() << '\n';
+                return 2;
+            }
+        }
+        if (recorder.has_value()) {
+            try {
+                recorder->capture(sim.state());
+            } catch (const std::exception& ex) {
+                std::cerr << "Recording failed: " << ex.what() << '\n';
+                return 2;
+            }
+        }
         if (res.terminated || res.truncated) {
             break;
         }
@@ -500,5 +907,15 @@ int main(int argc, char** argv) {
     const auto& end_state = sim.state();
     std::cout << "seed=" << seed << " ticks=" << end_state.tick << " kills=" << end_state.stats.kills
               << " dead=" << (end_state.play_state == lv::PlayState::Dead ? 1 : 0) << '\n';
-    return 0;
+    if (agent_client) {
+        std::cout << "agent_queries=" << agent_client->queries() << '\n';
+    }
+    if (replay.has_value()) {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "replay_from=" << replay_from << " replay_steps=" << replay->length()
+                  << " seek_ms=" << seek_seconds * 1000.0 << " ticks_per_s="
+                  << static_cast<double>(replay->length() - replay_from) / seconds << '\n';
+    }
+    const bool recorded = finish_recording();
+    return finish_dataset() && recorded ? 0 : 2;
 }
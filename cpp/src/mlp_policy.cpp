@@ -0,0 +1,209 @@
+#include "lastvector/mlp_policy.hpp"
+#include "lastvector/agent_protocol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace lv {
+
+namespace {
+
+constexpr uint32_t kMlpMagic = 0x504d564c; // "LVMP"
+constexpr uint32_t kMlpVersion = 1;
+constexpr size_t kMaxLayerWidth = 1 << 16;
+
+// Register tile of the GEMM kernel: kRowBlock observations x kOutBlock
+// outputs of accumulators stay in registers while the layer's transposed
+// weight rows stream through once per tile, and each weight is loaded once
+// for all kRowBlock observations. The whole batch runs one layer at a time,
+// so that layer's weights stay in cache across the batch.
+constexpr size_t kOutBlock = 16;
+constexpr size_t kRowBlock = 4;
+
+class Reader {
+  public:
+    Reader(std::vector<char> bytes, const std::string& path) : bytes_(std::move(bytes)), path_(path) {}
+
+    uint32_t u32() {
+        std::array<uint8_t, 4> b{};
+        take(b.data(), b.size());
+        return static_cast<uint32_t>(b[0]) | static_cast<uint32_t>(b[1]) << 8 | static_cast<uint32_t>(b[2]) << 16 |
+               static_cast<uint32_t>(b[3]) << 24;
+    }
+
+    float f32() { return std::bit_cast<float>(u32()); }
+
+    bool at_end() const { return pos_ == bytes_.size(); }
+    size_t remaining() const { return bytes_.size() - pos_; }
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("policy file '" + path_ + "': " + what);
+    }
+
+  private:
+    void take(uint8_t* dst, size_t n) {
+        if (bytes_.size() - pos_ < n) fail("truncated");
+        std::memcpy(dst, bytes_.data() + pos_, n);
+        pos_ += n;
+    }
+
+    std::vector<char> bytes_;
+    std::string path_;
+    size_t pos_ = 0;
+};
+
+size_t round_up(size_t n, size_t block) { return (n + block - 1) / block * block; }
+
+// out[r][o] = bias[o] + sum_i in[r][i] * w[i][o], rows of `in` and `out` laid
+// out with strides in_stride and layer.stride.
+template <size_t Rows>
+void gemm_tile(const float* in, size_t in_stride, size_t inputs, const float* weights, const float* bias,
+               size_t stride, float* out) {
+    for (size_t ob = 0; ob < stride; ob += kOutBlock) {
+        float acc[Rows * kOutBlock];
+        for (size_t r = 0; r < Rows; ++r) {
+            std::memcpy(acc + r * kOutBlock, bias + ob, sizeof(float) * kOutBlock);
+        }
+        for (size_t i = 0; i < inputs; ++i) {
+            const float* w = weights + i * stride + ob;
+            float x[Rows];
+            for (size_t r = 0; r < Rows; ++r) x[r] = in[r * in_stride + i];
+            for (size_t o = 0; o < kOutBlock; ++o) {
+                const float wo = w[o];
+                for (size_t r = 0; r < Rows; ++r) acc[r * kOutBlock + o] += x[r] * wo;
+            }
+        }
+        for (size_t r = 0; r < Rows; ++r) {
+            std::memcpy(out + r * stride + ob, acc + r * kOutBlock, sizeof(float) * kOutBlock);
+        }
+    }
+}
+
+// Rational minimax tanh (the approximation Eigen uses for float), within
+// 4e-7 of the exact value. Unlike std::tanh it has no call or branch, so the
+// activation loop vectorizes; libm tanh cost more than the matrix products.
+float fast_tanh(float x) {
+    constexpr float kClamp = 7.90531110763549805f;
+    const float xc = std::clamp(x, -kClamp, kClamp);
+    const float x2 = xc * xc;
+    float p = -2.76076847742355e-16f;
+    p = p * x2 + 2.00018790482477e-13f;
+    p = p * x2 - 8.60467152213735e-11f;
+    p = p * x2 + 5.12229709037114e-08f;
+    p = p * x2 + 1.48572235717979e-05f;
+    p = p * x2 + 6.37261928875436e-04f;
+    p = p * x2 + 4.89352455891786e-03f;
+    float q = 1.19825839466702e-06f;
+    q = q * x2 + 1.18534705686654e-04f;
+    q = q * x2 + 2.26843463243900e-03f;
+    q = q * x2 + 4.89352518554385e-03f;
+    const float y = xc * p / q;
+    return std::fabs(x) < 0.0004f ? x : y;
+}
+
+void apply_activation(MlpActivation activation, float* values, size_t n) {
+    if (activation == MlpActivation::Tanh) {
+        for (size_t i = 0; i < n; ++i) values[i] = fast_tanh(values[i]);
+    } else {
+        for (size_t i = 0; i < n; ++i) values[i] = std::max(values[i], 0.0f);
+    }
+}
+
+} // namespace
+
+MlpPolicy::MlpPolicy(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("cannot open policy file '" + path + "'");
+    Reader reader(std::vector<char>(std::istreambuf_iterator<char>(file), {}), path);
+
+    if (reader.u32() != kMlpMagic) reader.fail("not an exported MlpPolicy (bad magic)");
+    const uint32_t version = reader.u32();
+    if (version != kMlpVersion) reader.fail("unsupported version " + std::to_string(version));
+    obs_dim_ = reader.u32();
+    action_dim_ = reader.u32();
+    const uint32_t layer_count = reader.u32();
+    const uint32_t activation = reader.u32();
+    if (activation > static_cast<uint32_t>(MlpActivation::Relu)) {
+        reader.fail("unknown activation " + std::to_string(activation));
+    }
+    activation_ = static_cast<MlpActivation>(activation);
+    if (layer_count < 1 || layer_count > 64) reader.fail("layer count " + std::to_string(layer_count));
+    if (obs_dim_ < 1 || obs_dim_ > kMaxLayerWidth) reader.fail("obs_dim " + std::to_string(obs_dim_));
+
+    size_t expected_inputs = obs_dim_;
+    for (uint32_t l = 0; l < layer_count; ++l) {
+        Layer layer;
+        layer.inputs = reader.u32();
+        layer.outputs = reader.u32();
+        if (layer.inputs != expected_inputs || layer.outputs < 1 || layer.outputs > kMaxLayerWidth) {
+            reader.fail("layer " + std::to_string(l) + " is " + std::to_string(layer.inputs) + "x" +
+                        std::to_string(layer.outputs) + ", expected " + std::to_string(expected_inputs) + " inputs");
+        }
+        // Sizes come from the file: make sure it holds them before allocating.
+        if (reader.remaining() / sizeof(float) / layer.outputs < layer.inputs + 1) reader.fail("truncated");
+        layer.stride = round_up(layer.outputs, kOutBlock);
+        layer.weights.assign(layer.inputs * layer.stride, 0.0f);
+        layer.bias.assign(layer.stride, 0.0f);
+        for (size_t o = 0; o < layer.outputs; ++o) {
+            for (size_t i = 0; i < layer.inputs; ++i) layer.weights[i * layer.stride + o] = reader.f32();
+        }
+        for (size_t o = 0; o < layer.outputs; ++o) layer.bias[o] = reader.f32();
+        expected_inputs = layer.outputs;
+        layers_.push_back(std::move(layer));
+    }
+    if (expected_inputs != action_dim_) reader.fail("last layer does not produce action_dim outputs");
+    if (!reader.at_end()) reader.fail("trailing bytes");
+}
+
+void MlpPolicy::forward(std::span<const float> obs, size_t batch, std::span<float> out) {
+    if (obs.size() != batch * obs_dim_ || out.size() != batch * action_dim_) {
+        throw std::invalid_argument("MlpPolicy::forward expects " + std::to_string(batch) + "x" +
+                                    std::to_string(obs_dim_) + " observations and " + std::to_string(batch) + "x" +
+                                    std::to_string(action_dim_) + " outputs");
+    }
+    if (batch == 0) return;
+
+    const float* in = obs.data();
+    size_t in_stride = obs_dim_;
+    for (size_t l = 0; l < layers_.size(); ++l) {
+        const Layer& layer = layers_[l];
+        std::vector<float>& dst = (l % 2 == 0) ? scratch_a_ : scratch_b_;
+        if (dst.size() < batch * layer.stride) dst.resize(batch * layer.stride);
+
+        size_t r = 0;
+        for (; r + kRowBlock <= batch; r += kRowBlock) {
+            gemm_tile<kRowBlock>(in + r * in_stride, in_stride, layer.inputs, layer.weights.data(), layer.bias.data(),
+                                 layer.stride, dst.data() + r * layer.stride);
+        }
+        for (; r < batch; ++r) {
+            gemm_tile<1>(in + r * in_stride, in_stride, layer.inputs, layer.weights.data(), layer.bias.data(),
+                         layer.stride, dst.data() + r * layer.stride);
+        }
+        if (l + 1 < layers_.size()) apply_activation(activation_, dst.data(), batch * layer.stride);
+
+        in = dst.data();
+        in_stride = layer.stride;
+    }
+
+    for (size_t b = 0; b < batch; ++b) {
+        std::memcpy(out.data() + b * action_dim_, in + b * in_stride, action_dim_ * sizeof(float));
+    }
+}
+
+Action MlpPolicy::act(std::span<const float> obs) {
+    if (action_dim_ != kAgentActionValues) {
+        throw std::invalid_argument("MlpPolicy::act needs an 8-value action head, got " + std::to_string(action_dim_));
+    }
+    std::array<float, kAgentActionValues> values{};
+    forward(obs, 1, values);
+    return decode_action(values);
+}
+
+} // namespace lv
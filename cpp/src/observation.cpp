@@ -1,12 +1,9 @@
 #include "lastvector/observation.hpp"
 #include "lastvector/collision.hpp"
 #include "lastvector/config.hpp"
-#include "lastvector/sim.hpp"
 
 #include <algorithm>
-#include <cassert>
 #include <cmath>
-#include <limits>
 
 namespace lv {
 
@@ -15,12 +12,9 @@ float len(Vec2 v) {
     return std::sqrt(v.x * v.x + v.y * v.y);
 }
 
-constexpr float kRayMaxRange = (kArenaWidth > kArenaHeight) ? kArenaWidth : kArenaHeight;
-constexpr float kTwoPi = 6.28318530718f;
-
-float normalize_ray_t(float t_hit) {
+float normalize_ray_t(float t_hit, float max_range) {
     if (!std::isfinite(t_hit)) return 1.0f;
-    return std::clamp(t_hit / kRayMaxRange, 0.0f, 1.0f);
+    return std::clamp(t_hit / max_range, 0.0f, 1.0f);
 }
 
 float safe_normalize(float value, float scale) {
@@ -33,94 +27,105 @@ float safe_normalize(float value, float scale) {
 float finite_or_zero(float value) {
     return std::isfinite(value) ? value : 0.0f;
 }
+
 } // namespace
 
-std::vector<float> build_observation(const GameState& state) {
-    std::vector<float> obs;
-    obs.reserve(16 + kZombieObsCount * 5 + (kRayCount * 2) + 36);
+static_assert(observation_dim_for(kZombieObsCount, kRayCount) == ObservationLayout<kZombieObsCount, kRayCount>::kDim);
 
-    const auto& p = state.player;
-    obs.push_back(safe_normalize(p.pos.x, kArenaWidth));
-    obs.push_back(safe_normalize(p.pos.y, kArenaHeight));
-    obs.push_back(safe_normalize(p.vel.x, 400.0f));
-    obs.push_back(safe_normalize(p.vel.y, 400.0f));
-    obs.push_back(safe_normalize(p.health, std::max(1.0f, p.max_health)));
-    obs.push_back(safe_normalize(p.stamina, std::max(1.0f, p.max_stamina)));
-    obs.push_back(static_cast<float>(p.mag) / std::max(1, p.mag_capacity));
-    obs.push_back(safe_normalize(static_cast<float>(p.reserve), 300.0f));
-    obs.push_back(finite_or_zero(p.shoot_cd));
-    obs.push_back(finite_or_zero(p.reload_timer));
-    obs.push_back(finite_or_zero(p.invuln_timer));
-
-    std::vector<std::pair<float, const Zombie*>> near;
-    near.reserve(state.zombies.size());
-    for (const auto& z : state.zombies) {
-        const float dx = z.pos.x - p.pos.x;
-        const float dy = z.pos.y - p.pos.y;
-        near.push_back({dx * dx + dy * dy, &z});
-    }
-    std::sort(near.begin(), near.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+template <int NZombies, int NRays>
+void write_observation(const GameState& state,
+                       const BasicZombieSweep<NZombies, NRays>& sweep,
+                       const ObstacleField* field,
+                       std::span<float, ObservationLayout<NZombies, NRays>::kDim> out) {
+    using Layout = ObservationLayout<NZombies, NRays>;
+
+    const float arena_w = state.arena_size.x;
+    const float arena_h = state.arena_size.y;
+    const float ray_max_range = std::max(arena_w, arena_h);
 
-    for (int i = 0; i < kZombieObsCount; ++i) {
-        if (i < static_cast<int>(near.size())) {
-            const Zombie& z = *near[i].second;
+    const auto& p = state.player;
+    float* player = out.data() + Layout::kPlayerOffset;
+    player[0] = safe_normalize(p.pos.x, arena_w);
+    player[1] = safe_normalize(p.pos.y, arena_h);
+    player[2] = safe_normalize(p.vel.x, 400.0f);
+    player[3] = safe_normalize(p.vel.y, 400.0f);
+    player[4] = safe_normalize(p.health, std::max(1.0f, p.max_health));
+    player[5] = safe_normalize(p.stamina, std::max(1.0f, p.max_stamina));
+    player[6] = static_cast<float>(p.mag) / std::max(1, p.mag_capacity);
+    player[7] = safe_normalize(static_cast<float>(p.reserve), 300.0f);
+    player[8] = finite_or_zero(p.shoot_cd);
+    player[9] = finite_or_zero(p.reload_timer);
+    player[10] = finite_or_zero(p.invuln_timer);
+
+    for (int i = 0; i < NZombies; ++i) {
+        float* slot = out.data() + Layout::zombie_offset(i);
+        if (i < sweep.nearest_count) {
+            const Zombie& z = state.zombies[sweep.nearest_index[static_cast<size_t>(i)]];
             const Vec2 rel{z.pos.x - p.pos.x, z.pos.y - p.pos.y};
-            obs.push_back(safe_normalize(rel.x, kArenaWidth));
-            obs.push_back(safe_normalize(rel.y, kArenaHeight));
-            obs.push_back(safe_normalize(len(rel), 500.0f));
-            obs.push_back(safe_normalize(z.vel.x - p.vel.x, 400.0f));
-            obs.push_back(safe_normalize(z.vel.y - p.vel.y, 400.0f));
+            slot[0] = safe_normalize(rel.x, arena_w);
+            slot[1] = safe_normalize(rel.y, arena_h);
+            slot[2] = safe_normalize(len(rel), 500.0f);
+            slot[3] = safe_normalize(z.vel.x - p.vel.x, 400.0f);
+            slot[4] = safe_normalize(z.vel.y - p.vel.y, 400.0f);
         } else {
-            obs.insert(obs.end(), {0, 0, 1, 0, 0});
+            slot[0] = 0.0f;
+            slot[1] = 0.0f;
+            slot[2] = 1.0f;
+            slot[3] = 0.0f;
+            slot[4] = 0.0f;
         }
     }
 
-    const Obstacle arena_bounds{0.0f, 0.0f, kArenaWidth, kArenaHeight};
-    for (int i = 0; i < kRayCount; ++i) {
-        const float theta = (static_cast<float>(i) / static_cast<float>(kRayCount)) * kTwoPi;
-        const Vec2 dir{std::cos(theta), std::sin(theta)};
+    const Obstacle arena_bounds{0.0f, 0.0f, arena_w, arena_h};
+    const auto& dirs = ray_directions<NRays>();
+    for (int i = 0; i < NRays; ++i) {
+        const Vec2 dir = dirs[static_cast<size_t>(i)];
 
         float obstacle_t = ray_intersect_aabb(p.pos, dir, arena_bounds);
-        for (const auto& obstacle : state.obstacles) {
-            obstacle_t = std::min(obstacle_t, ray_intersect_aabb(p.pos, dir, obstacle));
+        if (field != nullptr) {
+            obstacle_t = field->raycast(p.pos, dir, obstacle_t);
+        } else {
+            for (const auto& obstacle : state.obstacles) {
+                obstacle_t = std::min(obstacle_t, ray_intersect_aabb(p.pos, dir, obstacle));
+            }
         }
 
-        float zombie_t = std::numeric_limits<float>::infinity();
-        for (const auto& z : state.zombies) {
-            zombie_t = std::min(zombie_t, ray_intersect_circle(p.pos, dir, z.pos, kZombieRadius));
-        }
+        const float zombie_t = sweep.ray_t[static_cast<size_t>(i)];
 
-        obs.push_back(normalize_ray_t(std::min(obstacle_t, kRayMaxRange)));
-        obs.push_back(normalize_ray_t(std::min(zombie_t, kRayMaxRange)));
+        float* ray = out.data() + Layout::ray_offset(i);
+        ray[0] = normalize_ray_t(std::min(obstacle_t, ray_max_range), ray_max_range);
+        ray[1] = normalize_ray_t(std::min(zombie_t, ray_max_range), ray_max_range);
     }
 
-    obs.push_back(finite_or_zero(state.difficulty_scalar));
+    out[Layout::kDifficultyOffset] = finite_or_zero(state.difficulty_scalar);
     const bool choosing_upgrade = state.play_state == PlayState::ChoosingUpgrade;
-    obs.push_back(choosing_upgrade ? 1.0f : 0.0f);
+    out[Layout::kChoosingUpgradeOffset] = choosing_upgrade ? 1.0f : 0.0f;
 
-    if (choosing_upgrade) {
-        const float denom = std::max(1.0f, static_cast<float>(static_cast<int>(UpgradeId::Count) - 1));
-        for (int i = 0; i < 3; ++i) {
-            const int upgrade_id = static_cast<int>(state.upgrade_offer[static_cast<size_t>(i)]);
-            obs.push_back(static_cast<float>(upgrade_id) / denom);
-        }
-    } else {
-        obs.insert(obs.end(), {0.0f, 0.0f, 0.0f});
+    const float denom = std::max(1.0f, static_cast<float>(static_cast<int>(UpgradeId::Count) - 1));
+    for (int i = 0; i < Layout::kUpgradeOfferFields; ++i) {
+        const int upgrade_id = static_cast<int>(state.upgrade_offer[static_cast<size_t>(i)]);
+        out[Layout::kUpgradeOfferOffset + i] = choosing_upgrade ? static_cast<float>(upgrade_id) / denom : 0.0f;
     }
 
-    for (int lv : state.upgrades.levels) {
-        obs.push_back(static_cast<float>(lv) / 5.0f);
+    for (int i = 0; i < Layout::kUpgradeLevelFields; ++i) {
+        out[Layout::kUpgradeLevelOffset + i] = static_cast<float>(state.upgrades.levels[static_cast<size_t>(i)]) / 5.0f;
     }
 
-    for (float& value : obs) {
+    for (float& value : out) {
         if (!std::isfinite(value)) {
             value = 0.0f;
         }
     }
+}
 
-    assert(static_cast<int>(obs.size()) == Simulator::observation_dim());
+#define LV_INSTANTIATE_OBS_LAYOUT(Z, R) \
+    template void write_observation<Z, R>(const GameState&, const BasicZombieSweep<Z, R>&, const ObstacleField*, \
+                                          std::span<float, ObservationLayout<Z, R>::kDim>);
+LV_FOR_EACH_OBS_LAYOUT(LV_INSTANTIATE_OBS_LAYOUT)
+#undef LV_INSTANTIATE_OBS_LAYOUT
 
-    return obs;
+std::vector<float> build_observation(const GameState& state) {
+    return build_observation<kZombieObsCount, kRayCount>(state);
 }
 
 } // namespace lv
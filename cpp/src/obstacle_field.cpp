@@ -0,0 +1,136 @@
+#include "lastvector/obstacle_field.hpp"
+#include "lastvector/collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace lv {
+
+namespace {
+// Candidates cover every obstacle within this distance of a cell, so one exact
+// refinement clears the next kObstacleFieldReach of a ray. It also bounds how
+// far a circle may be pushed before the candidate list stops being enough.
+constexpr float kObstacleFieldReach = 40.0f;
+// Slack for rounding in sampled ray points and accumulated pushes.
+constexpr float kObstacleFieldMargin = 0.5f;
+
+bool same_obstacles(const std::vector<Obstacle>& a, const std::vector<Obstacle>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Obstacle& l, const Obstacle& r) {
+        return l.x == r.x && l.y == r.y && l.w == r.w && l.h == r.h;
+    });
+}
+
+// Exact distance between two axis-aligned rectangles (0 when they overlap).
+float rect_distance(float x0, float y0, float x1, float y1, const Obstacle& box) {
+    const float gap_x = std::max({0.0f, box.x - x1, x0 - (box.x + box.w)});
+    const float gap_y = std::max({0.0f, box.y - y1, y0 - (box.y + box.h)});
+    return std::sqrt(gap_x * gap_x + gap_y * gap_y);
+}
+
+} // namespace
+
+void ObstacleField::build(const std::vector<Obstacle>& obstacles, Vec2 arena_size, float cell_size) {
+    if (cell_size == cell_size_ && arena_size.x == arena_size_.x && arena_size.y == arena_size_.y &&
+        same_obstacles(obstacles, obstacles_)) {
+        return;
+    }
+    if (obstacles.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::length_error("ObstacleField supports at most 65535 obstacles");
+    }
+
+    obstacles_ = obstacles;
+    arena_size_ = arena_size;
+    cell_size_ = cell_size;
+    clearance_.clear();
+    candidate_start_.clear();
+    candidates_.clear();
+    cols_ = 0;
+    rows_ = 0;
+    if (cell_size <= 0.0f) return;
+
+    inv_cell_size_ = 1.0f / cell_size;
+    cols_ = std::max(1, static_cast<int>(std::ceil(arena_size.x * inv_cell_size_)));
+    rows_ = std::max(1, static_cast<int>(std::ceil(arena_size.y * inv_cell_size_)));
+    const size_t cells = static_cast<size_t>(cols_) * static_cast<size_t>(rows_);
+
+    clearance_.assign(cells, std::numeric_limits<float>::infinity());
+    candidate_start_.assign(cells + 1, 0);
+    for (int cy = 0; cy < rows_; ++cy) {
+        for (int cx = 0; cx < cols_; ++cx) {
+            const size_t cell = static_cast<size_t>(cy * cols_ + cx);
+            const float x0 = static_cast<float>(cx) * cell_size;
+            const float y0 = static_cast<float>(cy) * cell_size;
+            for (size_t k = 0; k < obstacles_.size(); ++k) {
+                const float d = rect_distance(x0, y0, x0 + cell_size, y0 + cell_size, obstacles_[k]);
+                clearance_[cell] = std::min(clearance_[cell], d);
+                if (d <= kObstacleFieldReach) candidates_.push_back(static_cast<uint16_t>(k));
+            }
+            candidate_start_[cell + 1] = static_cast<uint32_t>(candidates_.size());
+        }
+    }
+}
+
+size_t ObstacleField::cell_index(Vec2 p) const {
+    const int cx = std::clamp(static_cast<int>(p.x * inv_cell_size_), 0, cols_ - 1);
+    const int cy = std::clamp(static_cast<int>(p.y * inv_cell_size_), 0, rows_ - 1);
+    return static_cast<size_t>(cy * cols_ + cx);
+}
+
+float ObstacleField::raycast(Vec2 origin, Vec2 dir, float t_limit) const {
+    float t_best = t_limit;
+    if (empty()) {
+        for (const auto& obstacle : obstacles_) t_best = std::min(t_best, ray_intersect_aabb(origin, dir, obstacle));
+        return t_best;
+    }
+
+    // Sphere trace: every obstacle touching [t, t + step) is either ruled out
+    // by the clearance or among the refined candidates, so the obstacles never
+    // tested cannot beat t_best. Sampled points may stray outside the arena by
+    // rounding only; the margin covers the clamped lookup.
+    float t = 0.0f;
+    while (t < t_best) {
+        const size_t cell = cell_index({origin.x + dir.x * t, origin.y + dir.y * t});
+        const float clearance = clearance_[cell];
+        if (clearance >= kObstacleFieldReach) {
+            t += clearance - kObstacleFieldMargin;
+            continue;
+        }
+        for (const uint16_t k : candidates(cell)) {
+            t_best = std::min(t_best, ray_intersect_aabb(origin, dir, obstacles_[k]));
+        }
+        t += kObstacleFieldReach - kObstacleFieldMargin;
+    }
+    return t_best;
+}
+
+void ObstacleField::resolve_circle(Vec2& center, float radius) const {
+    const auto resolve_all = [&] {
+        for (const auto& obstacle : obstacles_) circle_vs_aabb_resolve(center, radius, obstacle);
+    };
+    const bool inside = center.x >= 0.0f && center.x < arena_size_.x && center.y >= 0.0f && center.y < arena_size_.y;
+    if (empty() || !inside) {
+        resolve_all();
+        return;
+    }
+
+    const size_t cell = cell_index(center);
+    if (clearance_[cell] > radius + kObstacleFieldMargin) return;
+
+    // Candidates are applied in the same (index) order as the full loop. The
+    // skipped obstacles are out of reach unless the pushes moved the circle
+    // far, in which case the full loop reruns from the start.
+    const Vec2 start = center;
+    float moved = 0.0f;
+    for (const uint16_t k : candidates(cell)) {
+        const Vec2 before = center;
+        circle_vs_aabb_resolve(center, radius, obstacles_[k]);
+        moved += std::abs(center.x - before.x) + std::abs(center.y - before.y);
+    }
+    if (moved + radius + kObstacleFieldMargin < kObstacleFieldReach) return;
+    center = start;
+    resolve_all();
+}
+
+} // namespace lv
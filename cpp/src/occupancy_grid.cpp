@@ -0,0 +1,141 @@
+#include "lastvector/occupancy_grid.hpp"
+#include "lastvector/int_round.hpp"
+#include "lastvector/upgrade.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace lv {
+
+namespace {
+constexpr uint8_t kOccupied = 255;
+
+// Marks the cells of an n x n plane whose centers lie inside the circle
+// (center and radius in cell units, relative to the plane origin). Each row is
+// one contiguous span filled with a single memset (vector stores for the wide
+// rows of the Ring of Fire disc).
+void fill_disc(uint8_t* plane, int n, Vec2 c, float r) {
+    if (c.x + r < 0.0f || c.y + r < 0.0f || c.x - r > static_cast<float>(n) || c.y - r > static_cast<float>(n)) return;
+
+    const float r_sq = r * r;
+    const int y0 = std::max(0, ceil_int(c.y - r - 0.5f));
+    const int y1 = std::min(n - 1, floor_int(c.y + r - 0.5f));
+    for (int y = y0; y <= y1; ++y) {
+        const float dy = static_cast<float>(y) + 0.5f - c.y;
+        const float span_sq = r_sq - dy * dy;
+        if (span_sq < 0.0f) continue;
+        const float half = std::sqrt(span_sq);
+        const int x0 = std::max(0, ceil_int(c.x - half - 0.5f));
+        const int x1 = std::min(n - 1, floor_int(c.x + half - 0.5f));
+        if (x0 <= x1) std::memset(plane + static_cast<size_t>(y) * n + x0, kOccupied, static_cast<size_t>(x1 - x0 + 1));
+    }
+
+    const int cx = floor_int(c.x);
+    const int cy = floor_int(c.y);
+    if (cx >= 0 && cx < n && cy >= 0 && cy < n) plane[static_cast<size_t>(cy) * n + cx] = kOccupied;
+}
+
+} // namespace
+
+OccupancyGrid::OccupancyGrid(int size, float cell_size)
+    : size_(size), cell_size_(cell_size), inv_cell_size_(1.0f / cell_size) {
+    if (size <= 0) throw std::invalid_argument("OccupancyGrid: size must be positive");
+    if (!(cell_size > 0.0f) || !std::isfinite(cell_size)) {
+        throw std::invalid_argument("OccupancyGrid: cell_size must be positive");
+    }
+}
+
+void OccupancyGrid::build_static(const std::vector<Obstacle>& obstacles, Vec2 arena_size) {
+    const bool same = !static_layer_.empty() && arena_size.x == arena_size_.x && arena_size.y == arena_size_.y &&
+                      std::equal(obstacles.begin(), obstacles.end(), obstacles_.begin(), obstacles_.end(),
+                                 [](const Obstacle& l, const Obstacle& r) {
+                                     return l.x == r.x && l.y == r.y && l.w == r.w && l.h == r.h;
+                                 });
+    if (same) return;
+
+    obstacles_ = obstacles;
+    arena_size_ = arena_size;
+    // A border of one full window keeps every crop around a player inside the
+    // arena within the layer.
+    border_ = size_;
+    const int arena_cols = ceil_int(arena_size.x * inv_cell_size_);
+    const int arena_rows = ceil_int(arena_size.y * inv_cell_size_);
+    static_cols_ = arena_cols + 2 * border_;
+    static_rows_ = arena_rows + 2 * border_;
+    static_layer_.assign(static_cast<size_t>(static_cols_) * static_rows_, kOccupied);
+
+    // Cells are addressed in world cells; a world cell belongs to a rectangle
+    // when its center does. Cells centered outside the arena stay walls.
+    const auto span = [&](float lo, float hi, int count) {
+        const int first = std::max(-border_, ceil_int(lo * inv_cell_size_ - 0.5f));
+        const int last = std::min(count + border_, ceil_int(hi * inv_cell_size_ - 0.5f)) - 1;
+        return std::pair{first, last};
+    };
+    const auto fill_rect = [&](float x, float y, float w, float h, uint8_t value) {
+        const auto [x0, x1] = span(x, x + w, arena_cols);
+        const auto [y0, y1] = span(y, y + h, arena_rows);
+        for (int cy = y0; cy <= y1; ++cy) {
+            if (x0 > x1) break;
+            uint8_t* row = static_layer_.data() + static_cast<size_t>(cy + border_) * static_cols_ + border_;
+            std::memset(row + x0, value, static_cast<size_t>(x1 - x0 + 1));
+        }
+    };
+    fill_rect(0.0f, 0.0f, arena_size.x, arena_size.y, 0);
+    for (const auto& o : obstacles_) {
+        fill_rect(o.x, o.y, o.w, o.h, kOccupied);
+        const int cx = floor_int((o.x + o.w * 0.5f) * inv_cell_size_);
+        const int cy = floor_int((o.y + o.h * 0.5f) * inv_cell_size_);
+        if (cx >= -border_ && cx < arena_cols + border_ && cy >= -border_ && cy < arena_rows + border_) {
+            static_layer_[static_cast<size_t>(cy + border_) * static_cols_ + cx + border_] = kOccupied;
+        }
+    }
+}
+
+void OccupancyGrid::write(const GameState& state, std::span<uint8_t> out) const {
+    if (out.size() != dim()) {
+        throw std::invalid_argument("occupancy buffer has " + std::to_string(out.size()) + " bytes, expected " +
+                                    std::to_string(dim()));
+    }
+    const int n = size_;
+    const size_t plane_size = static_cast<size_t>(n) * n;
+    const auto plane = [&](OccupancyChannel c) { return out.data() + static_cast<size_t>(c) * plane_size; };
+
+    // Window origin in world cells, clamped so the crop stays inside the layer.
+    const Vec2 p = state.player.pos;
+    const int px = std::isfinite(p.x) ? floor_int(std::clamp(p.x * inv_cell_size_, -1e6f, 1e6f)) : 0;
+    const int py = std::isfinite(p.y) ? floor_int(std::clamp(p.y * inv_cell_size_, -1e6f, 1e6f)) : 0;
+    const int ox = std::clamp(px - n / 2, -border_, std::max(-border_, static_cols_ - border_ - n));
+    const int oy = std::clamp(py - n / 2, -border_, std::max(-border_, static_rows_ - border_ - n));
+
+    uint8_t* obstacles = plane(OccupancyChannel::Obstacles);
+    if (static_layer_.empty()) {
+        std::memset(obstacles, 0, plane_size);
+    } else {
+        for (int y = 0; y < n; ++y) {
+            const uint8_t* src = static_layer_.data() + static_cast<size_t>(oy + border_ + y) * static_cols_ + (ox + border_);
+            std::memcpy(obstacles + static_cast<size_t>(y) * n, src, static_cast<size_t>(n));
+        }
+    }
+    std::memset(plane(OccupancyChannel::Zombies), 0, plane_size * (kOccupancyChannels - 1));
+
+    const Vec2 origin{static_cast<float>(ox) * cell_size_, static_cast<float>(oy) * cell_size_};
+    const auto to_cells = [&](Vec2 w) { return Vec2{(w.x - origin.x) * inv_cell_size_, (w.y - origin.y) * inv_cell_size_}; };
+
+    uint8_t* zombies = plane(OccupancyChannel::Zombies);
+    const float zombie_r = kZombieRadius * inv_cell_size_;
+    for (const auto& z : state.zombies) fill_disc(zombies, n, to_cells(z.pos), zombie_r);
+
+    uint8_t* bullets = plane(OccupancyChannel::Bullets);
+    for (const auto& b : state.bullets) fill_disc(bullets, n, to_cells(b.pos), b.radius * inv_cell_size_);
+
+    const int ring_level = state.upgrades.levels[static_cast<size_t>(UpgradeId::RingOfFire)];
+    if (ring_level > 0) {
+        fill_disc(plane(OccupancyChannel::RingOfFire), n, to_cells(p), ring_of_fire_radius(ring_level) * inv_cell_size_);
+    }
+}
+
+} // namespace lv
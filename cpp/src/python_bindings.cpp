@@ -1,14 +1,30 @@
 #include "lastvector/config.hpp"
+#include "lastvector/evaluation.hpp"
+#include "lastvector/mlp_policy.hpp"
+#include "lastvector/observation.hpp"
+#include "lastvector/occupancy_grid.hpp"
+#include "lastvector/replay.hpp"
+#include "lastvector/rollout.hpp"
 #include "lastvector/sim.hpp"
+#include "lastvector/software_renderer.hpp"
+#include "lastvector/trajectory_writer.hpp"
 
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 namespace py = pybind11;
@@ -21,29 +37,17 @@ py::array_t<float> as_numpy(const std::vector<float>& v) {
     return arr;
 }
 
-lv::Action action_from_array(const py::array_t<float, py::array::c_style | py::array::forcecast>& arr,
-                             const lv::GameState& state) {
+lv::Action parse_action(const py::array_t<float, py::array::c_style | py::array::forcecast>& arr) {
     if (arr.ndim() != 1 || arr.shape(0) != lv::Simulator::action_dim()) {
         throw std::runtime_error("Action must be float32 array of shape (8,)");
     }
 
-    auto a = arr.unchecked<1>();
-    lv::Action out{};
-    out.move_x = std::clamp(a(0), -1.0f, 1.0f);
-    out.move_y = std::clamp(a(1), -1.0f, 1.0f);
-    out.aim_x = std::clamp(a(2), -1.0f, 1.0f);
-    out.aim_y = std::clamp(a(3), -1.0f, 1.0f);
-    out.shoot = a(4) >= 0.5f;
-    out.sprint = a(5) >= 0.5f;
-    out.reload = a(6) >= 0.5f;
-
-    const float raw_choice = a(7);
-    if (raw_choice < -0.5f) {
-        out.upgrade_choice = -1;
-    } else {
-        out.upgrade_choice = static_cast<int>(std::round(std::clamp(raw_choice, 0.0f, 2.0f)));
-    }
+    return lv::decode_action(std::span<const float, lv::kActionValues>(arr.data(), lv::kActionValues));
+}
 
+lv::Action action_from_array(const py::array_t<float, py::array::c_style | py::array::forcecast>& arr,
+                             const lv::GameState& state) {
+    lv::Action out = parse_action(arr);
     if (state.play_state != lv::PlayState::ChoosingUpgrade) {
         out.upgrade_choice = -1;
     }
@@ -51,27 +55,74 @@ lv::Action action_from_array(const py::array_t<float, py::array::c_style | py::a
     return out;
 }
 
+py::dict observation_layout(int zombie_obs_count, int ray_count) {
+    return lv::visit_obs_layout(zombie_obs_count, ray_count, []<int NZombies, int NRays>() {
+        using Layout = lv::ObservationLayout<NZombies, NRays>;
+        py::dict out;
+        out["zombies"] = Layout::kZombies;
+        out["rays"] = Layout::kRays;
+        out["dim"] = Layout::kDim;
+        out["player"] = py::make_tuple(Layout::kPlayerOffset, Layout::kPlayerFields);
+        out["zombie"] = py::make_tuple(Layout::kZombieOffset, Layout::kZombieFields);
+        out["ray"] = py::make_tuple(Layout::kRayOffset, Layout::kRayFields);
+        out["difficulty"] = Layout::kDifficultyOffset;
+        out["choosing_upgrade"] = Layout::kChoosingUpgradeOffset;
+        out["upgrade_offer"] = py::make_tuple(Layout::kUpgradeOfferOffset, Layout::kUpgradeOfferFields);
+        out["upgrade_levels"] = py::make_tuple(Layout::kUpgradeLevelOffset, Layout::kUpgradeLevelFields);
+        return out;
+    });
+}
+
+py::list observation_layouts() {
+    py::list out;
+#define LV_LIST_OBS_LAYOUT(Z, R) out.append(py::make_tuple(Z, R));
+    LV_FOR_EACH_OBS_LAYOUT(LV_LIST_OBS_LAYOUT)
+#undef LV_LIST_OBS_LAYOUT
+    return out;
+}
+
+lv::SimConfig make_config(std::optional<float> episode_seconds, std::optional<lv::SimConfig> config) {
+    lv::SimConfig out = config.value_or(lv::SimConfig{});
+    if (episode_seconds.has_value()) out.episode_limit_seconds = *episode_seconds;
+    return out;
+}
+
+// (height, width, 3) uint8 top-down frame from the software renderer.
+py::array_t<std::uint8_t> render_frame(const lv::GameState& state, int width, int height, float view_width,
+                                       bool hud) {
+    const lv::SoftwareRenderer renderer(width, height, view_width);
+    py::array_t<std::uint8_t> frame({static_cast<py::ssize_t>(height), static_cast<py::ssize_t>(width),
+                                     static_cast<py::ssize_t>(3)});
+    renderer.render(state, {frame.mutable_data(), static_cast<size_t>(frame.size())}, hud);
+    return frame;
+}
+
 class PySimulator {
   public:
-    PySimulator(std::uint64_t seed = 0, float episode_seconds = lv::kEpisodeLimitSeconds)
-        : episode_steps_(std::max(1, static_cast<int>(episode_seconds / lv::kFixedDt))) {
+    PySimulator(std::uint64_t seed, std::optional<float> episode_seconds, std::optional<lv::SimConfig> config)
+        : sim_(make_config(episode_seconds, std::move(config))) {
         reset(seed);
     }
 
     py::array_t<float> reset(std::uint64_t seed) {
-        steps_ = 0;
-        return as_numpy(sim_.reset(seed));
+        finish_replay();
+        sim_.reset(seed);
+        py::array_t<float> obs(sim_.observation_dim());
+        sim_.observe_into({obs.mutable_data(), static_cast<size_t>(obs.size())});
+        if (dataset_) {
+            dataset_obs_.assign(obs.data(), obs.data() + obs.size());
+            dataset_step_ = 0;
+        }
+        return obs;
     }
 
     py::tuple step(const py::array_t<float, py::array::c_style | py::array::forcecast>& action) {
         if (action.ndim() != 1 || action.shape(0) != lv::Simulator::action_dim()) {
             throw py::value_error("action must be a float32 array with shape (8,)");
         }
-        const lv::Action parsed = action_from_array(action, sim_.state());
+        lv::Action parsed = action_from_array(action, sim_.state());
+        if (replay_.has_value()) parsed = replay_->record(sim_, parsed);
         auto out = sim_.step(parsed);
-        steps_ += 1;
-
-        out.truncated = out.truncated || (steps_ >= episode_steps_);
 
         py::dict info;
         const auto& state = sim_.state();
@@ -101,10 +152,81 @@ class PySimulator {
             reward = 0.0f;
         }
 
+        if (dataset_) {
+            out.reward = reward;
+            dataset_->append(state.seed, dataset_env_, dataset_step_++, dataset_obs_, parsed, out);
+            dataset_obs_.assign(obs.data(), obs.data() + obs.size());
+        }
+
         return py::make_tuple(obs, reward, out.terminated, out.truncated, info);
     }
 
-    int obs_dim() const { return lv::Simulator::observation_dim(); }
+    // (channels, size, size) uint8 occupancy grid of the current state.
+    py::array_t<std::uint8_t> occupancy() const {
+        const auto n = static_cast<py::ssize_t>(sim_.config().occupancy_grid_size);
+        py::array_t<std::uint8_t> grid({static_cast<py::ssize_t>(lv::kOccupancyChannels), n, n});
+        sim_.occupancy_into({grid.mutable_data(), static_cast<size_t>(grid.size())});
+        return grid;
+    }
+
+    py::tuple occupancy_shape() const {
+        const int n = sim_.config().occupancy_grid_size;
+        return py::make_tuple(lv::kOccupancyChannels, n, n);
+    }
+
+    py::array_t<std::uint8_t> render_rgb(int width, int height, float view_width, bool hud) const {
+        return render_frame(sim_.state(), width, height, view_width, hud);
+    }
+
+    py::bytes save_state() const {
+        std::vector<uint8_t> bytes;
+        sim_.save_state(bytes);
+        return py::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    void load_state(const py::bytes& data) {
+        finish_replay();
+        const std::string bytes = data;
+        sim_.load_state({reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size()});
+        if (dataset_) dataset_obs_ = sim_.observation();
+    }
+
+    // Appends every following step to `writer` as stream `env`; None detaches.
+    void attach_dataset(std::shared_ptr<lv::TrajectoryWriter> writer, std::uint32_t env) {
+        if (writer && writer->spec().obs_dim != sim_.observation_dim()) {
+            throw py::value_error("dataset obs_dim does not match this simulator");
+        }
+        dataset_ = std::move(writer);
+        dataset_env_ = env;
+        dataset_step_ = 0;
+        if (dataset_) dataset_obs_ = sim_.observation();
+    }
+
+    // Records every following step to `path` until finish_replay(), reset() or
+    // load_state(); the first keyframe is the current state.
+    void start_replay(const std::string& path, std::uint32_t keyframe_every) {
+        finish_replay();
+        replay_.emplace(path, sim_.config(), sim_.state().seed, keyframe_every);
+    }
+
+    // Closes the replay being recorded; returns its step count (0 if none).
+    std::uint64_t finish_replay() {
+        if (!replay_.has_value()) return 0;
+        const std::uint64_t steps = replay_->steps();
+        try {
+            replay_->close(&sim_);
+        } catch (...) {
+            replay_.reset();
+            throw;
+        }
+        replay_.reset();
+        return steps;
+    }
+
+    int obs_dim() const { return sim_.observation_dim(); }
+    py::dict obs_layout() const { return observation_layout(sim_.config().zombie_obs_count, sim_.config().ray_count); }
+    lv::SimConfig config() const { return sim_.config(); }
+    std::uint64_t state_hash() const { return sim_.state_hash(); }
     int action_dim() const { return lv::Simulator::action_dim(); }
 
     static py::array_t<float> action_low() {
@@ -136,20 +258,390 @@ class PySimulator {
     }
 
   private:
-    lv::Simulator sim_{};
-    int steps_ = 0;
-    int episode_steps_ = 1;
+    lv::Simulator sim_;
+    std::optional<lv::ReplayWriter> replay_;
+    std::shared_ptr<lv::TrajectoryWriter> dataset_;
+    std::uint32_t dataset_env_ = 0;
+    std::uint32_t dataset_step_ = 0;
+    std::vector<float> dataset_obs_; // observation the next step starts from
 };
 
+std::shared_ptr<lv::TrajectoryWriter> make_trajectory_writer(const std::string& path, int obs_dim,
+                                                             std::optional<std::vector<std::string>> metrics,
+                                                             std::uint64_t shard_rows, double flush_interval_s) {
+    lv::TrajectorySpec spec;
+    spec.obs_dim = obs_dim;
+    if (metrics.has_value()) spec.metrics = std::move(*metrics);
+    spec.shard_rows = shard_rows;
+    spec.flush_interval = std::chrono::milliseconds(static_cast<int64_t>(flush_interval_s * 1000.0));
+    return std::make_shared<lv::TrajectoryWriter>(path, std::move(spec));
+}
+
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+void append_trajectory_row(lv::TrajectoryWriter& writer, const FloatArray& obs, const FloatArray& action, float reward,
+                           bool terminated, bool truncated, std::uint64_t seed, std::uint32_t env, std::uint32_t step,
+                           const std::optional<FloatArray>& metrics) {
+    lv::TrajectoryRow row;
+    row.obs = {obs.data(), static_cast<size_t>(obs.size())};
+    row.action = parse_action(action);
+    row.reward = reward;
+    row.terminated = terminated;
+    row.truncated = truncated;
+    row.seed = seed;
+    row.env = env;
+    row.step = step;
+    if (metrics.has_value()) row.metrics = {metrics->data(), static_cast<size_t>(metrics->size())};
+    writer.append(row);
+}
+
+py::dict replay_info(const lv::ReplayPlayer& replay) {
+    const auto& state = replay.sim().state();
+    py::dict info;
+    info["tick"] = state.tick;
+    info["time_alive_seconds"] = state.episode_time_s;
+    info["kills"] = state.stats.kills;
+    info["health"] = state.player.health;
+    info["is_choosing_upgrade"] = state.play_state == lv::PlayState::ChoosingUpgrade;
+    info["dead"] = state.play_state == lv::PlayState::Dead;
+    return info;
+}
+
+// (obs_dim,) -> (action_dim,) or (N, obs_dim) -> (N, action_dim), one batched pass.
+py::array_t<float> mlp_forward(lv::MlpPolicy& policy,
+                               const py::array_t<float, py::array::c_style | py::array::forcecast>& obs) {
+    const auto obs_dim = static_cast<py::ssize_t>(policy.obs_dim());
+    const auto action_dim = static_cast<py::ssize_t>(policy.action_dim());
+    if (obs.ndim() == 1 && obs.shape(0) == obs_dim) {
+        py::array_t<float> out(action_dim);
+        policy.forward({obs.data(), policy.obs_dim()}, 1, {out.mutable_data(), policy.action_dim()});
+        return out;
+    }
+    if (obs.ndim() != 2 || obs.shape(1) != obs_dim) {
+        throw std::runtime_error("Observations must be float32 of shape (obs_dim,) or (N, obs_dim)");
+    }
+    const auto batch = static_cast<size_t>(obs.shape(0));
+    py::array_t<float> out({obs.shape(0), action_dim});
+    {
+        py::gil_scoped_release release;
+        policy.forward({obs.data(), batch * policy.obs_dim()}, batch,
+                       {out.mutable_data(), batch * policy.action_dim()});
+    }
+    return out;
+}
+
+// `policy` is an MlpPolicy (stays in C++) or a callable mapping a float32
+// (n, obs_dim) batch to (n, 8) actions, called with the GIL held.
+std::string evaluate(const py::object& policy, int episodes, std::uint64_t seed, int threads, int batch,
+                     int max_ticks, std::optional<float> episode_seconds, std::optional<lv::SimConfig> config) {
+    lv::EvalConfig eval;
+    eval.sim = make_config(episode_seconds, std::move(config));
+    eval.first_seed = seed;
+    eval.episodes = episodes;
+    eval.threads = threads;
+    eval.batch = batch;
+    eval.max_ticks = max_ticks;
+
+    lv::BatchPolicy fn;
+    if (py::isinstance<lv::MlpPolicy>(policy)) {
+        lv::MlpPolicy& mlp = policy.cast<lv::MlpPolicy&>();
+        fn = [&mlp](std::span<const float> obs, size_t n, std::span<float> out) { mlp.forward(obs, n, out); };
+    } else {
+        fn = [&policy](std::span<const float> obs, size_t n, std::span<float> out) {
+            py::gil_scoped_acquire gil;
+            const auto rows = static_cast<py::ssize_t>(n);
+            py::array_t<float> batch_obs({rows, static_cast<py::ssize_t>(obs.size() / n)});
+            std::memcpy(batch_obs.mutable_data(), obs.data(), obs.size() * sizeof(float));
+            const auto actions =
+                py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(policy(batch_obs));
+            if (!actions || actions.ndim() != 2 || actions.shape(0) != rows ||
+                actions.shape(1) != lv::Simulator::action_dim()) {
+                throw std::runtime_error("policy must return float32 actions of shape (n, 8)");
+            }
+            std::memcpy(out.data(), actions.data(), out.size() * sizeof(float));
+        };
+    }
+
+    std::vector<lv::EpisodeResult> results;
+    {
+        py::gil_scoped_release release;
+        results = lv::evaluate_policy(eval, fn);
+    }
+    return lv::eval_report_json(results);
+}
+
+std::unique_ptr<lv::RolloutCollector> make_rollout_collector(int envs, int steps, std::uint64_t seed, int threads,
+                                                             std::optional<float> episode_seconds,
+                                                             std::optional<lv::SimConfig> config) {
+    lv::RolloutConfig rollout;
+    rollout.sim = make_config(episode_seconds, std::move(config));
+    rollout.envs = envs;
+    rollout.steps = steps;
+    rollout.first_seed = seed;
+    rollout.threads = threads;
+    return std::make_unique<lv::RolloutCollector>(rollout);
+}
+
+// Read-only array over collector memory, keeping `owner` alive.
+py::array rollout_view(const py::object& owner, const void* data, const py::dtype& dtype,
+                       std::vector<py::ssize_t> shape) {
+    py::array out(dtype, std::move(shape), data, owner);
+    out.attr("setflags")(py::arg("write") = false);
+    return out;
+}
+
+void collect_rollout(const py::object& self, const py::object& policy) {
+    auto& collector = self.cast<lv::RolloutCollector&>();
+    if (py::isinstance<lv::MlpPolicy>(policy)) {
+        lv::MlpPolicy& mlp = policy.cast<lv::MlpPolicy&>();
+        py::gil_scoped_release release;
+        collector.collect(mlp);
+        return;
+    }
+    if (!PyCallable_Check(policy.ptr())) throw py::type_error("policy must be an MlpPolicy or a callable");
+    const auto rows = static_cast<py::ssize_t>(collector.envs());
+    const auto obs_dim = static_cast<py::ssize_t>(collector.obs_dim());
+    py::gil_scoped_release release;
+    collector.collect([&](size_t step, std::span<const float> obs, std::span<float> out) {
+        py::gil_scoped_acquire gil;
+        const py::array batch_obs = rollout_view(self, obs.data(), py::dtype::of<float>(), {rows, obs_dim});
+        const auto actions =
+            py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(policy(step, batch_obs));
+        if (!actions || actions.ndim() != 2 || actions.shape(0) != rows ||
+            actions.shape(1) != lv::Simulator::action_dim()) {
+            throw std::runtime_error("policy must return float32 actions of shape (n_envs, 8)");
+        }
+        std::memcpy(out.data(), actions.data(), out.size() * sizeof(float));
+    });
+}
+
+// Column arrays of the episodes that ended in the last collect().
+py::dict rollout_episodes(const lv::RolloutCollector& collector) {
+    const auto& episodes = collector.episodes();
+    const auto column = [&](auto field) {
+        using T = std::decay_t<decltype(episodes.front().*field)>;
+        py::array_t<T> out(static_cast<py::ssize_t>(episodes.size()));
+        for (size_t i = 0; i < episodes.size(); ++i) out.mutable_data()[i] = episodes[i].*field;
+        return out;
+    };
+    py::dict out;
+    out["env"] = column(&lv::RolloutEpisode::env);
+    out["step"] = column(&lv::RolloutEpisode::step);
+    out["seed"] = column(&lv::RolloutEpisode::seed);
+    out["reward"] = column(&lv::RolloutEpisode::reward);
+    out["length"] = column(&lv::RolloutEpisode::length);
+    out["survival_s"] = column(&lv::RolloutEpisode::survival_s);
+    out["kills"] = column(&lv::RolloutEpisode::kills);
+    out["shots_fired"] = column(&lv::RolloutEpisode::shots_fired);
+    out["hits"] = column(&lv::RolloutEpisode::hits);
+    out["accuracy"] = column(&lv::RolloutEpisode::accuracy);
+    out["damage_dealt"] = column(&lv::RolloutEpisode::damage_dealt);
+    out["damage_taken"] = column(&lv::RolloutEpisode::damage_taken);
+    out["truncated"] = column(&lv::RolloutEpisode::truncated);
+    const auto final_obs = collector.final_observations();
+    py::array_t<float> final_out({static_cast<py::ssize_t>(episodes.size()),
+                                  static_cast<py::ssize_t>(collector.obs_dim())});
+    std::memcpy(final_out.mutable_data(), final_obs.data(), final_obs.size_bytes());
+    out["final_obs"] = final_out;
+    return out;
+}
+
 } // namespace
 
 PYBIND11_MODULE(last_vector_core, m) {
+    py::enum_<lv::NeighborSearch>(m, "NeighborSearch")
+        .value("BruteForce", lv::NeighborSearch::BruteForce)
+        .value("VerletList", lv::NeighborSearch::VerletList);
+
+    py::enum_<lv::ZombieRaySearch>(m, "ZombieRaySearch")
+        .value("BruteForce", lv::ZombieRaySearch::BruteForce)
+        .value("GridDDA", lv::ZombieRaySearch::GridDDA);
+
+    py::enum_<lv::SeparationSolver>(m, "SeparationSolver")
+        .value("GaussSeidel", lv::SeparationSolver::GaussSeidel)
+        .value("Jacobi", lv::SeparationSolver::Jacobi);
+
+    py::class_<lv::SimConfig>(m, "SimConfig")
+        .def(py::init<>())
+        .def_readwrite("arena_width", &lv::SimConfig::arena_width)
+        .def_readwrite("arena_height", &lv::SimConfig::arena_height)
+        .def_readwrite("episode_limit_seconds", &lv::SimConfig::episode_limit_seconds)
+        .def_readwrite("difficulty_ramp_seconds", &lv::SimConfig::difficulty_ramp_seconds)
+        .def_readwrite("spawn_rate_base", &lv::SimConfig::spawn_rate_base)
+        .def_readwrite("spawn_rate_per_difficulty", &lv::SimConfig::spawn_rate_per_difficulty)
+        .def_readwrite("max_alive_base", &lv::SimConfig::max_alive_base)
+        .def_readwrite("max_alive_per_difficulty", &lv::SimConfig::max_alive_per_difficulty)
+        .def_readwrite("max_alive_cap", &lv::SimConfig::max_alive_cap)
+        .def_readwrite("zombie_obs_count", &lv::SimConfig::zombie_obs_count)
+        .def_readwrite("ray_count", &lv::SimConfig::ray_count)
+        .def_readwrite("zombie_ray_search", &lv::SimConfig::zombie_ray_search)
+        .def_readwrite("obstacle_field_cell_size", &lv::SimConfig::obstacle_field_cell_size)
+        .def_readwrite("occupancy_grid_size", &lv::SimConfig::occupancy_grid_size)
+        .def_readwrite("occupancy_cell_size", &lv::SimConfig::occupancy_cell_size)
+        .def_readwrite("neighbor_search", &lv::SimConfig::neighbor_search)
+        .def_readwrite("separation_solver", &lv::SimConfig::separation_solver)
+        .def_readwrite("separation_threads", &lv::SimConfig::separation_threads);
+
+    m.def("observation_layout", &observation_layout, py::arg("zombie_obs_count"), py::arg("ray_count"),
+          "Field offsets of a compiled observation layout; (offset, width) tuples for repeated blocks.");
+    m.def("observation_layouts", &observation_layouts, "Compiled (zombie_obs_count, ray_count) layouts.");
+
     py::class_<PySimulator>(m, "Simulator")
-        .def(py::init<std::uint64_t, float>(), py::arg("seed") = 0, py::arg("episode_seconds") = 180.0f)
+        .def(py::init<std::uint64_t, std::optional<float>, std::optional<lv::SimConfig>>(), py::arg("seed") = 0,
+             py::arg("episode_seconds") = py::none(), py::arg("config") = py::none())
         .def("reset", &PySimulator::reset, py::arg("seed"))
         .def("step", &PySimulator::step, py::arg("action"))
         .def("obs_dim", &PySimulator::obs_dim)
         .def("action_dim", &PySimulator::action_dim)
+        .def("obs_layout", &PySimulator::obs_layout)
+        .def("occupancy", &PySimulator::occupancy,
+             "Egocentric occupancy grid, uint8 (channels, size, size): obstacles, zombies, bullets, ring of fire.")
+        .def("occupancy_shape", &PySimulator::occupancy_shape)
+        .def("render_rgb", &PySimulator::render_rgb, py::arg("width") = 640, py::arg("height") = 360,
+             py::arg("view_width") = 1280.0f, py::arg("hud") = true,
+             "Player-centred RGB frame (height, width, 3) drawn on the CPU; view_width is in world units.")
+        .def_property_readonly("config", &PySimulator::config)
+        .def("state_hash", &PySimulator::state_hash,
+             "64-bit hash of the current state; equal hashes every step mean identical trajectories.")
+        .def("save_state", &PySimulator::save_state, "Complete simulator state, including the RNG position, as bytes.")
+        .def("load_state", &PySimulator::load_state, py::arg("state"),
+             "Restores bytes from save_state() of a simulator with the same config.")
+        .def("start_replay", &PySimulator::start_replay, py::arg("path"),
+             py::arg("keyframe_every") = lv::ReplayWriter::kDefaultKeyframeInterval,
+             "Records the following steps to a replay file; actions are quantized as stored.")
+        .def("finish_replay", &PySimulator::finish_replay)
+        .def("attach_dataset", &PySimulator::attach_dataset, py::arg("writer"), py::arg("env") = 0,
+             "Streams every following step into a TrajectoryWriter; None detaches.")
         .def_static("action_low", &PySimulator::action_low)
         .def_static("action_high", &PySimulator::action_high);
+
+    py::class_<lv::TrajectoryWriter, std::shared_ptr<lv::TrajectoryWriter>>(m, "TrajectoryWriter")
+        .def(py::init(&make_trajectory_writer), py::arg("path"), py::arg("obs_dim"), py::arg("metrics") = py::none(),
+             py::arg("shard_rows") = std::uint64_t{1} << 20, py::arg("flush_interval_s") = 1.0,
+             "Memory-mapped .npy shards plus index.json under `path`; read them with "
+             "last_vector_env.open_dataset().")
+        .def("append", &append_trajectory_row, py::arg("obs"), py::arg("action"), py::arg("reward"),
+             py::arg("terminated"), py::arg("truncated"), py::arg("seed") = 0, py::arg("env") = 0, py::arg("step") = 0,
+             py::arg("metrics") = py::none())
+        .def("flush", &lv::TrajectoryWriter::flush, py::call_guard<py::gil_scoped_release>())
+        .def("close", &lv::TrajectoryWriter::close, py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("rows", &lv::TrajectoryWriter::rows)
+        .def_property_readonly("row_bytes", &lv::TrajectoryWriter::row_bytes);
+
+    py::class_<lv::ReplayPlayer>(m, "ReplayPlayer")
+        .def(py::init<const std::string&>(), py::arg("path"))
+        .def_property_readonly("seed", &lv::ReplayPlayer::seed)
+        .def_property_readonly("config", [](const lv::ReplayPlayer& r) { return r.config(); })
+        .def_property_readonly("keyframe_interval", &lv::ReplayPlayer::keyframe_interval)
+        .def("__len__", &lv::ReplayPlayer::length)
+        .def_property_readonly("position", &lv::ReplayPlayer::position, "Steps played so far.")
+        .def("seek", &lv::ReplayPlayer::seek, py::arg("step"),
+             "Moves to the state before `step`, from the nearest keyframe.")
+        .def("step", &lv::ReplayPlayer::step, "Plays the next recorded step; False at the end.")
+        .def("observation",
+             [](const lv::ReplayPlayer& r) {
+                 py::array_t<float> obs(r.sim().observation_dim());
+                 r.sim().observe_into({obs.mutable_data(), static_cast<size_t>(obs.size())});
+                 return obs;
+             })
+        .def("info", &replay_info)
+        .def_property_readonly("has_checksums", &lv::ReplayPlayer::has_checksums)
+        .def(
+            "verify",
+            [](lv::ReplayPlayer& r) -> std::optional<py::dict> {
+                std::optional<lv::ReplayDivergence> divergence;
+                {
+                    py::gil_scoped_release release;
+                    divergence = r.verify();
+                }
+                if (!divergence.has_value()) return std::nullopt;
+                py::dict out;
+                out["step"] = divergence->step;
+                out["tick"] = divergence->tick;
+                out["what"] = divergence->what;
+                return out;
+            },
+            "Replays the file checking every recorded state hash; None if it reproduces, else the first "
+            "divergence as {step, tick, what}.")
+        .def(
+            "render_rgb",
+            [](const lv::ReplayPlayer& r, int width, int height, float view_width, bool hud) {
+                return render_frame(r.sim().state(), width, height, view_width, hud);
+            },
+            py::arg("width") = 640, py::arg("height") = 360, py::arg("view_width") = 1280.0f, py::arg("hud") = true);
+
+    const auto rollout_shape = [](const lv::RolloutCollector& c, std::initializer_list<size_t> tail) {
+        std::vector<py::ssize_t> shape{static_cast<py::ssize_t>(c.steps()), static_cast<py::ssize_t>(c.envs())};
+        for (const size_t d : tail) shape.push_back(static_cast<py::ssize_t>(d));
+        return shape;
+    };
+    py::class_<lv::RolloutCollector>(m, "RolloutCollector")
+        .def(py::init(&make_rollout_collector), py::arg("envs"), py::arg("steps"), py::arg("seed") = 0,
+             py::arg("threads") = 1, py::arg("episode_seconds") = py::none(), py::arg("config") = py::none(),
+             "Steps `envs` simulators for `steps` ticks per collect() into contiguous (steps, envs, ...) arrays.")
+        .def_property_readonly("envs", &lv::RolloutCollector::envs)
+        .def_property_readonly("steps", &lv::RolloutCollector::steps)
+        .def_property_readonly("obs_dim", &lv::RolloutCollector::obs_dim)
+        .def("collect", &collect_rollout, py::arg("policy"),
+             "policy is an MlpPolicy or policy(step, obs) -> (envs, 8) raw actions, called once per step with "
+             "a read-only (envs, obs_dim) view.")
+        .def_property_readonly("observations",
+                               [=](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.observations().data(), py::dtype::of<float>(),
+                                                       rollout_shape(c, {c.obs_dim()}));
+                               })
+        .def_property_readonly("last_observations",
+                               [](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.last_observations().data(), py::dtype::of<float>(),
+                                                       {static_cast<py::ssize_t>(c.envs()),
+                                                        static_cast<py::ssize_t>(c.obs_dim())});
+                               })
+        .def_property_readonly("actions",
+                               [=](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.actions().data(), py::dtype::of<float>(),
+                                                       rollout_shape(c, {c.action_dim()}));
+                               })
+        .def_property_readonly("rewards",
+                               [=](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.rewards().data(), py::dtype::of<float>(),
+                                                       rollout_shape(c, {}));
+                               })
+        .def_property_readonly("terminated",
+                               [=](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.terminated().data(), py::dtype::of<bool>(),
+                                                       rollout_shape(c, {}));
+                               })
+        .def_property_readonly("truncated",
+                               [=](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.truncated().data(), py::dtype::of<bool>(),
+                                                       rollout_shape(c, {}));
+                               })
+        .def_property_readonly("episode_starts",
+                               [=](const py::object& self) {
+                                   const auto& c = self.cast<const lv::RolloutCollector&>();
+                                   return rollout_view(self, c.episode_starts().data(), py::dtype::of<bool>(),
+                                                       rollout_shape(c, {}));
+                               })
+        .def("episodes", &rollout_episodes,
+             "Episodes that ended in the last collect(), as columns (env, step, seed, reward, length, ...) plus "
+             "final_obs, the observation each ended on.");
+
+    py::class_<lv::MlpPolicy>(m, "MlpPolicy")
+        .def(py::init<const std::string&>(), py::arg("path"),
+             "Loads an actor written by python/export_policy.py.")
+        .def_property_readonly("obs_dim", &lv::MlpPolicy::obs_dim)
+        .def_property_readonly("action_dim", &lv::MlpPolicy::action_dim)
+        .def("forward", &mlp_forward, py::arg("obs"),
+             "Deterministic action means for one observation or a batch, before clipping.");
+
+    m.def("evaluate", &evaluate, py::arg("policy"), py::arg("episodes"), py::arg("seed") = 0, py::arg("threads") = 1,
+          py::arg("batch") = 64, py::arg("max_ticks") = 0, py::arg("episode_seconds") = py::none(),
+          py::arg("config") = py::none(),
+          "Plays seeds seed..seed+episodes-1 with batched inference on a thread pool; returns the JSON report.");
 }
@@ -0,0 +1,89 @@
+#include "lastvector/render_snapshot.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace lv {
+
+namespace {
+
+Vec2 lerp(Vec2 a, Vec2 b, float t) { return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t}; }
+
+Vec2 back_along(Vec2 pos, Vec2 vel, float seconds) { return {pos.x - vel.x * seconds, pos.y - vel.y * seconds}; }
+
+} // namespace
+
+void capture_snapshot(const GameState& state, Vec2 aim, RenderSnapshot& out) {
+    out.tick = state.tick;
+    out.episode_time_s = state.episode_time_s;
+    out.difficulty_scalar = state.difficulty_scalar;
+    out.play_state = state.play_state;
+    out.arena_size = state.arena_size;
+    out.player = state.player;
+    out.aim = aim;
+    out.kills = state.stats.kills;
+    out.upgrade_offer = state.upgrade_offer;
+    out.zombies.assign(state.zombies.begin(), state.zombies.end());
+    out.bullets.assign(state.bullets.begin(), state.bullets.end());
+    out.obstacles.assign(state.obstacles.begin(), state.obstacles.end());
+}
+
+void SnapshotInterpolator::interpolate(const RenderSnapshot& prev, const RenderSnapshot& cur, float alpha,
+                                       RenderSnapshot& out) {
+    const float t = std::clamp(alpha, 0.0f, 1.0f);
+    out.tick = cur.tick;
+    out.sequence = cur.sequence;
+    out.episode_time_s = cur.episode_time_s;
+    out.difficulty_scalar = cur.difficulty_scalar;
+    out.play_state = cur.play_state;
+    out.arena_size = cur.arena_size;
+    out.player = cur.player;
+    out.player.pos = lerp(prev.player.pos, cur.player.pos, t);
+    out.aim = lerp(prev.aim, cur.aim, t);
+    out.kills = cur.kills;
+    out.upgrade_offer = cur.upgrade_offer;
+    out.obstacles.assign(cur.obstacles.begin(), cur.obstacles.end());
+    out.published = cur.published;
+
+    // How far before `cur` the drawn moment is.
+    const float behind_s =
+        (1.0f - t) * static_cast<float>(cur.tick >= prev.tick ? cur.tick - prev.tick : 0) * kFixedDt;
+
+    // Zombies are periodically reordered along a Morton curve, so pair them
+    // up by id through a sorted copy of the previous positions, rebuilt only
+    // when a new snapshot has become `prev`.
+    if (!have_prev_ || prev.sequence != prev_sequence_ || prev.published != prev_published_) {
+        prev_pos_.clear();
+        for (const Zombie& z : prev.zombies) prev_pos_.emplace_back(z.id, z.pos);
+        std::sort(prev_pos_.begin(), prev_pos_.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+        prev_sequence_ = prev.sequence;
+        prev_published_ = prev.published;
+        have_prev_ = true;
+    }
+
+    out.zombies.assign(cur.zombies.begin(), cur.zombies.end());
+    for (Zombie& z : out.zombies) {
+        const auto it = std::lower_bound(prev_pos_.begin(), prev_pos_.end(), z.id,
+                                         [](const auto& entry, uint32_t id) { return entry.first < id; });
+        if (it != prev_pos_.end() && it->first == z.id) {
+            z.pos = lerp(it->second, z.pos, t);
+        } else {
+            z.pos = back_along(z.pos, z.vel, behind_s);
+        }
+    }
+
+    out.bullets.assign(cur.bullets.begin(), cur.bullets.end());
+    for (Bullet& b : out.bullets) b.pos = back_along(b.pos, b.vel, behind_s);
+}
+
+float interpolation_alpha(const RenderSnapshot& prev, const RenderSnapshot& cur,
+                          std::chrono::steady_clock::time_point now) {
+    const auto interval = cur.published - prev.published;
+    if (interval.count() <= 0) return 1.0f;
+    const auto since = now - cur.published;
+    return std::clamp(std::chrono::duration<float>(since).count() / std::chrono::duration<float>(interval).count(),
+                      0.0f, 1.0f);
+}
+
+} // namespace lv
@@ -0,0 +1,379 @@
+#include "lastvector/replay.hpp"
+
+#include "lastvector/byte_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lv {
+
+namespace {
+
+constexpr uint32_t kReplayMagic = 0x5052564c;    // "LVRP"
+constexpr uint32_t kReplayEndMagic = 0x4552564c; // "LVRE"
+constexpr uint32_t kReplayVersion = 2;
+constexpr size_t kTrailerBytesV1 = 8 + 8 + 4 + 4;
+constexpr size_t kTrailerBytes = 8 + kTrailerBytesV1; // version 2 adds the final hash
+constexpr size_t kFlushBytes = size_t{1} << 16;
+constexpr float kAxisScale = 32767.0f;
+
+constexpr uint8_t kShootBit = 1U << 0;
+constexpr uint8_t kSprintBit = 1U << 1;
+constexpr uint8_t kReloadBit = 1U << 2;
+constexpr int kUpgradeShift = 3; // two bits: upgrade_choice + 1
+constexpr uint8_t kMoveChangedBit = 1U << 5;
+constexpr uint8_t kAimChangedBit = 1U << 6;
+
+using Axes = std::array<int16_t, 4>; // move x/y, aim x/y
+
+int16_t to_axis(float v) {
+    if (!std::isfinite(v)) return 0;
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * kAxisScale));
+}
+
+Axes quantize_axes(const Action& a) {
+    Axes q{to_axis(a.move_x), to_axis(a.move_y), static_cast<int16_t>(kAxisScale), 0};
+    const float scale = std::max(std::fabs(a.aim_x), std::fabs(a.aim_y));
+    if (std::isfinite(scale) && scale > 0.0f) {
+        q[2] = to_axis(a.aim_x / scale);
+        q[3] = to_axis(a.aim_y / scale);
+    }
+    return q;
+}
+
+Action make_action(const Axes& q, uint8_t flags) {
+    Action a;
+    a.move_x = q[0] / kAxisScale;
+    a.move_y = q[1] / kAxisScale;
+    a.aim_x = q[2] / kAxisScale;
+    a.aim_y = q[3] / kAxisScale;
+    a.shoot = (flags & kShootBit) != 0;
+    a.sprint = (flags & kSprintBit) != 0;
+    a.reload = (flags & kReloadBit) != 0;
+    a.upgrade_choice = ((flags >> kUpgradeShift) & 3) - 1;
+    return a;
+}
+
+uint8_t button_flags(const Action& a) {
+    const int upgrade = a.upgrade_choice >= 0 && a.upgrade_choice <= 2 ? a.upgrade_choice + 1 : 0;
+    return static_cast<uint8_t>((a.shoot ? kShootBit : 0) | (a.sprint ? kSprintBit : 0) |
+                                (a.reload ? kReloadBit : 0) | (upgrade << kUpgradeShift));
+}
+
+void write_config(ByteWriter& w, const SimConfig& c) {
+    for (const float f : {c.arena_width, c.arena_height, c.episode_limit_seconds, c.difficulty_ramp_seconds,
+                          c.spawn_rate_base, c.spawn_rate_per_difficulty}) {
+        w.put(f);
+    }
+    w.put(static_cast<int32_t>(c.max_alive_base));
+    w.put(c.max_alive_per_difficulty);
+    w.put(static_cast<int32_t>(c.max_alive_cap));
+    w.put(static_cast<int32_t>(c.zombie_obs_count));
+    w.put(static_cast<int32_t>(c.ray_count));
+    w.put(static_cast<uint8_t>(c.zombie_ray_search));
+    w.put(c.obstacle_field_cell_size);
+    w.put(static_cast<int32_t>(c.occupancy_grid_size));
+    w.put(c.occupancy_cell_size);
+    w.put(static_cast<uint8_t>(c.neighbor_search));
+    w.put(static_cast<uint8_t>(c.separation_solver));
+    w.put(static_cast<int32_t>(c.separation_threads));
+}
+
+template <typename Enum>
+Enum get_enum(ByteReader& r, Enum last, const char* what) {
+    const auto raw = r.get<uint8_t>();
+    if (raw > static_cast<uint8_t>(last)) r.fail(std::string("bad ") + what + " " + std::to_string(raw));
+    return static_cast<Enum>(raw);
+}
+
+SimConfig read_config(ByteReader& r) {
+    SimConfig c;
+    for (float* f : {&c.arena_width, &c.arena_height, &c.episode_limit_seconds, &c.difficulty_ramp_seconds,
+                     &c.spawn_rate_base, &c.spawn_rate_per_difficulty}) {
+        *f = r.get<float>();
+    }
+    c.max_alive_base = r.get<int32_t>();
+    c.max_alive_per_difficulty = r.get<float>();
+    c.max_alive_cap = r.get<int32_t>();
+    c.zombie_obs_count = r.get<int32_t>();
+    c.ray_count = r.get<int32_t>();
+    c.zombie_ray_search = get_enum(r, ZombieRaySearch::GridDDA, "zombie_ray_search");
+    c.obstacle_field_cell_size = r.get<float>();
+    c.occupancy_grid_size = r.get<int32_t>();
+    c.occupancy_cell_size = r.get<float>();
+    c.neighbor_search = get_enum(r, NeighborSearch::VerletList, "neighbor_search");
+    c.separation_solver = get_enum(r, SeparationSolver::Jacobi, "separation_solver");
+    c.separation_threads = r.get<int32_t>();
+    return c;
+}
+
+std::runtime_error replay_error(const std::string& path, const std::string& why) {
+    return std::runtime_error("replay '" + path + "': " + why);
+}
+
+std::string hex(uint64_t v) {
+    char buf[19];
+    std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+} // namespace
+
+Action quantize_action(const Action& action) {
+    return make_action(quantize_axes(action), button_flags(action));
+}
+
+ReplayWriter::ReplayWriter(const std::string& path, const SimConfig& config, uint64_t seed,
+                           uint32_t keyframe_interval)
+    : path_(path), keyframe_interval_(keyframe_interval) {
+    if (keyframe_interval < 1) throw std::invalid_argument("replay keyframe interval must be >= 1");
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) throw replay_error(path, std::strerror(errno));
+
+    ByteWriter w(buffer_);
+    w.put(kReplayMagic);
+    w.put(kReplayVersion);
+    w.put(seed);
+    w.put(keyframe_interval_);
+    write_config(w, config);
+}
+
+ReplayWriter::~ReplayWriter() {
+    if (closed_) return;
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+Action ReplayWriter::record(const Simulator& sim, const Action& action) {
+    if (closed_) throw replay_error(path_, "record() after close()");
+    ByteWriter w(buffer_);
+    if (steps_ % keyframe_interval_ == 0) {
+        index_.emplace_back(steps_, bytes_written());
+        state_.clear();
+        sim.save_state(state_);
+        w.put(static_cast<uint32_t>(state_.size()));
+        buffer_.insert(buffer_.end(), state_.begin(), state_.end());
+        last_ = {};
+    }
+
+    const Axes q = quantize_axes(action);
+    uint8_t flags = button_flags(action);
+    const bool move_changed = q[0] != last_[0] || q[1] != last_[1];
+    const bool aim_changed = q[2] != last_[2] || q[3] != last_[3];
+    if (move_changed) flags |= kMoveChangedBit;
+    if (aim_changed) flags |= kAimChangedBit;
+    w.put(flags);
+    for (size_t i = move_changed ? 0 : 2; i < (aim_changed ? 4U : 2U); ++i) w.svarint(q[i] - last_[i]);
+    w.put(static_cast<uint32_t>(sim.state_hash()));
+    last_ = q;
+    ++steps_;
+
+    if (buffer_.size() >= kFlushBytes) flush();
+    return make_action(q, flags);
+}
+
+void ReplayWriter::flush() {
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    if (!file_) throw replay_error(path_, "write failed");
+    offset_ += buffer_.size();
+    buffer_.clear();
+}
+
+void ReplayWriter::close(const Simulator* final_state) {
+    if (closed_) return;
+    closed_ = true;
+    const uint64_t index_offset = bytes_written();
+    ByteWriter w(buffer_);
+    for (const auto& [step, offset] : index_) {
+        w.put(step);
+        w.put(offset);
+    }
+    w.put(final_state != nullptr ? final_state->state_hash() : uint64_t{0});
+    w.put(index_offset);
+    w.put(steps_);
+    w.put(static_cast<uint32_t>(index_.size()));
+    w.put(kReplayEndMagic);
+    flush();
+    file_.close();
+    if (!file_) throw replay_error(path_, "close failed");
+}
+
+ReplayPlayer::ReplayPlayer(const std::string& path) : path_(path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw replay_error(path, std::strerror(errno));
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        throw replay_error(path, "empty or unreadable");
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) throw replay_error(path, std::string("mmap: ") + std::strerror(errno));
+    data_ = static_cast<const uint8_t*>(base);
+
+    try {
+        const std::span<const uint8_t> bytes(data_, size_);
+        ByteReader header(bytes, "replay '" + path + "'");
+        if (header.get<uint32_t>() != kReplayMagic) header.fail("not a replay file");
+        version_ = header.get<uint32_t>();
+        if (version_ < 1 || version_ > kReplayVersion) header.fail("unsupported version " + std::to_string(version_));
+        seed_ = header.get<uint64_t>();
+        keyframe_interval_ = header.get<uint32_t>();
+        if (keyframe_interval_ < 1) header.fail("keyframe interval 0");
+        sim_.emplace(read_config(header));
+        const size_t blocks_begin = header.position();
+
+        const size_t trailer_bytes = has_checksums() ? kTrailerBytes : kTrailerBytesV1;
+        if (size_ < blocks_begin + trailer_bytes) header.fail("truncated (recording not closed?)");
+        ByteReader trailer(bytes.subspan(size_ - trailer_bytes), "replay '" + path + "'");
+        if (has_checksums()) final_hash_ = trailer.get<uint64_t>();
+        const auto index_offset = trailer.get<uint64_t>();
+        length_ = trailer.get<uint64_t>();
+        const auto blocks = trailer.get<uint32_t>();
+        if (trailer.get<uint32_t>() != kReplayEndMagic) trailer.fail("missing trailer (recording not closed?)");
+        const uint64_t expected_blocks = (length_ + keyframe_interval_ - 1) / keyframe_interval_;
+        if (blocks != expected_blocks || index_offset < blocks_begin ||
+            index_offset + uint64_t{blocks} * 16 + trailer_bytes != size_) {
+            trailer.fail("inconsistent index");
+        }
+
+        ByteReader index(bytes.subspan(index_offset, uint64_t{blocks} * 16), "replay '" + path + "' index");
+        uint64_t previous = blocks_begin;
+        for (uint32_t b = 0; b < blocks; ++b) {
+            const auto step = index.get<uint64_t>();
+            const auto offset = index.get<uint64_t>();
+            if (step != uint64_t{b} * keyframe_interval_ || offset < previous || offset >= index_offset) {
+                index.fail("bad entry " + std::to_string(b));
+            }
+            block_offsets_.push_back(offset);
+            previous = offset + 1;
+        }
+        block_offsets_.push_back(index_offset);
+        if (blocks == 0) {
+            // Nothing was recorded; there is no keyframe to start from.
+            sim_->reset(seed_);
+        } else {
+            enter_block(0, true);
+        }
+    } catch (...) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+        throw;
+    }
+}
+
+ReplayPlayer::~ReplayPlayer() {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+std::span<const uint8_t> ReplayPlayer::keyframe_state(size_t block) const {
+    const size_t begin = block_offsets_[block];
+    ByteReader r(std::span<const uint8_t>(data_ + begin, block_offsets_[block + 1] - begin),
+                 "replay '" + path_ + "' keyframe");
+    return r.bytes(r.get<uint32_t>());
+}
+
+void ReplayPlayer::enter_block(size_t block, bool load_keyframe) {
+    const auto state = keyframe_state(block);
+    if (load_keyframe) sim_->load_state(state);
+    block_ = block;
+    actions_end_ = block_offsets_[block + 1];
+    cursor_ = static_cast<size_t>(state.data() + state.size() - data_);
+    position_ = uint64_t{block} * keyframe_interval_;
+    last_ = {};
+}
+
+void ReplayPlayer::seek(uint64_t step) {
+    if (step > length_) {
+        throw std::out_of_range("replay seek to step " + std::to_string(step) + " past the end (" +
+                                std::to_string(length_) + " steps)");
+    }
+    if (length_ == 0) return;
+    // The end position has no block of its own when length() is a multiple of
+    // the interval; start from the last one.
+    const size_t block = std::min<size_t>(step / keyframe_interval_, block_offsets_.size() - 2);
+    if (step < position_ || position_ < uint64_t{block} * keyframe_interval_) enter_block(block, true);
+    while (position_ < step) this->step();
+}
+
+bool ReplayPlayer::step() {
+    if (at_end()) return false;
+    sim_->step(next_action());
+    return true;
+}
+
+Action ReplayPlayer::next_action() {
+    if (at_end()) throw std::out_of_range("replay '" + path_ + "' has no steps left");
+    const auto block = static_cast<size_t>(position_ / keyframe_interval_);
+    if (block != block_) {
+        // Playing on into the next block: the simulator already holds its
+        // keyframe state, so only skip over it.
+        if (cursor_ != actions_end_) {
+            throw replay_error(path_, "block " + std::to_string(block_) + " has trailing bytes");
+        }
+        enter_block(block, false);
+    }
+    ByteReader r(std::span<const uint8_t>(data_ + cursor_, actions_end_ - cursor_),
+                 "replay '" + path_ + "' step " + std::to_string(position_));
+    const auto flags = r.get<uint8_t>();
+    Axes q = last_;
+    if (flags & kMoveChangedBit) {
+        for (size_t i = 0; i < 2; ++i) q[i] = static_cast<int16_t>(q[i] + r.svarint());
+    }
+    if (flags & kAimChangedBit) {
+        for (size_t i = 2; i < 4; ++i) q[i] = static_cast<int16_t>(q[i] + r.svarint());
+    }
+    if (has_checksums()) step_hash_ = r.get<uint32_t>();
+    cursor_ += r.position();
+    last_ = q;
+    ++position_;
+    return make_action(q, flags);
+}
+
+std::optional<ReplayDivergence> ReplayPlayer::verify() {
+    if (!has_checksums()) throw replay_error(path_, "version " + std::to_string(version_) + " has no checksums");
+    const auto diverged = [&](std::string what) {
+        return ReplayDivergence{position_, sim_->state().tick, std::move(what)};
+    };
+    if (length_ == 0) {
+        sim_->reset(seed_);
+    } else {
+        enter_block(0, true);
+    }
+    std::vector<uint8_t> state;
+    while (!at_end()) {
+        // Later keyframes are compared, not loaded, so a divergence carries on.
+        if (position_ > 0 && position_ % keyframe_interval_ == 0) {
+            state.clear();
+            sim_->save_state(state);
+            if (!std::ranges::equal(state, keyframe_state(static_cast<size_t>(position_ / keyframe_interval_)))) {
+                return diverged("state differs from keyframe " + std::to_string(position_ / keyframe_interval_));
+            }
+        }
+        ReplayDivergence at{position_, sim_->state().tick, {}};
+        const auto hash = static_cast<uint32_t>(sim_->state_hash());
+        sim_->step(next_action()); // keeps sim() the state before position()
+        if (hash != step_hash_) {
+            at.what = "state hash " + hex(hash) + ", recorded " + hex(step_hash_);
+            return at;
+        }
+    }
+    if (final_hash_ != 0 && sim_->state_hash() != final_hash_) {
+        return diverged("final state hash " + hex(sim_->state_hash()) + ", recorded " + hex(final_hash_));
+    }
+    return std::nullopt;
+}
+
+} // namespace lv
@@ -0,0 +1,145 @@
+#include "lastvector/rollout.hpp"
+#include "lastvector/mlp_policy.hpp"
+#include "lastvector/sim.hpp"
+#include "lastvector/thread_pool.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace lv {
+
+struct RolloutCollector::Env {
+    explicit Env(const SimConfig& config) : sim(config) {}
+
+    Simulator sim;
+    uint64_t seed = 0;
+    double reward = 0.0;
+    int length = 0;
+    // Set by step_env when the episode ended, for collect() to publish in
+    // env order.
+    std::optional<RolloutEpisode> finished;
+    std::vector<float> final_obs;
+};
+
+RolloutCollector::RolloutCollector(const RolloutConfig& config) {
+    if (config.envs < 1) throw std::invalid_argument("rollout needs envs >= 1");
+    if (config.steps < 1) throw std::invalid_argument("rollout needs steps >= 1");
+    if (config.threads < 1) throw std::invalid_argument("rollout needs threads >= 1");
+
+    steps_ = static_cast<size_t>(config.steps);
+    const auto n = static_cast<size_t>(config.envs);
+    for (size_t i = 0; i < n; ++i) {
+        auto env = std::make_unique<Env>(config.sim);
+        env->seed = config.first_seed + i;
+        envs_.push_back(std::move(env));
+    }
+    obs_dim_ = static_cast<size_t>(envs_.front()->sim.observation_dim());
+    pool_ = std::make_unique<ThreadPool>(std::min(config.threads, config.envs));
+
+    obs_.resize((steps_ + 1) * n * obs_dim_);
+    actions_.resize(steps_ * n * action_dim());
+    rewards_.resize(steps_ * n);
+    terminated_.resize(steps_ * n);
+    truncated_.resize(steps_ * n);
+    episode_starts_.resize(steps_ * n);
+    next_starts_.assign(n, 1);
+    for (size_t i = 0; i < n; ++i) {
+        Env& env = *envs_[i];
+        env.sim.reset(env.seed);
+        env.sim.observe_into(std::span<float>(obs_).subspan((steps_ * n + i) * obs_dim_, obs_dim_));
+    }
+}
+
+RolloutCollector::~RolloutCollector() = default;
+
+std::span<const float> RolloutCollector::observations() const {
+    return std::span<const float>(obs_).first(steps_ * envs_.size() * obs_dim_);
+}
+
+std::span<const float> RolloutCollector::last_observations() const {
+    return std::span<const float>(obs_).last(envs_.size() * obs_dim_);
+}
+
+void RolloutCollector::step_env(size_t step, size_t i) {
+    const size_t n = envs_.size();
+    const size_t row = step * n + i;
+    Env& env = *envs_[i];
+
+    const auto raw = std::span<const float>(actions_).subspan(row * action_dim()).first<kActionValues>();
+    StepResult res = env.sim.step(decode_action(raw));
+    env.reward += res.reward;
+    env.length += 1;
+    rewards_[row] = res.reward;
+    terminated_[row] = res.terminated ? 1 : 0;
+    truncated_[row] = res.truncated ? 1 : 0;
+
+    const std::span<float> next = std::span<float>(obs_).subspan((row + n) * obs_dim_, obs_dim_);
+    if (!res.terminated && !res.truncated) {
+        std::copy(res.observation.begin(), res.observation.end(), next.begin());
+        return;
+    }
+    RolloutEpisode& episode = env.finished.emplace();
+    episode.env = static_cast<uint32_t>(i);
+    episode.step = static_cast<uint32_t>(step);
+    episode.seed = env.seed;
+    episode.reward = env.reward;
+    episode.length = env.length;
+    episode.survival_s = env.sim.state().episode_time_s;
+    episode.kills = res.info.kills;
+    episode.shots_fired = res.info.shots_fired;
+    episode.hits = res.info.hits;
+    episode.accuracy = res.info.accuracy;
+    episode.damage_dealt = res.info.damage_dealt;
+    episode.damage_taken = res.info.damage_taken;
+    episode.truncated = res.truncated;
+    env.final_obs = std::move(res.observation);
+    env.seed += n;
+    env.reward = 0.0;
+    env.length = 0;
+    env.sim.reset(env.seed);
+    env.sim.observe_into(next);
+}
+
+void RolloutCollector::collect(const RolloutPolicy& policy) {
+    const size_t n = envs_.size();
+    const size_t row_floats = n * obs_dim_;
+    // Row 0 continues from where the previous rollout stopped.
+    std::copy(obs_.end() - static_cast<std::ptrdiff_t>(row_floats), obs_.end(), obs_.begin());
+    episodes_.clear();
+    final_obs_.clear();
+
+    const std::span<const float> obs(obs_);
+    const std::span<float> actions(actions_);
+    for (size_t t = 0; t < steps_; ++t) {
+        std::copy(next_starts_.begin(), next_starts_.end(),
+                  episode_starts_.begin() + static_cast<std::ptrdiff_t>(t * n));
+        policy(t, obs.subspan(t * row_floats, row_floats), actions.subspan(t * n * action_dim(), n * action_dim()));
+        pool_->parallel_for(n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) step_env(t, i);
+        });
+        for (size_t i = 0; i < n; ++i) {
+            Env& env = *envs_[i];
+            next_starts_[i] = env.finished.has_value() ? 1 : 0;
+            if (!env.finished.has_value()) continue;
+            episodes_.push_back(*env.finished);
+            final_obs_.insert(final_obs_.end(), env.final_obs.begin(), env.final_obs.end());
+            env.finished.reset();
+        }
+    }
+}
+
+void RolloutCollector::collect(MlpPolicy& policy) {
+    if (policy.obs_dim() != obs_dim_ || policy.action_dim() != action_dim()) {
+        throw std::invalid_argument("policy maps " + std::to_string(policy.obs_dim()) + " -> " +
+                                    std::to_string(policy.action_dim()) + " values, rollout needs " +
+                                    std::to_string(obs_dim_) + " -> " + std::to_string(action_dim()));
+    }
+    collect([&](size_t, std::span<const float> obs, std::span<float> actions) {
+        policy.forward(obs, envs_.size(), actions);
+    });
+}
+
+} // namespace lv
@@ -0,0 +1,318 @@
+#include "lastvector/separation.hpp"
+#include "lastvector/collision.hpp"
+#include "lastvector/config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace lv {
+
+namespace {
+
+constexpr float kMaxSeparationCorrectionPerTick = 4.0f;
+constexpr float kMortonCellSize = 32.0f;
+constexpr float kNeighborSlack = 1e-2f;
+constexpr size_t kJacobiParallelMinZombies = 512; // below this, waking the pool costs more than it saves
+
+float length(Vec2 v) { return std::sqrt(v.x * v.x + v.y * v.y); }
+
+Vec2 fallback_normal_for_pair(size_t a, size_t b) {
+    const uint32_t bits = static_cast<uint32_t>((a * 73856093u) ^ (b * 19349663u));
+    const float angle = static_cast<float>(bits % 1024u) * (6.28318530718f / 1024.0f);
+    return {std::cos(angle), std::sin(angle)};
+}
+
+uint32_t spread_bits(uint32_t v) {
+    v &= 0xFFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+uint32_t morton_cell_code(Vec2 pos) {
+    const auto cell = [](float v) {
+        return static_cast<uint32_t>(std::clamp(v / kMortonCellSize, 0.0f, 65535.0f));
+    };
+    return spread_bits(cell(pos.x)) | (spread_bits(cell(pos.y)) << 1);
+}
+
+// Push moving zombie j away from zombie i (i < j); i moves by the negation.
+bool pair_push(const Zombie& a, const Zombie& b, Vec2& out) {
+    Vec2 d{b.pos.x - a.pos.x, b.pos.y - a.pos.y};
+    float l = length(d);
+    Vec2 n{};
+    if (l > 1e-6f) {
+        n = {d.x / l, d.y / l};
+    } else {
+        n = fallback_normal_for_pair(a.id, b.id);
+        l = 0.0f;
+    }
+
+    if (l >= kZombieSeparationRadius) return false;
+    const float penetration = kZombieSeparationRadius - l;
+    const float push = std::min(0.5f * penetration, kMaxSeparationCorrectionPerTick);
+    out = {n.x * push, n.y * push};
+    return true;
+}
+
+void separate_pair(std::vector<Zombie>& zombies, size_t i, size_t j, Vec2 fallback, Vec2 arena_size) {
+    Vec2 push{};
+    if (pair_push(zombies[i], zombies[j], push)) {
+        zombies[i].pos.x -= push.x;
+        zombies[i].pos.y -= push.y;
+        zombies[j].pos.x += push.x;
+        zombies[j].pos.y += push.y;
+    }
+
+    sanitize_position(zombies[i].pos, fallback, kZombieRadius, arena_size);
+    sanitize_position(zombies[j].pos, fallback, kZombieRadius, arena_size);
+}
+
+// The brute-force pair loop, starting at pair (i0, j0).
+void separate_all_pairs_from(std::vector<Zombie>& zombies, size_t i0, size_t j0, Vec2 fallback, Vec2 arena_size) {
+    for (size_t i = i0; i < zombies.size(); ++i) {
+        for (size_t j = i == i0 ? j0 : i + 1; j < zombies.size(); ++j) {
+            separate_pair(zombies, i, j, fallback, arena_size);
+        }
+    }
+}
+
+// Zombie push away from the player; the player moves by `player_out` the other way.
+bool player_push(const Zombie& z, size_t count, Vec2 player_pos, Vec2& zombie_out, Vec2& player_out) {
+    Vec2 d{z.pos.x - player_pos.x, z.pos.y - player_pos.y};
+    float l = length(d);
+    const float min_dist = kPlayerRadius + kZombieRadius;
+    if (l >= min_dist) return false;
+
+    Vec2 n{};
+    if (l > 1e-6f) {
+        n = {d.x / l, d.y / l};
+    } else {
+        n = fallback_normal_for_pair(z.id, count + 1);
+        l = 0.0f;
+    }
+
+    const float penetration = min_dist - l;
+    const float z_push = std::min(0.9f * penetration, kMaxSeparationCorrectionPerTick);
+    const float p_push = std::min(0.1f * penetration, 1.2f);
+    zombie_out = {n.x * z_push, n.y * z_push};
+    player_out = {n.x * p_push, n.y * p_push};
+    return true;
+}
+
+void jacobi_pass(std::vector<Zombie>& zombies,
+                 Vec2& player_pos,
+                 Vec2 arena_size,
+                 NeighborSearch search,
+                 const ZombieNeighborList& neighbors,
+                 ThreadPool* pool,
+                 std::vector<Vec2>& corrections) {
+    const size_t count = zombies.size();
+    corrections.assign(count, Vec2{});
+    const auto run = [&](const std::function<void(size_t, size_t)>& fn) {
+        if (pool != nullptr && count >= kJacobiParallelMinZombies) {
+            pool->parallel_for(count, fn);
+        } else {
+            fn(0, count);
+        }
+    };
+
+    const auto accumulate = [&](size_t k, size_t m, Vec2& sum) {
+        Vec2 push{};
+        if (k < m) {
+            if (pair_push(zombies[k], zombies[m], push)) {
+                sum.x -= push.x;
+                sum.y -= push.y;
+            }
+        } else if (pair_push(zombies[m], zombies[k], push)) {
+            sum.x += push.x;
+            sum.y += push.y;
+        }
+    };
+
+    run([&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            Vec2 sum{};
+            if (search == NeighborSearch::VerletList) {
+                for (const uint32_t m : neighbors.adjacent(k)) accumulate(k, m, sum);
+            } else {
+                for (size_t m = 0; m < count; ++m) {
+                    if (m != k) accumulate(k, m, sum);
+                }
+            }
+            // Summed pushes can overshoot in dense crowds; keep the Gauss-Seidel per-tick cap.
+            const float l = length(sum);
+            if (l > kMaxSeparationCorrectionPerTick) {
+                sum.x *= kMaxSeparationCorrectionPerTick / l;
+                sum.y *= kMaxSeparationCorrectionPerTick / l;
+            }
+            corrections[k] = sum;
+        }
+    });
+
+    run([&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            zombies[k].pos.x += corrections[k].x;
+            zombies[k].pos.y += corrections[k].y;
+            sanitize_position(zombies[k].pos, player_pos, kZombieRadius, arena_size);
+
+            Vec2 z_push{};
+            Vec2 p_push{};
+            if (player_push(zombies[k], count, player_pos, z_push, p_push)) {
+                zombies[k].pos.x += z_push.x;
+                zombies[k].pos.y += z_push.y;
+                sanitize_position(zombies[k].pos, player_pos, kZombieRadius, arena_size);
+                corrections[k] = p_push;
+            } else {
+                corrections[k] = Vec2{};
+            }
+        }
+    });
+
+    // Player pushback is reduced serially in index order.
+    for (const Vec2& push : corrections) {
+        player_pos.x -= push.x;
+        player_pos.y -= push.y;
+    }
+    sanitize_position(player_pos, {arena_size.x * 0.5f, arena_size.y * 0.5f}, kPlayerRadius, arena_size);
+}
+
+} // namespace
+
+ZombieNeighborList::ZombieNeighborList(float cutoff, float skin) : cutoff_(cutoff), skin_(skin) {}
+
+void ZombieNeighborList::refresh(const std::vector<Zombie>& zombies) {
+    if (!valid_ || anchors_.size() != zombies.size()) {
+        rebuild(zombies);
+        return;
+    }
+    for (size_t i = 0; i < zombies.size(); ++i) {
+        if (drifted(i, zombies[i].pos)) {
+            rebuild(zombies);
+            return;
+        }
+    }
+}
+
+bool ZombieNeighborList::drifted(size_t i, Vec2 pos) const {
+    // A hair under skin/2 so float rounding in the distances cannot let an
+    // unlisted pair reach the cutoff.
+    const float limit = 0.5f * skin_ - kNeighborSlack;
+    const float dx = pos.x - anchors_[i].x;
+    const float dy = pos.y - anchors_[i].y;
+    return dx * dx + dy * dy > limit * limit;
+}
+
+// Sweep-and-prune along x: sort by x, then only scan forward while the x gap is
+// within reach. Pairs are re-sorted afterwards to restore brute-force order.
+void ZombieNeighborList::rebuild(const std::vector<Zombie>& zombies) {
+    const float reach = cutoff_ + skin_;
+    const float reach_sq = reach * reach;
+
+    anchors_.resize(zombies.size());
+    order_.resize(zombies.size());
+    for (size_t i = 0; i < zombies.size(); ++i) {
+        anchors_[i] = zombies[i].pos;
+        order_[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(order_.begin(), order_.end(), [&](uint32_t a, uint32_t b) {
+        return anchors_[a].x < anchors_[b].x || (anchors_[a].x == anchors_[b].x && a < b);
+    });
+
+    pairs_.clear();
+    for (size_t a = 0; a < order_.size(); ++a) {
+        const uint32_t i = order_[a];
+        for (size_t b = a + 1; b < order_.size(); ++b) {
+            const uint32_t j = order_[b];
+            const float dx = anchors_[j].x - anchors_[i].x;
+            if (dx > reach) break;
+            const float dy = anchors_[j].y - anchors_[i].y;
+            if (dx * dx + dy * dy <= reach_sq) pairs_.push_back({std::min(i, j), std::max(i, j)});
+        }
+    }
+    std::sort(pairs_.begin(), pairs_.end());
+
+    offsets_.assign(zombies.size() + 1, 0);
+    for (const auto& [i, j] : pairs_) {
+        offsets_[i + 1] += 1;
+        offsets_[j + 1] += 1;
+    }
+    for (size_t i = 1; i < offsets_.size(); ++i) offsets_[i] += offsets_[i - 1];
+    adjacency_.resize(offsets_.back());
+    std::vector<uint32_t> fill(offsets_.begin(), offsets_.end() - 1);
+    for (const auto& [i, j] : pairs_) {
+        adjacency_[fill[i]++] = j;
+        adjacency_[fill[j]++] = i;
+    }
+
+    valid_ = true;
+    rebuilds_ += 1;
+}
+
+void sort_zombies_by_morton(std::vector<Zombie>& zombies) {
+    std::vector<std::pair<uint64_t, uint32_t>> keys(zombies.size());
+    for (size_t i = 0; i < zombies.size(); ++i) {
+        const uint64_t code = morton_cell_code(zombies[i].pos);
+        keys[i] = {(code << 32) | zombies[i].id, static_cast<uint32_t>(i)};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Zombie> sorted;
+    sorted.reserve(zombies.size());
+    for (const auto& key : keys) sorted.push_back(zombies[key.second]);
+    zombies.swap(sorted);
+}
+
+void separate_zombies(std::vector<Zombie>& zombies,
+                      Vec2& player_pos,
+                      Vec2 arena_size,
+                      NeighborSearch search,
+                      ZombieNeighborList& neighbors,
+                      SeparationSolver solver,
+                      ThreadPool* pool) {
+    std::vector<Vec2> corrections;
+    for (int it = 0; it < 2; ++it) {
+        if (search == NeighborSearch::VerletList) neighbors.refresh(zombies);
+
+        if (solver == SeparationSolver::Jacobi) {
+            jacobi_pass(zombies, player_pos, arena_size, search, neighbors, pool, corrections);
+            continue;
+        }
+
+        if (search == NeighborSearch::VerletList) {
+            // Pushes can carry a zombie past skin/2 within the pass, after
+            // which the list may miss pairs; the rest of the pass then runs
+            // brute force, so it matches the brute-force loop exactly. The
+            // next refresh() rebuilds the list.
+            for (const auto& [i, j] : neighbors.pairs()) {
+                separate_pair(zombies, i, j, player_pos, arena_size);
+                if (neighbors.drifted(i, zombies[i].pos) || neighbors.drifted(j, zombies[j].pos)) {
+                    separate_all_pairs_from(zombies, i, j + 1, player_pos, arena_size);
+                    break;
+                }
+            }
+        } else {
+            separate_all_pairs_from(zombies, 0, 1, player_pos, arena_size);
+        }
+
+        for (size_t i = 0; i < zombies.size(); ++i) {
+            auto& z = zombies[i];
+            Vec2 z_push{};
+            Vec2 p_push{};
+            if (player_push(z, zombies.size(), player_pos, z_push, p_push)) {
+                z.pos.x += z_push.x;
+                z.pos.y += z_push.y;
+                player_pos.x -= p_push.x;
+                player_pos.y -= p_push.y;
+
+                sanitize_position(z.pos, player_pos, kZombieRadius, arena_size);
+                sanitize_position(player_pos, {arena_size.x * 0.5f, arena_size.y * 0.5f}, kPlayerRadius, arena_size);
+            }
+        }
+    }
+}
+
+} // namespace lv
@@ -0,0 +1,227 @@
+#include "lastvector/shm_mailbox.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lv {
+
+// Byte offsets are part of the protocol (python/agent_server.py mirrors them).
+// The counters sit on separate cache lines so the two sides do not share one.
+struct ShmMailbox::Header {
+    uint32_t magic;         // 0
+    uint32_t version;       // 4
+    uint32_t slot_capacity; // 8
+    uint32_t server_pid;    // 12
+    char model[48];         // 16, NUL-terminated
+    uint32_t request_seq;   // 64, bumped by the client
+    uint8_t pad0[60];
+    uint32_t response_seq; // 128, bumped by the server
+    uint8_t pad1[60];
+    uint32_t client_attached; // 192
+    uint8_t pad2[60];
+    // 256: request slot, then response slot, kSlotCapacity bytes each
+};
+
+namespace {
+
+constexpr uint32_t kShmMagic = 0x4d53564c; // "LVSM"
+constexpr uint32_t kShmVersion = 1;
+constexpr size_t kHeaderBytes = 256;
+// Busy-wait before sleeping: a local agent usually answers within this window.
+// On a single CPU spinning only delays the peer, so go straight to the futex.
+constexpr int kSpinIterations = 20000;
+
+int spin_iterations() {
+    static const int spins = std::thread::hardware_concurrency() > 1 ? kSpinIterations : 0;
+    return spins;
+}
+
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+std::atomic_ref<uint32_t> atomic(uint32_t& v) { return std::atomic_ref<uint32_t>(v); }
+
+void futex_wake(uint32_t* addr) { ::syscall(SYS_futex, addr, FUTEX_WAKE, 1, nullptr, nullptr, 0); }
+
+// Sleeps while *addr == expected, at most timeout_ms.
+void futex_wait(uint32_t* addr, uint32_t expected, int timeout_ms) {
+    timespec ts{timeout_ms / 1000, static_cast<long>(timeout_ms % 1000) * 1000000L};
+    ::syscall(SYS_futex, addr, FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+// Waits until `counter` moves past `seen`. `poll` runs between sleeps and
+// returns false to give up; returns whether the counter changed.
+template <typename Poll>
+bool wait_for_change(uint32_t& counter, uint32_t seen, Poll poll) {
+    for (int i = 0, n = spin_iterations(); i < n; ++i) {
+        if (atomic(counter).load(std::memory_order_acquire) != seen) return true;
+        cpu_relax();
+    }
+    while (true) {
+        if (atomic(counter).load(std::memory_order_acquire) != seen) return true;
+        if (!poll()) return false;
+        futex_wait(&counter, seen, 1);
+    }
+}
+
+std::string shm_path(const std::string& name) {
+    if (name.empty() || name.find('/') != std::string::npos || name.size() > 200) {
+        throw std::invalid_argument("shm mailbox name must be non-empty and contain no '/': '" + name + "'");
+    }
+    return "/" + name;
+}
+
+std::runtime_error sys_error(const std::string& what, const std::string& name) {
+    return std::runtime_error("shm mailbox '" + name + "': " + what + ": " + std::strerror(errno));
+}
+
+size_t frame_size(std::span<const uint8_t> slot) {
+    uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) length |= static_cast<uint32_t>(slot[static_cast<size_t>(i)]) << (8 * i);
+    const size_t size = 4 + static_cast<size_t>(length);
+    if (size > slot.size()) throw std::runtime_error("shm mailbox frame exceeds the slot");
+    // Callers decode the fixed agent frame header from whatever is returned.
+    if (size < kAgentFrameHeaderBytes) throw std::runtime_error("shm mailbox frame is shorter than its header");
+    return size;
+}
+
+} // namespace
+
+ShmMailbox::ShmMailbox(const std::string& name, ShmMailboxRole role, const std::string& model)
+    : name_(name), role_(role), size_(kHeaderBytes + 2 * kSlotCapacity) {
+    static_assert(offsetof(Header, model) == 16);
+    static_assert(offsetof(Header, request_seq) == 64);
+    static_assert(offsetof(Header, response_seq) == 128);
+    static_assert(offsetof(Header, client_attached) == 192);
+    static_assert(sizeof(Header) == kHeaderBytes);
+
+    const std::string path = shm_path(name);
+    if (role == ShmMailboxRole::Server) {
+        fd_ = ::shm_open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (fd_ < 0) throw sys_error("shm_open", name);
+        if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+            ::close(fd_);
+            throw sys_error("ftruncate", name);
+        }
+    } else {
+        fd_ = ::shm_open(path.c_str(), O_RDWR, 0);
+        if (fd_ < 0) throw sys_error("shm_open (is the agent server running?)", name);
+    }
+    base_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        ::close(fd_);
+        throw sys_error("mmap", name);
+    }
+
+    Header* h = header();
+    if (role == ShmMailboxRole::Server) {
+        model_ = model.substr(0, sizeof(h->model) - 1);
+        h->version = kShmVersion;
+        h->slot_capacity = static_cast<uint32_t>(kSlotCapacity);
+        h->server_pid = static_cast<uint32_t>(::getpid());
+        std::memcpy(h->model, model_.c_str(), model_.size() + 1);
+        // The magic goes last so a client never attaches to a half-written header.
+        atomic(h->magic).store(kShmMagic, std::memory_order_release);
+        return;
+    }
+
+    const auto fail = [&](const std::string& what) {
+        ::munmap(base_, size_);
+        ::close(fd_);
+        base_ = nullptr;
+        throw std::runtime_error("shm mailbox '" + name + "': " + what);
+    };
+    if (atomic(h->magic).load(std::memory_order_acquire) != kShmMagic || h->version != kShmVersion ||
+        h->slot_capacity != kSlotCapacity) {
+        fail("not a compatible agent mailbox");
+    }
+    uint32_t expected = 0;
+    if (!atomic(h->client_attached).compare_exchange_strong(expected, 1)) fail("already has a client");
+    model_ = std::string(h->model, strnlen(h->model, sizeof(h->model)));
+    request_seen_ = atomic(h->request_seq).load(std::memory_order_acquire);
+    response_seen_ = atomic(h->response_seq).load(std::memory_order_acquire);
+}
+
+ShmMailbox::~ShmMailbox() {
+    if (base_ != nullptr) {
+        if (role_ == ShmMailboxRole::Client) {
+            atomic(header()->client_attached).store(0, std::memory_order_release);
+        } else {
+            atomic(header()->server_pid).store(0, std::memory_order_release);
+            ::shm_unlink(shm_path(name_).c_str());
+        }
+        ::munmap(base_, size_);
+    }
+    if (fd_ >= 0) ::close(fd_);
+}
+
+uint8_t* ShmMailbox::request_slot() const { return static_cast<uint8_t*>(base_) + kHeaderBytes; }
+uint8_t* ShmMailbox::response_slot() const { return request_slot() + kSlotCapacity; }
+
+void ShmMailbox::post_request(std::span<const uint8_t> frame) {
+    if (frame.size() > kSlotCapacity) throw std::invalid_argument("shm mailbox request exceeds the slot");
+    std::memcpy(request_slot(), frame.data(), frame.size());
+    atomic(header()->request_seq).fetch_add(1, std::memory_order_release);
+    futex_wake(&header()->request_seq);
+}
+
+std::span<const uint8_t> ShmMailbox::wait_response() {
+    Header* h = header();
+    const bool changed = wait_for_change(h->response_seq, response_seen_, [&] {
+        if (cancelled_.load(std::memory_order_acquire)) return false;
+        const auto pid = static_cast<pid_t>(atomic(h->server_pid).load(std::memory_order_acquire));
+        return pid != 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+    });
+    if (!changed) {
+        throw std::runtime_error(cancelled_.load(std::memory_order_acquire) ? "agent request cancelled"
+                                                                             : "agent disconnected");
+    }
+    response_seen_ = atomic(h->response_seq).load(std::memory_order_acquire);
+    const std::span<const uint8_t> slot(response_slot(), kSlotCapacity);
+    return slot.first(frame_size(slot));
+}
+
+void ShmMailbox::cancel() {
+    cancelled_.store(true, std::memory_order_release);
+    // Cuts the waiter's futex sleep short; the server only sleeps on request_seq.
+    futex_wake(&header()->response_seq);
+}
+
+std::span<const uint8_t> ShmMailbox::wait_request(int timeout_ms) {
+    Header* h = header();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    const bool changed = wait_for_change(h->request_seq, request_seen_,
+                                         [&] { return std::chrono::steady_clock::now() < deadline; });
+    if (!changed) return {};
+    request_seen_ = atomic(h->request_seq).load(std::memory_order_acquire);
+    const std::span<const uint8_t> slot(request_slot(), kSlotCapacity);
+    return slot.first(frame_size(slot));
+}
+
+void ShmMailbox::post_response(std::span<const uint8_t> frame) {
+    if (frame.size() > kSlotCapacity) throw std::invalid_argument("shm mailbox response exceeds the slot");
+    std::memcpy(response_slot(), frame.data(), frame.size());
+    atomic(header()->response_seq).fetch_add(1, std::memory_order_release);
+    futex_wake(&header()->response_seq);
+}
+
+} // namespace lv
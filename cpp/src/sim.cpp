@@ -2,20 +2,27 @@
 #include "lastvector/collision.hpp"
 #include "lastvector/config.hpp"
 #include "lastvector/observation.hpp"
+#include "lastvector/separation.hpp"
 #include "lastvector/upgrade.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 namespace lv {
 namespace {
 
 float length(Vec2 v) { return std::sqrt(v.x * v.x + v.y * v.y); }
 
-constexpr float kZombieSeparationRadius = 22.0f;
 constexpr float kSprintSpeedMultiplier = 1.75f;
-constexpr float kMaxSeparationCorrectionPerTick = 4.0f;
+// Building the ray grid costs a few times more per zombie than testing it
+// against one ray, while each walk barely depends on the horde size, so the
+// grid pays off once zombies x rays is large (see `last_vector_bench --filter
+// zombie_rays`).
+constexpr size_t zombie_ray_grid_min_zombies(int rays) { return static_cast<size_t>(12288 / rays); }
 
 Vec2 normalize(Vec2 v) {
     const float l = length(v);
@@ -23,47 +30,132 @@ Vec2 normalize(Vec2 v) {
     return {v.x / l, v.y / l};
 }
 
-bool is_finite_vec(Vec2 v) {
+[[maybe_unused]] bool is_finite_vec(Vec2 v) {
     return std::isfinite(v.x) && std::isfinite(v.y);
 }
 
-Vec2 fallback_normal_for_pair(size_t a, size_t b) {
-    const uint32_t bits = static_cast<uint32_t>((a * 73856093u) ^ (b * 19349663u));
-    const float angle = static_cast<float>(bits % 1024u) * (6.28318530718f / 1024.0f);
-    return {std::cos(angle), std::sin(angle)};
-}
 
-void clamp_position_in_bounds(Vec2& pos, float radius) {
-    pos.x = std::clamp(pos.x, radius, kArenaWidth - radius);
-    pos.y = std::clamp(pos.y, radius, kArenaHeight - radius);
+// Distance along the ray at which a circle of `radius` first touches the box:
+// a ray cast against the box's Minkowski sum (two grown slabs and four corner circles).
+float swept_circle_vs_aabb(Vec2 origin, Vec2 dir, float radius, const Obstacle& box) {
+    if (circle_vs_aabb_overlap(origin, radius, box)) return 0.0f;
+    float t = std::min(ray_intersect_aabb(origin, dir, {box.x - radius, box.y, box.w + 2.0f * radius, box.h}),
+                       ray_intersect_aabb(origin, dir, {box.x, box.y - radius, box.w, box.h + 2.0f * radius}));
+    t = std::min(t, ray_intersect_circle(origin, dir, {box.x, box.y}, radius));
+    t = std::min(t, ray_intersect_circle(origin, dir, {box.x + box.w, box.y}, radius));
+    t = std::min(t, ray_intersect_circle(origin, dir, {box.x, box.y + box.h}, radius));
+    t = std::min(t, ray_intersect_circle(origin, dir, {box.x + box.w, box.y + box.h}, radius));
+    return t;
 }
 
-void sanitize_position(Vec2& pos, Vec2 fallback, float radius) {
-    if (!is_finite_vec(pos)) {
-        pos = fallback;
+// Bullets fly in a straight line at constant speed, so the update on which one
+// hits an obstacle is known when it is fired. Returns the number of updates
+// (>= 1) the bullet survives before it hits one, or kNoBulletImpact. Leaving the
+// arena is not counted: update_bullets still resolves zombie hits on that update
+// and drops the bullet afterwards.
+constexpr uint64_t kNoBulletImpact = std::numeric_limits<uint64_t>::max();
+
+uint64_t bullet_obstacle_ticks(Vec2 origin, Vec2 dir, float speed, float radius,
+                               const std::vector<Obstacle>& obstacles) {
+    const float step = speed * kFixedDt;
+    float ticks = std::numeric_limits<float>::infinity();
+    for (const auto& obstacle : obstacles) {
+        const float hit_t = swept_circle_vs_aabb(origin, dir, radius, obstacle);
+        if (std::isfinite(hit_t)) ticks = std::min(ticks, std::max(1.0f, std::ceil(hit_t / step)));
     }
-    clamp_position_in_bounds(pos, radius);
+    return std::isfinite(ticks) ? static_cast<uint64_t>(ticks) : kNoBulletImpact;
+}
+
+// Returns `c` so constructors can validate before building members from it.
+const SimConfig& validate_config(const SimConfig& c) {
+    const auto require = [](bool ok, const char* what) {
+        if (!ok) throw std::invalid_argument(std::string("SimConfig: ") + what);
+    };
+    require(std::isfinite(c.arena_width) && c.arena_width >= 4.0f * (kPlayerRadius + kZombieRadius),
+            "arena_width too small");
+    require(std::isfinite(c.arena_height) && c.arena_height >= 4.0f * (kPlayerRadius + kZombieRadius),
+            "arena_height too small");
+    require(c.episode_limit_seconds > 0.0f, "episode_limit_seconds must be positive");
+    require(c.difficulty_ramp_seconds > 0.0f, "difficulty_ramp_seconds must be positive");
+    require(c.spawn_rate_base >= 0.0f && c.spawn_rate_per_difficulty >= 0.0f, "spawn rates must be non-negative");
+    require(c.max_alive_base >= 0 && c.max_alive_per_difficulty >= 0.0f, "max_alive curve must be non-negative");
+    require(c.max_alive_cap >= 0, "max_alive_cap must be non-negative");
+    require(c.separation_threads >= 1, "separation_threads must be at least 1");
+    require(std::isfinite(c.obstacle_field_cell_size), "obstacle_field_cell_size must be finite");
+    require(c.occupancy_grid_size > 0 && c.occupancy_grid_size <= 1024, "occupancy_grid_size must be in [1, 1024]");
+    require(std::isfinite(c.occupancy_cell_size) && c.occupancy_cell_size > 0.0f,
+            "occupancy_cell_size must be positive");
+    return c;
 }
 
 } // namespace
 
-Simulator::Simulator() {
+Simulator::Simulator() : Simulator(SimConfig{}) {}
+
+Simulator::Simulator(const SimConfig& config)
+    : config_(validate_config(config)),
+      occupancy_grid_(config_.occupancy_grid_size, config_.occupancy_cell_size) {
+    visit_obs_layout(config_.zombie_obs_count, config_.ray_count, [this]<int NZombies, int NRays>() {
+        step_fn_ = &Simulator::step_layout<NZombies, NRays>;
+        observe_fn_ = [](const GameState& state, const ObstacleField& field, std::span<float> out) {
+            constexpr int kDim = ObservationLayout<NZombies, NRays>::kDim;
+            write_observation(state, lv::sweep_zombies<NZombies, NRays>(state), &field,
+                              std::span<float, kDim>(out.data(), kDim));
+        };
+    });
+    if (config_.separation_solver == SeparationSolver::Jacobi && config_.separation_threads > 1) {
+        separation_pool_ = std::make_unique<ThreadPool>(config_.separation_threads);
+    }
     reset(0);
 }
 
 std::vector<float> Simulator::reset(uint64_t seed) {
     state_ = GameState{};
     state_.seed = seed;
+    state_.arena_size = {config_.arena_width, config_.arena_height};
+    state_.player.pos = {config_.arena_width * 0.5f, config_.arena_height * 0.5f};
     rng_.reseed(seed);
     upgrade_pause_ticks_ = 0;
+    zombie_neighbors_.invalidate();
     init_obstacles();
     roll_upgrade_offer();
-    return build_observation(state_);
+    update_state_hash();
+    return observation();
+}
+
+StepResult Simulator::step(const Action& action) {
+    StepResult out = (this->*step_fn_)(action);
+    update_state_hash();
+    return out;
+}
+
+std::vector<float> Simulator::observation() const {
+    std::vector<float> obs(static_cast<size_t>(observation_dim()));
+    observe_fn_(state_, obstacle_field_, obs);
+    return obs;
+}
+
+void Simulator::observe_into(std::span<float> out) const {
+    if (static_cast<int>(out.size()) != observation_dim()) {
+        throw std::invalid_argument("observation buffer has " + std::to_string(out.size()) + " floats, expected " +
+                                    std::to_string(observation_dim()));
+    }
+    observe_fn_(state_, obstacle_field_, out);
+}
+
+std::vector<uint8_t> Simulator::occupancy() const {
+    std::vector<uint8_t> grid(occupancy_grid_.dim());
+    occupancy_grid_.write(state_, grid);
+    return grid;
+}
+
+void Simulator::occupancy_into(std::span<uint8_t> out) const {
+    occupancy_grid_.write(state_, out);
 }
 
 void Simulator::init_obstacles() {
-    const float sx = kArenaWidth / 1400.0f;
-    const float sy = kArenaHeight / 900.0f;
+    const float sx = state_.arena_size.x / 1400.0f;
+    const float sy = state_.arena_size.y / 900.0f;
     state_.obstacles = {
         {220.0f * sx, 150.0f * sy, 180.0f * sx, 60.0f * sy},
         {470.0f * sx, 260.0f * sy, 140.0f * sx, 50.0f * sy},
@@ -78,6 +170,8 @@ void Simulator::init_obstacles() {
         {250.0f * sx, 700.0f * sy, 220.0f * sx, 70.0f * sy},
         {560.0f * sx, 760.0f * sy, 140.0f * sx, 60.0f * sy},
     };
+    obstacle_field_.build(state_.obstacles, state_.arena_size, config_.obstacle_field_cell_size);
+    occupancy_grid_.build_static(state_.obstacles, state_.arena_size);
 }
 
 void Simulator::roll_upgrade_offer() {
@@ -88,13 +182,17 @@ void Simulator::roll_upgrade_offer() {
 
 void Simulator::spawn_zombie() {
     Zombie z{};
+    const float w = state_.arena_size.x;
+    const float h = state_.arena_size.y;
     const int edge = rng_.uniform_int(0, 3);
-    if (edge == 0) { z.pos = {0.0f, rng_.uniform(0.0f, kArenaHeight)}; }
-    if (edge == 1) { z.pos = {kArenaWidth, rng_.uniform(0.0f, kArenaHeight)}; }
-    if (edge == 2) { z.pos = {rng_.uniform(0.0f, kArenaWidth), 0.0f}; }
-    if (edge == 3) { z.pos = {rng_.uniform(0.0f, kArenaWidth), kArenaHeight}; }
+    if (edge == 0) { z.pos = {0.0f, rng_.uniform(0.0f, h)}; }
+    if (edge == 1) { z.pos = {w, rng_.uniform(0.0f, h)}; }
+    if (edge == 2) { z.pos = {rng_.uniform(0.0f, w), 0.0f}; }
+    if (edge == 3) { z.pos = {rng_.uniform(0.0f, w), h}; }
     z.hp = 26.0f + state_.difficulty_scalar * 3.0f;
+    z.id = state_.next_zombie_id++;
     state_.zombies.push_back(z);
+    zombie_neighbors_.invalidate();
 }
 
 void Simulator::update_player(const Action& action) {
@@ -126,10 +224,9 @@ void Simulator::update_player(const Action& action) {
 
     p.pos.x += p.vel.x * kFixedDt;
     p.pos.y += p.vel.y * kFixedDt;
-    for (const auto& obstacle : state_.obstacles) {
-        circle_vs_aabb_resolve(p.pos, kPlayerRadius, obstacle);
-    }
-    sanitize_position(p.pos, {kPlayerSpawnX, kPlayerSpawnY}, kPlayerRadius);
+    obstacle_field_.resolve_circle(p.pos, kPlayerRadius);
+    const Vec2 arena = state_.arena_size;
+    sanitize_position(p.pos, {arena.x * 0.5f, arena.y * 0.5f}, kPlayerRadius, arena);
 
     const int ext_mag = state_.upgrades.levels[static_cast<size_t>(UpgradeId::ExtendedMag)];
     p.mag_capacity = 12 + ext_mag * 3;
@@ -152,15 +249,19 @@ void Simulator::update_player(const Action& action) {
         Vec2 dir = normalize({action.aim_x, action.aim_y});
         if (length(dir) < 0.1f) dir = {1.0f, 0.0f};
 
+        constexpr float kBulletSpeed = 760.0f;
         Bullet b{};
         b.pos = p.pos;
-        b.vel = {dir.x * 760.0f, dir.y * 760.0f};
+        b.vel = {dir.x * kBulletSpeed, dir.y * kBulletSpeed};
 
         const int big_shot = state_.upgrades.levels[static_cast<size_t>(UpgradeId::BigShot)];
         const int pierce = state_.upgrades.levels[static_cast<size_t>(UpgradeId::PiercingRounds)];
         b.radius = 4.0f + big_shot * 1.0f;
         b.damage = 22.0f + big_shot * 9.0f;
         b.pierce = pierce;
+        // The first update_bullets move happens on this tick.
+        const uint64_t impact = bullet_obstacle_ticks(b.pos, dir, kBulletSpeed, b.radius, state_.obstacles);
+        b.expire_tick = impact == kNoBulletImpact ? kNoBulletImpact : state_.tick + impact - 1;
 
         state_.bullets.push_back(b);
         p.mag -= 1;
@@ -171,6 +272,12 @@ void Simulator::update_player(const Action& action) {
 
 void Simulator::update_zombies() {
     auto& p = state_.player;
+    const Vec2 arena = state_.arena_size;
+    if (state_.tick % kZombieReorderIntervalTicks == 0) {
+        sort_zombies_by_morton(state_.zombies);
+        zombie_neighbors_.invalidate();
+    }
+
     for (auto& z : state_.zombies) {
         z.slow_timer = std::max(0.0f, z.slow_timer - kFixedDt);
         z.touch_cd = std::max(0.0f, z.touch_cd - kFixedDt);
@@ -181,128 +288,116 @@ void Simulator::update_zombies() {
         z.vel = {dir.x * speed, dir.y * speed};
         z.pos.x += z.vel.x * kFixedDt;
         z.pos.y += z.vel.y * kFixedDt;
-        sanitize_position(z.pos, p.pos, kZombieRadius);
+        sanitize_position(z.pos, p.pos, kZombieRadius, arena);
     }
 
-    for (int it = 0; it < 2; ++it) {
-        for (size_t i = 0; i < state_.zombies.size(); ++i) {
-            for (size_t j = i + 1; j < state_.zombies.size(); ++j) {
-                Vec2 d{state_.zombies[j].pos.x - state_.zombies[i].pos.x, state_.zombies[j].pos.y - state_.zombies[i].pos.y};
-                float l = length(d);
-                Vec2 n{};
-                if (l > 1e-6f) {
-                    n = {d.x / l, d.y / l};
-                } else {
-                    n = fallback_normal_for_pair(i, j);
-                    l = 0.0f;
-                }
-
-                if (l < kZombieSeparationRadius) {
-                    const float penetration = kZombieSeparationRadius - l;
-                    const float push = std::min(0.5f * penetration, kMaxSeparationCorrectionPerTick);
-                    state_.zombies[i].pos.x -= n.x * push;
-                    state_.zombies[i].pos.y -= n.y * push;
-                    state_.zombies[j].pos.x += n.x * push;
-                    state_.zombies[j].pos.y += n.y * push;
-                }
-
-                sanitize_position(state_.zombies[i].pos, p.pos, kZombieRadius);
-                sanitize_position(state_.zombies[j].pos, p.pos, kZombieRadius);
-            }
-        }
-
-        for (size_t i = 0; i < state_.zombies.size(); ++i) {
-            auto& z = state_.zombies[i];
-            Vec2 d{z.pos.x - p.pos.x, z.pos.y - p.pos.y};
-            float l = length(d);
-            const float min_dist = kPlayerRadius + kZombieRadius;
-            if (l < min_dist) {
-                Vec2 n{};
-                if (l > 1e-6f) {
-                    n = {d.x / l, d.y / l};
-                } else {
-                    n = fallback_normal_for_pair(i, state_.zombies.size() + 1);
-                    l = 0.0f;
-                }
-
-                const float penetration = min_dist - l;
-                const float z_push = std::min(0.9f * penetration, kMaxSeparationCorrectionPerTick);
-                const float p_push = std::min(0.1f * penetration, 1.2f);
-                z.pos.x += n.x * z_push;
-                z.pos.y += n.y * z_push;
-                p.pos.x -= n.x * p_push;
-                p.pos.y -= n.y * p_push;
-
-                sanitize_position(z.pos, p.pos, kZombieRadius);
-                sanitize_position(p.pos, {kPlayerSpawnX, kPlayerSpawnY}, kPlayerRadius);
-            }
-        }
-    }
+    separate_zombies(state_.zombies, p.pos, arena, config_.neighbor_search, zombie_neighbors_,
+                     config_.separation_solver, separation_pool_.get());
 
     for (auto& z : state_.zombies) {
-        for (const auto& obstacle : state_.obstacles) {
-            circle_vs_aabb_resolve(z.pos, kZombieRadius, obstacle);
-        }
-        sanitize_position(z.pos, p.pos, kZombieRadius);
+        obstacle_field_.resolve_circle(z.pos, kZombieRadius);
+        sanitize_position(z.pos, p.pos, kZombieRadius, arena);
     }
-    sanitize_position(p.pos, {kPlayerSpawnX, kPlayerSpawnY}, kPlayerRadius);
+    sanitize_position(p.pos, {arena.x * 0.5f, arena.y * 0.5f}, kPlayerRadius, arena);
 }
 
 void Simulator::update_bullets() {
     const int frost = state_.upgrades.levels[static_cast<size_t>(UpgradeId::FrostRounds)];
+    std::vector<uint32_t> hits;
 
     for (auto& b : state_.bullets) {
         b.pos.x += b.vel.x * kFixedDt;
         b.pos.y += b.vel.y * kFixedDt;
 
-        bool hit_obstacle = false;
-        for (const auto& obstacle : state_.obstacles) {
-            if (circle_vs_aabb_overlap(b.pos, b.radius, obstacle)) {
-                b.pos = {-1000.0f, -1000.0f};
-                hit_obstacle = true;
-                break;
-            }
+        if (state_.tick >= b.expire_tick) {
+            b.pos = {-1000.0f, -1000.0f};
+            continue;
         }
-        if (hit_obstacle) continue;
 
-        for (auto& z : state_.zombies) {
+        hits.clear();
+        for (uint32_t i = 0; i < state_.zombies.size(); ++i) {
+            const auto& z = state_.zombies[i];
             Vec2 d{z.pos.x - b.pos.x, z.pos.y - b.pos.y};
-            if (length(d) <= (10.0f + b.radius)) {
-                const float damage_applied = std::min(z.hp, b.damage);
-                z.hp -= b.damage;
-                state_.stats.damage_dealt += std::max(0.0f, damage_applied);
-                if (frost > 0) z.slow_timer = std::max(z.slow_timer, 0.4f + 0.3f * frost);
-                b.pierce -= 1;
-                state_.stats.shots_hit += 1;
-                if (b.pierce < 0) {
-                    b.pos = {-1000.0f, -1000.0f};
-                    break;
-                }
+            if (length(d) <= (10.0f + b.radius)) hits.push_back(i);
+        }
+        // Pierce is spent in Zombie::id order so the storage order never decides who gets hit.
+        std::sort(hits.begin(), hits.end(),
+                  [&](uint32_t a, uint32_t c) { return state_.zombies[a].id < state_.zombies[c].id; });
+
+        for (const uint32_t i : hits) {
+            auto& z = state_.zombies[i];
+            const float damage_applied = std::min(z.hp, b.damage);
+            z.hp -= b.damage;
+            state_.stats.damage_dealt += std::max(0.0f, damage_applied);
+            if (frost > 0) z.slow_timer = std::max(z.slow_timer, 0.4f + 0.3f * frost);
+            b.pierce -= 1;
+            state_.stats.shots_hit += 1;
+            if (b.pierce < 0) {
+                b.pos = {-1000.0f, -1000.0f};
+                break;
             }
         }
     }
 
+    const Vec2 arena = state_.arena_size;
     state_.bullets.erase(
-        std::remove_if(state_.bullets.begin(), state_.bullets.end(), [](const Bullet& b) {
-            return b.pos.x < 0.0f || b.pos.y < 0.0f || b.pos.x > kArenaWidth || b.pos.y > kArenaHeight;
+        std::remove_if(state_.bullets.begin(), state_.bullets.end(), [arena](const Bullet& b) {
+            return b.pos.x < 0.0f || b.pos.y < 0.0f || b.pos.x > arena.x || b.pos.y > arena.y;
         }),
         state_.bullets.end());
 
     const size_t prev = state_.zombies.size();
     state_.zombies.erase(std::remove_if(state_.zombies.begin(), state_.zombies.end(), [](const Zombie& z) { return z.hp <= 0.0f; }),
                          state_.zombies.end());
+    if (state_.zombies.size() != prev) zombie_neighbors_.invalidate();
     state_.stats.kills += static_cast<int>(prev - state_.zombies.size());
 }
 
-void Simulator::apply_ring_of_fire() {
+// Ring of Fire ticks, contact damage and the observation/reward zombie queries
+// all need the same player-relative deltas, so they share one pass.
+template <int NZombies, int NRays>
+BasicZombieSweep<NZombies, NRays> Simulator::sweep_zombies() {
     const int level = state_.upgrades.levels[static_cast<size_t>(UpgradeId::RingOfFire)];
-    if (level <= 0) return;
-    const float radius = 70.0f + level * 16.0f;
-    const float dps = 18.0f + level * 7.0f;
-    for (auto& z : state_.zombies) {
-        Vec2 d{z.pos.x - state_.player.pos.x, z.pos.y - state_.player.pos.y};
-        if (length(d) < radius) z.hp -= dps * kFixedDt;
+    const float ring_radius = ring_of_fire_radius(level);
+    const float ring_damage = (18.0f + level * 7.0f) * kFixedDt;
+    const bool vulnerable = state_.player.invuln_timer <= 0.0f;
+    const Vec2 p = state_.player.pos;
+
+    const bool use_grid = config_.zombie_ray_search == ZombieRaySearch::GridDDA &&
+                          state_.zombies.size() >= zombie_ray_grid_min_zombies(NRays);
+
+    BasicZombieSweep<NZombies, NRays> sweep;
+    for (size_t i = 0; i < state_.zombies.size(); ++i) {
+        auto& z = state_.zombies[i];
+        const float dx = z.pos.x - p.x;
+        const float dy = z.pos.y - p.y;
+        const float dist_sq = dx * dx + dy * dy;
+        const float dist = std::sqrt(dist_sq);
+
+        if (level > 0 && dist < ring_radius) z.hp -= ring_damage;
+
+        if (dist < (kPlayerRadius + kZombieRadius) && z.touch_cd <= 0.0f && vulnerable) {
+            state_.player.health -= 10.0f;
+            state_.stats.damage_taken += 10.0f;
+            z.touch_cd = 1.5f;
+        }
+
+        if (use_grid) {
+            sweep.add_nearest(static_cast<uint32_t>(i), z.id, dist_sq);
+        } else {
+            sweep.add(static_cast<uint32_t>(i), z.id, dx, dy, dist_sq);
+        }
+    }
+
+    if (use_grid) {
+        if (sweep.in_contact()) {
+            sweep.ray_t.fill(0.0f);
+        } else {
+            zombie_ray_grid_.build(state_.zombies, state_.arena_size);
+            zombie_ray_grid_.cast(p, ray_directions<NRays>(), sweep.ray_t);
+        }
     }
+    return sweep;
 }
 
 void Simulator::handle_upgrade_choice(const Action& action) {
@@ -326,7 +421,7 @@ void Simulator::handle_upgrade_choice(const Action& action) {
     roll_upgrade_offer();
 }
 
-float Simulator::compute_reward(const RuntimeStats& prev) const {
+float Simulator::compute_reward(const RuntimeStats& prev, float nearest_zombie) const {
     float reward = 0.02f;
     const int kills_delta = state_.stats.kills - prev.kills;
     const float damage_taken_delta = state_.stats.damage_taken - prev.damage_taken;
@@ -339,39 +434,24 @@ float Simulator::compute_reward(const RuntimeStats& prev) const {
     reward += damage_dealt_delta * 0.002f;
     reward -= damage_taken_delta * 0.05f;
 
-    const float nearest = [&]() {
-        float best = 9999.0f;
-        for (const auto& z : state_.zombies) {
-            const float d = length({z.pos.x - state_.player.pos.x, z.pos.y - state_.player.pos.y});
-            best = std::min(best, d);
-        }
-        return best;
-    }();
-    if (nearest < 120.0f) reward -= (120.0f - nearest) * 0.0008f;
+    if (nearest_zombie < 120.0f) reward -= (120.0f - nearest_zombie) * 0.0008f;
 
     if (shots_delta > 0 && hits_delta == 0) reward -= 0.008f * shots_delta;
     return reward;
 }
 
-StepResult Simulator::step(const Action& action) {
+template <int NZombies, int NRays>
+StepResult Simulator::step_layout(const Action& action) {
     RuntimeStats prev_stats = state_.stats;
 
     handle_upgrade_choice(action);
 
+    BasicZombieSweep<NZombies, NRays> sweep;
     if (state_.play_state == PlayState::Playing) {
         update_player(action);
         update_zombies();
         update_bullets();
-        apply_ring_of_fire();
-
-        for (auto& z : state_.zombies) {
-            Vec2 d{z.pos.x - state_.player.pos.x, z.pos.y - state_.player.pos.y};
-            if (length(d) < (kPlayerRadius + kZombieRadius) && z.touch_cd <= 0.0f && state_.player.invuln_timer <= 0.0f) {
-                state_.player.health -= 10.0f;
-                state_.stats.damage_taken += 10.0f;
-                z.touch_cd = 1.5f;
-            }
-        }
+        sweep = sweep_zombies<NZombies, NRays>();
 
         state_.player.health = std::max(0.0f, state_.player.health);
 
@@ -386,14 +466,21 @@ StepResult Simulator::step(const Action& action) {
 
         if (state_.player.health <= 0.0f) state_.play_state = PlayState::Dead;
 
-        state_.difficulty_scalar = state_.episode_time_s / 90.0f;
-        const float spawn_rate = 1.0f + state_.difficulty_scalar * 1.2f;
-        const int max_alive = 16 + static_cast<int>(state_.difficulty_scalar * 18.0f);
+        state_.difficulty_scalar = state_.episode_time_s / config_.difficulty_ramp_seconds;
+        const float spawn_rate = config_.spawn_rate_base + state_.difficulty_scalar * config_.spawn_rate_per_difficulty;
+        int max_alive = config_.max_alive_base + static_cast<int>(state_.difficulty_scalar * config_.max_alive_per_difficulty);
+        if (config_.max_alive_cap > 0) max_alive = std::min(max_alive, config_.max_alive_cap);
         state_.spawn_budget += spawn_rate * kFixedDt;
+        const size_t swept = state_.zombies.size();
         while (state_.spawn_budget > 1.0f && static_cast<int>(state_.zombies.size()) < max_alive) {
             state_.spawn_budget -= 1.0f;
             spawn_zombie();
         }
+        for (size_t i = swept; i < state_.zombies.size(); ++i) {
+            const float dx = state_.zombies[i].pos.x - state_.player.pos.x;
+            const float dy = state_.zombies[i].pos.y - state_.player.pos.y;
+            sweep.add(static_cast<uint32_t>(i), state_.zombies[i].id, dx, dy, dx * dx + dy * dy);
+        }
 
         state_.upgrade_clock += kFixedDt;
         if (state_.upgrade_clock >= 20.0f) {
@@ -415,13 +502,15 @@ StepResult Simulator::step(const Action& action) {
             assert(z.slow_timer >= 0.0f);
         }
 #endif
+    } else {
+        sweep = lv::sweep_zombies<NZombies, NRays>(state_);
     }
 
     StepResult out{};
-    out.observation = build_observation(state_);
-    out.reward = compute_reward(prev_stats);
+    out.observation = build_observation(state_, sweep, &obstacle_field_);
+    out.reward = compute_reward(prev_stats, sweep.nearest_distance(9999.0f));
     out.terminated = state_.play_state == PlayState::Dead;
-    out.truncated = state_.episode_time_s >= kEpisodeLimitSeconds;
+    out.truncated = state_.episode_time_s >= config_.episode_limit_seconds;
     out.info.kills = state_.stats.kills;
     out.info.damage_taken = state_.stats.damage_taken;
     out.info.shots_fired = state_.stats.shots_fired;
@@ -0,0 +1,260 @@
+#include "lastvector/byte_io.hpp"
+#include "lastvector/sim.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <string>
+
+namespace lv {
+
+namespace {
+
+constexpr uint32_t kMaxEntities = 1U << 20;
+
+void put_vec(ByteWriter& w, Vec2 v) {
+    w.put(v.x);
+    w.put(v.y);
+}
+
+Vec2 get_vec(ByteReader& r) {
+    const float x = r.get<float>();
+    return {x, r.get<float>()};
+}
+
+uint32_t get_count(ByteReader& r, const char* what) {
+    const auto n = r.get<uint32_t>();
+    if (n > kMaxEntities) r.fail(std::string(what) + " count " + std::to_string(n));
+    return n;
+}
+
+class StateHasher {
+  public:
+    void word(uint64_t v) { h_ = (std::rotl(h_ ^ v, 27) * 0x9e3779b97f4a7c15ULL) + 0x52dce729ULL; }
+    void real(float f) { word(std::bit_cast<uint32_t>(f)); }
+    void vec(Vec2 v) { word((uint64_t{std::bit_cast<uint32_t>(v.x)} << 32) | std::bit_cast<uint32_t>(v.y)); }
+
+    // MurmurHash3's finalizer, so every input bit reaches every output bit.
+    uint64_t finish() const {
+        uint64_t k = h_;
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+  private:
+    uint64_t h_ = 0x243f6a8885a308d3ULL;
+};
+
+bool same_obstacles(const std::vector<Obstacle>& a, const std::vector<Obstacle>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Obstacle& l, const Obstacle& r) {
+        return l.x == r.x && l.y == r.y && l.w == r.w && l.h == r.h;
+    });
+}
+
+} // namespace
+
+void Simulator::save_state(std::vector<uint8_t>& out) const {
+    ByteWriter w(out);
+    const GameState& s = state_;
+    w.put(s.seed);
+    w.put(s.tick);
+    w.put(s.episode_time_s);
+    w.put(static_cast<uint8_t>(s.play_state));
+    w.put(s.difficulty_scalar);
+    put_vec(w, s.arena_size);
+
+    const Player& p = s.player;
+    put_vec(w, p.pos);
+    put_vec(w, p.vel);
+    for (const float f : {p.health, p.max_health, p.stamina, p.max_stamina}) w.put(f);
+    for (const int i : {p.mag, p.mag_capacity, p.reserve}) w.put(static_cast<int32_t>(i));
+    for (const float f : {p.shoot_cd, p.reload_timer, p.invuln_timer}) w.put(f);
+
+    w.put(static_cast<uint32_t>(s.zombies.size()));
+    for (const Zombie& z : s.zombies) {
+        w.put(z.id);
+        put_vec(w, z.pos);
+        put_vec(w, z.vel);
+        w.put(z.hp);
+        w.put(z.slow_timer);
+        w.put(z.touch_cd);
+    }
+    w.put(static_cast<uint32_t>(s.bullets.size()));
+    for (const Bullet& b : s.bullets) {
+        put_vec(w, b.pos);
+        put_vec(w, b.vel);
+        w.put(b.radius);
+        w.put(b.damage);
+        w.put(static_cast<int32_t>(b.pierce));
+        w.put(b.expire_tick);
+    }
+    w.put(static_cast<uint32_t>(s.obstacles.size()));
+    for (const Obstacle& o : s.obstacles) {
+        for (const float f : {o.x, o.y, o.w, o.h}) w.put(f);
+    }
+
+    w.put(static_cast<uint32_t>(s.upgrades.levels.size()));
+    for (const int level : s.upgrades.levels) w.put(static_cast<int32_t>(level));
+    w.put(static_cast<uint8_t>(s.upgrades.second_wind_used));
+    for (const UpgradeId id : s.upgrade_offer) w.put(static_cast<uint8_t>(id));
+
+    w.put(s.next_zombie_id);
+    w.put(s.spawn_budget);
+    w.put(s.upgrade_clock);
+    w.put(static_cast<int32_t>(s.stats.kills));
+    w.put(s.stats.damage_taken);
+    w.put(static_cast<int32_t>(s.stats.shots_fired));
+    w.put(static_cast<int32_t>(s.stats.shots_hit));
+    w.put(s.stats.damage_dealt);
+
+    w.put(rng_.draws());
+    w.put(static_cast<int32_t>(upgrade_pause_ticks_));
+}
+
+void Simulator::load_state(std::span<const uint8_t> bytes) {
+    ByteReader r(bytes, "simulator state");
+    GameState s;
+    s.seed = r.get<uint64_t>();
+    s.tick = r.get<uint64_t>();
+    s.episode_time_s = r.get<float>();
+    const auto play_state = r.get<uint8_t>();
+    if (play_state > static_cast<uint8_t>(PlayState::Dead)) r.fail("play state " + std::to_string(play_state));
+    s.play_state = static_cast<PlayState>(play_state);
+    s.difficulty_scalar = r.get<float>();
+    s.arena_size = get_vec(r);
+    if (s.arena_size.x != config_.arena_width || s.arena_size.y != config_.arena_height) {
+        r.fail("saved with a different arena size");
+    }
+
+    Player& p = s.player;
+    p.pos = get_vec(r);
+    p.vel = get_vec(r);
+    for (float* f : {&p.health, &p.max_health, &p.stamina, &p.max_stamina}) *f = r.get<float>();
+    for (int* i : {&p.mag, &p.mag_capacity, &p.reserve}) *i = r.get<int32_t>();
+    for (float* f : {&p.shoot_cd, &p.reload_timer, &p.invuln_timer}) *f = r.get<float>();
+
+    s.zombies.resize(get_count(r, "zombie"));
+    for (Zombie& z : s.zombies) {
+        z.id = r.get<uint32_t>();
+        z.pos = get_vec(r);
+        z.vel = get_vec(r);
+        z.hp = r.get<float>();
+        z.slow_timer = r.get<float>();
+        z.touch_cd = r.get<float>();
+    }
+    s.bullets.resize(get_count(r, "bullet"));
+    for (Bullet& b : s.bullets) {
+        b.pos = get_vec(r);
+        b.vel = get_vec(r);
+        b.radius = r.get<float>();
+        b.damage = r.get<float>();
+        b.pierce = r.get<int32_t>();
+        b.expire_tick = r.get<uint64_t>();
+    }
+    s.obstacles.resize(get_count(r, "obstacle"));
+    for (Obstacle& o : s.obstacles) {
+        for (float* f : {&o.x, &o.y, &o.w, &o.h}) *f = r.get<float>();
+    }
+
+    if (r.get<uint32_t>() != s.upgrades.levels.size()) r.fail("saved with a different upgrade catalog");
+    for (int& level : s.upgrades.levels) level = r.get<int32_t>();
+    s.upgrades.second_wind_used = r.get<uint8_t>() != 0;
+    for (UpgradeId& id : s.upgrade_offer) {
+        const auto raw = r.get<uint8_t>();
+        if (raw >= static_cast<uint8_t>(UpgradeId::Count)) r.fail("upgrade id " + std::to_string(raw));
+        id = static_cast<UpgradeId>(raw);
+    }
+
+    s.next_zombie_id = r.get<uint32_t>();
+    s.spawn_budget = r.get<float>();
+    s.upgrade_clock = r.get<float>();
+    s.stats.kills = r.get<int32_t>();
+    s.stats.damage_taken = r.get<float>();
+    s.stats.shots_fired = r.get<int32_t>();
+    s.stats.shots_hit = r.get<int32_t>();
+    s.stats.damage_dealt = r.get<float>();
+
+    const auto draws = r.get<uint64_t>();
+    const auto pause_ticks = r.get<int32_t>();
+    if (r.remaining() != 0) r.fail("trailing bytes");
+
+    const bool rebuild_static = !same_obstacles(s.obstacles, state_.obstacles);
+    state_ = std::move(s);
+    rng_.restore(state_.seed, draws);
+    upgrade_pause_ticks_ = pause_ticks;
+    zombie_neighbors_.invalidate();
+    if (rebuild_static) {
+        obstacle_field_.build(state_.obstacles, state_.arena_size, config_.obstacle_field_cell_size);
+        occupancy_grid_.build_static(state_.obstacles, state_.arena_size);
+    }
+    update_state_hash();
+}
+
+// Recomputed in one pass rather than updated per change: every zombie and
+// bullet moves every tick, so there is nothing to skip.
+void Simulator::update_state_hash() {
+    const GameState& s = state_;
+    StateHasher h;
+    h.word(s.tick);
+    h.word(static_cast<uint64_t>(s.play_state));
+    h.real(s.episode_time_s);
+    h.real(s.difficulty_scalar);
+
+    const Player& p = s.player;
+    h.vec(p.pos);
+    h.vec(p.vel);
+    for (const float f : {p.health, p.max_health, p.stamina, p.max_stamina, p.shoot_cd, p.reload_timer,
+                          p.invuln_timer}) {
+        h.real(f);
+    }
+    for (const int i : {p.mag, p.mag_capacity, p.reserve}) h.word(static_cast<uint32_t>(i));
+
+    for (const int level : s.upgrades.levels) h.word(static_cast<uint32_t>(level));
+    h.word(s.upgrades.second_wind_used ? 1 : 0);
+    for (const UpgradeId id : s.upgrade_offer) h.word(static_cast<uint64_t>(id));
+    h.word(static_cast<uint32_t>(upgrade_pause_ticks_));
+
+    h.word(s.next_zombie_id);
+    h.real(s.spawn_budget);
+    h.real(s.upgrade_clock);
+    h.word(static_cast<uint32_t>(s.stats.kills));
+    h.word(static_cast<uint32_t>(s.stats.shots_fired));
+    h.word(static_cast<uint32_t>(s.stats.shots_hit));
+    h.real(s.stats.damage_taken);
+    h.real(s.stats.damage_dealt);
+    h.word(rng_.draws());
+
+    // Sums of per-entity hashes: independent of vector order.
+    uint64_t zombies = 0;
+    for (const Zombie& z : s.zombies) {
+        StateHasher e;
+        e.word(z.id);
+        e.vec(z.pos);
+        e.vec(z.vel);
+        e.real(z.hp);
+        e.real(z.slow_timer);
+        e.real(z.touch_cd);
+        zombies += e.finish();
+    }
+    uint64_t bullets = 0;
+    for (const Bullet& b : s.bullets) {
+        StateHasher e;
+        e.vec(b.pos);
+        e.vec(b.vel);
+        e.real(b.radius);
+        e.real(b.damage);
+        e.word(static_cast<uint32_t>(b.pierce));
+        e.word(b.expire_tick);
+        bullets += e.finish();
+    }
+    h.word(s.zombies.size());
+    h.word(zombies);
+    h.word(s.bullets.size());
+    h.word(bullets);
+    state_hash_ = h.finish();
+}
+
+} // namespace lv
@@ -0,0 +1,79 @@
+#include "lastvector/sim_thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace lv {
+
+SimThread::SimThread(Simulator& sim, ActFn act, StepFn after_step, int speed, int max_ticks)
+    : sim_(sim), act_(std::move(act)), after_step_(std::move(after_step)), max_ticks_(max_ticks),
+      speed_(std::clamp(speed, 1, kMaxSpeed)) {
+    if (!act_) throw std::invalid_argument("SimThread needs an action function");
+    if (max_ticks_ < 0) throw std::invalid_argument("SimThread max_ticks must be >= 0");
+    capture_snapshot(sim_.state(), {}, current_);
+    current_.published = std::chrono::steady_clock::now();
+    previous_ = current_;
+    thread_ = std::thread([this] { run(); });
+}
+
+SimThread::~SimThread() { stop(); }
+
+void SimThread::set_speed(int speed) { speed_.store(std::clamp(speed, 1, kMaxSpeed), std::memory_order_relaxed); }
+
+bool SimThread::poll() {
+    if (!snapshots_.acquire()) return false;
+    std::swap(previous_, current_);
+    current_ = snapshots_.front();
+    return true;
+}
+
+void SimThread::rethrow_if_failed() const {
+    // error_ is written before finished_ is set and never again.
+    if (finished() && error_) std::rethrow_exception(error_);
+}
+
+void SimThread::stop() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (thread_.joinable()) thread_.join();
+}
+
+void SimThread::run() {
+    using clock = std::chrono::steady_clock;
+    constexpr auto kMaxLag = std::chrono::milliseconds(250);
+    const auto tick_length = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(kFixedDt));
+
+    auto next = clock::now();
+    try {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            const Action action = act_(sim_);
+            const StepResult res = sim_.step(action);
+            if (after_step_) after_step_(sim_);
+
+            const uint64_t ticks = ticks_.fetch_add(1, std::memory_order_relaxed) + 1;
+            RenderSnapshot& snapshot = snapshots_.back();
+            capture_snapshot(sim_.state(), {action.aim_x, action.aim_y}, snapshot);
+            snapshot.sequence = ticks;
+            snapshot.published = clock::now();
+            snapshots_.publish();
+
+            if (res.terminated || res.truncated || (max_ticks_ > 0 && ticks >= static_cast<uint64_t>(max_ticks_))) {
+                break;
+            }
+
+            next += tick_length / speed_.load(std::memory_order_relaxed);
+            const auto now = clock::now();
+            if (now - next > kMaxLag) {
+                next = now;
+            } else {
+                std::this_thread::sleep_until(next);
+            }
+        }
+    } catch (...) {
+        error_ = std::current_exception();
+    }
+    finished_.store(true, std::memory_order_release);
+}
+
+} // namespace lv
@@ -0,0 +1,166 @@
+#include "lastvector/software_renderer.hpp"
+#include "lastvector/int_round.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace lv {
+
+namespace {
+
+struct Rgb {
+    uint8_t r, g, b;
+};
+
+// raylib palette, so recordings look like the rendered client.
+constexpr Rgb kBackground{0, 0, 0};
+constexpr Rgb kArenaBorder{80, 80, 80};
+constexpr Rgb kObstacleFill{40, 40, 40};
+constexpr Rgb kObstacleEdge{130, 130, 130};
+constexpr Rgb kPlayer{0, 228, 48};
+constexpr Rgb kZombie{230, 41, 55};
+constexpr Rgb kBullet{253, 249, 0};
+constexpr Rgb kBarBack{50, 50, 50};
+constexpr Rgb kHealth{230, 41, 55};
+constexpr Rgb kStamina{102, 191, 255};
+
+struct PixelRect {
+    int x0, y0, x1, y1;
+};
+
+class Canvas {
+  public:
+    Canvas(uint8_t* pixels, int width, int height) : pixels_(pixels), width_(width), height_(height) {}
+
+    // Pixels [x0, x1] of row y, clipped.
+    void span(int y, int x0, int x1, Rgb c) {
+        if (y < 0 || y >= height_) return;
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, width_ - 1);
+        if (x0 > x1) return;
+        uint8_t* dst = pixels_ + (static_cast<size_t>(y) * width_ + x0) * 3;
+        fill_pixels(dst, static_cast<size_t>(x1 - x0 + 1), c);
+    }
+
+    void clear(Rgb c) { fill_pixels(pixels_, static_cast<size_t>(width_) * height_, c); }
+
+    // Pixel-space rectangle [x0, x1] x [y0, y1].
+    void rect(int x0, int y0, int x1, int y1, Rgb c) {
+        for (int y = std::max(y0, 0); y <= std::min(y1, height_ - 1); ++y) span(y, x0, x1, c);
+    }
+
+    void rect_outline(int x0, int y0, int x1, int y1, int thickness, Rgb c) {
+        rect(x0, y0, x1, y0 + thickness - 1, c);
+        rect(x0, y1 - thickness + 1, x1, y1, c);
+        rect(x0, y0, x0 + thickness - 1, y1, c);
+        rect(x1 - thickness + 1, y0, x1, y1, c);
+    }
+
+    // Pixels whose centers lie inside the circle; at least the pixel holding
+    // the center, so sub-pixel bullets stay visible.
+    void disc(float cx, float cy, float r, Rgb c) {
+        if (cx + r < 0.0f || cy + r < 0.0f || cx - r > static_cast<float>(width_) || cy - r > static_cast<float>(height_)) {
+            return;
+        }
+        const float r_sq = r * r;
+        const int y0 = std::max(0, ceil_int(cy - r - 0.5f));
+        const int y1 = std::min(height_ - 1, floor_int(cy + r - 0.5f));
+        for (int y = y0; y <= y1; ++y) {
+            const float dy = static_cast<float>(y) + 0.5f - cy;
+            const float span_sq = r_sq - dy * dy;
+            if (span_sq < 0.0f) continue;
+            const float half = std::sqrt(span_sq);
+            span(y, ceil_int(cx - half - 0.5f), floor_int(cx + half - 0.5f), c);
+        }
+        const int px = floor_int(cx);
+        span(floor_int(cy), px, px, c);
+    }
+
+  private:
+    uint8_t* pixels_;
+    int width_;
+    int height_;
+
+    // RGB pixels are 3 bytes, so memset does not apply; write one pixel and
+    // double the filled prefix with memcpy instead.
+    static void fill_pixels(uint8_t* dst, size_t count, Rgb c) {
+        dst[0] = c.r;
+        dst[1] = c.g;
+        dst[2] = c.b;
+        const size_t total = count * 3;
+        size_t done = 3;
+        while (done < total) {
+            const size_t n = std::min(done, total - done);
+            std::memcpy(dst + done, dst, n);
+            done += n;
+        }
+    }
+};
+
+} // namespace
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, float view_width)
+    : width_(width), height_(height), scale_(static_cast<float>(width) / view_width) {
+    if (width <= 0 || height <= 0) throw std::invalid_argument("SoftwareRenderer: frame size must be positive");
+    if (!(view_width > 0.0f) || !std::isfinite(view_width)) {
+        throw std::invalid_argument("SoftwareRenderer: view_width must be positive");
+    }
+}
+
+void SoftwareRenderer::render(const GameState& state, std::span<uint8_t> out, bool hud) const {
+    if (out.size() != frame_bytes()) {
+        throw std::invalid_argument("frame buffer has " + std::to_string(out.size()) + " bytes, expected " +
+                                    std::to_string(frame_bytes()));
+    }
+    Canvas canvas(out.data(), width_, height_);
+    canvas.clear(kBackground);
+
+    // World -> pixel: the player sits at the frame center.
+    const float ox = state.player.pos.x - 0.5f * static_cast<float>(width_) / scale_;
+    const float oy = state.player.pos.y - 0.5f * static_cast<float>(height_) / scale_;
+    const auto px = [&](float x) { return (x - ox) * scale_; };
+    const auto py = [&](float y) { return (y - oy) * scale_; };
+    // Pixel bounds clamped well outside the frame before the int conversion.
+    const float lo = -4.0f;
+    const float hi_x = static_cast<float>(width_) + 4.0f;
+    const float hi_y = static_cast<float>(height_) + 4.0f;
+    const auto pixel_rect = [&](float x, float y, float w, float h) {
+        return PixelRect{floor_int(std::clamp(px(x), lo, hi_x)), floor_int(std::clamp(py(y), lo, hi_y)),
+                         floor_int(std::clamp(px(x + w), lo, hi_x)), floor_int(std::clamp(py(y + h), lo, hi_y))};
+    };
+
+    const auto arena = pixel_rect(0.0f, 0.0f, state.arena_size.x, state.arena_size.y);
+    const int border = std::max(1, static_cast<int>(2.0f * scale_ + 0.5f));
+    canvas.rect_outline(arena.x0, arena.y0, arena.x1, arena.y1, border, kArenaBorder);
+
+    for (const auto& o : state.obstacles) {
+        const auto r = pixel_rect(o.x, o.y, o.w, o.h);
+        canvas.rect(r.x0, r.y0, r.x1, r.y1, kObstacleFill);
+        canvas.rect_outline(r.x0, r.y0, r.x1, r.y1, 1, kObstacleEdge);
+    }
+
+    const float zombie_r = kZombieRadius * scale_;
+    for (const auto& z : state.zombies) canvas.disc(px(z.pos.x), py(z.pos.y), zombie_r, kZombie);
+    for (const auto& b : state.bullets) canvas.disc(px(b.pos.x), py(b.pos.y), b.radius * scale_, kBullet);
+    canvas.disc(px(state.player.pos.x), py(state.player.pos.y), kPlayerRadius * scale_, kPlayer);
+
+    if (hud) {
+        const int bar_w = std::max(8, width_ / 5);
+        const int bar_h = std::max(2, height_ / 60);
+        const int margin = std::max(2, height_ / 45);
+        const auto bar = [&](int row, float value, float max_value, Rgb c) {
+            const int y0 = margin + row * (bar_h + margin / 2);
+            const float frac = max_value > 0.0f ? std::clamp(value / max_value, 0.0f, 1.0f) : 0.0f;
+            canvas.rect(margin, y0, margin + bar_w - 1, y0 + bar_h - 1, kBarBack);
+            const int fill = static_cast<int>(frac * static_cast<float>(bar_w) + 0.5f);
+            if (fill > 0) canvas.rect(margin, y0, margin + fill - 1, y0 + bar_h - 1, c);
+        };
+        bar(0, state.player.health, state.player.max_health, kHealth);
+        bar(1, state.player.stamina, state.player.max_stamina, kStamina);
+    }
+}
+
+} // namespace lv
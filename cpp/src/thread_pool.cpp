@@ -0,0 +1,146 @@
+#include "lastvector/thread_pool.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+
+namespace lv {
+
+ThreadPool::ThreadPool(int threads) {
+    const int extra = std::max(1, threads) - 1;
+    workers_.reserve(static_cast<size_t>(extra));
+    for (int i = 0; i < extra; ++i) {
+        workers_.emplace_back([this, i] { worker_loop(i + 1); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+// With fewer items than threads, each of the first `count` threads gets one
+// and the rest sit the job out.
+std::pair<size_t, size_t> ThreadPool::chunk_range(int chunk) const {
+    const size_t n = std::min(static_cast<size_t>(size()), job_count_);
+    const size_t c = static_cast<size_t>(chunk);
+    if (c >= n) return {job_count_, job_count_};
+    return {job_count_ * c / n, job_count_ * (c + 1) / n};
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn) {
+    if (workers_.empty() || count <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        job_count_ = count;
+        pending_ = static_cast<int>(workers_.size());
+        generation_ += 1;
+    }
+    wake_.notify_all();
+
+    const auto [begin, end] = chunk_range(0);
+    fn(begin, end);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+}
+
+namespace {
+
+struct StealRange {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+} // namespace
+
+void ThreadPool::parallel_for_each(size_t count, const std::function<void(size_t, int)>& fn) {
+    const size_t threads = std::min(static_cast<size_t>(size()), count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i, 0);
+        return;
+    }
+
+    const auto ranges = std::make_unique<StealRange[]>(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        ranges[t].begin = count * t / threads;
+        ranges[t].end = count * (t + 1) / threads;
+    }
+
+    const auto take = [&](size_t self) -> std::optional<size_t> {
+        StealRange& own = ranges[self];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (own.begin < own.end) return own.begin++;
+        }
+        while (true) {
+            size_t victim = threads;
+            size_t most = 0;
+            for (size_t t = 0; t < threads; ++t) {
+                if (t == self) continue;
+                std::lock_guard<std::mutex> lock(ranges[t].mutex);
+                const size_t left = ranges[t].end - ranges[t].begin;
+                if (left > most) {
+                    most = left;
+                    victim = t;
+                }
+            }
+            if (victim == threads) return std::nullopt;
+
+            // The victim may have drained or been robbed since the scan; scoped_lock
+            // also keeps two threads stealing from each other from deadlocking.
+            StealRange& other = ranges[victim];
+            std::scoped_lock lock(own.mutex, other.mutex);
+            const size_t left = other.end - other.begin;
+            if (left == 0) continue;
+            const size_t stolen = (left + 1) / 2;
+            own.begin = other.end - stolen;
+            own.end = other.end;
+            other.end = own.begin;
+            return own.begin++;
+        }
+    };
+
+    parallel_for(threads, [&](size_t begin, size_t end) {
+        for (size_t self = begin; self < end; ++self) {
+            while (const auto item = take(self)) fn(*item, static_cast<int>(self));
+        }
+    });
+}
+
+void ThreadPool::worker_loop(int chunk) {
+    uint64_t seen = 0;
+    while (true) {
+        const std::function<void(size_t, size_t)>* job = nullptr;
+        std::pair<size_t, size_t> range{};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            job = job_;
+            range = chunk_range(chunk);
+        }
+
+        if (range.first < range.second) (*job)(range.first, range.second);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ -= 1;
+        }
+        done_.notify_one();
+    }
+}
+
+} // namespace lv
@@ -0,0 +1,345 @@
+#include "lastvector/trajectory_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace lv {
+
+namespace {
+
+constexpr size_t kMaxRowsDigits = 20; // digits of the largest uint64_t
+constexpr char kIndexFile[] = "index.json";
+
+std::runtime_error sys_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+std::array<float, kActionValues> action_values(const Action& a) {
+    return {a.move_x,
+            a.move_y,
+            a.aim_x,
+            a.aim_y,
+            a.shoot ? 1.0f : 0.0f,
+            a.sprint ? 1.0f : 0.0f,
+            a.reload ? 1.0f : 0.0f,
+            static_cast<float>(a.upgrade_choice)};
+}
+
+// numpy's descr for the record layout documented in trajectory_writer.hpp.
+std::string record_descr(int obs_dim, size_t metrics) {
+    std::string d = "[('obs', '<f4', (" + std::to_string(obs_dim) + ",)), ('action', '<f4', (" +
+                    std::to_string(kActionValues) + ",)), ";
+    if (metrics > 0) d += "('metrics', '<f4', (" + std::to_string(metrics) + ",)), ";
+    d += "('reward', '<f4'), ('seed', '<u8'), ('env', '<u4'), ('step', '<u4'), "
+         "('terminated', '|b1'), ('truncated', '|b1'), ('', '|V2')]";
+    return d;
+}
+
+std::string npy_dict(const std::string& descr, uint64_t rows) {
+    return "{'descr': " + descr + ", 'fortran_order': False, 'shape': (" + std::to_string(rows) + ",), }";
+}
+
+// A .npy 1.0 preamble of exactly `total` bytes (magic, version, length, the
+// header dict padded with spaces and ending in '\n').
+std::string npy_header(const std::string& descr, uint64_t rows, size_t total) {
+    std::string dict = npy_dict(descr, rows);
+    dict.resize(total - 10 - 1, ' ');
+    dict += '\n';
+    const auto len = static_cast<uint16_t>(dict.size());
+    std::string out("\x93NUMPY\x01\x00", 8);
+    out += static_cast<char>(len & 0xff);
+    out += static_cast<char>(len >> 8);
+    return out + dict;
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (const char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+std::vector<std::string> default_trajectory_metrics() {
+    return {"difficulty", "zombies_alive", "shots_fired", "hits", "accuracy", "damage_dealt", "kills", "damage_taken"};
+}
+
+struct TrajectoryWriter::Shard {
+    std::string path;
+    std::string file; // name within the dataset directory
+    int fd = -1;
+    uint8_t* base = nullptr; // header + shard_rows records, reserved up front
+    size_t reserved = 0;
+    uint64_t rows = 0;      // written, under mutex_
+    uint64_t capacity = 0;  // rows the file has room for, under mutex_
+    uint64_t published = 0; // rows in the .npy header and index, under sync_mutex_
+
+    ~Shard() {
+        if (base != nullptr) ::munmap(base, reserved);
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+TrajectoryWriter::TrajectoryWriter(const std::string& dir, TrajectorySpec spec)
+    : dir_(dir), spec_(std::move(spec)) {
+    if (spec_.obs_dim < 1) throw std::invalid_argument("trajectory obs_dim must be >= 1");
+    if (spec_.shard_rows < 1 || spec_.grow_rows < 1) {
+        throw std::invalid_argument("trajectory shard_rows and grow_rows must be >= 1");
+    }
+    if (spec_.flush_interval.count() <= 0) throw std::invalid_argument("trajectory flush_interval must be > 0");
+
+    const size_t metrics = spec_.metrics.size();
+    row_bytes_ = sizeof(float) * (static_cast<size_t>(spec_.obs_dim) + kActionValues + metrics + 1) +
+                 sizeof(uint64_t) + 2 * sizeof(uint32_t) + 2 + 2;
+    if (spec_.shard_rows > (std::numeric_limits<size_t>::max() / 2) / row_bytes_) {
+        throw std::invalid_argument("trajectory shard_rows too large");
+    }
+    descr_ = record_descr(spec_.obs_dim, metrics);
+    // Room for any row count, padded so records start 64-byte aligned.
+    const size_t dict = npy_dict(descr_, 0).size() - 1 + kMaxRowsDigits;
+    header_bytes_ = (10 + dict + 1 + 63) / 64 * 64;
+    if (header_bytes_ - 10 > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument("trajectory record layout too large for a .npy header");
+    }
+    nan_metrics_.assign(metrics, std::numeric_limits<float>::quiet_NaN());
+
+    std::filesystem::create_directories(dir_);
+    if (std::filesystem::exists(std::filesystem::path(dir_) / kIndexFile)) {
+        throw std::runtime_error("trajectory dataset '" + dir_ + "' already exists");
+    }
+    write_index(false);
+    flusher_ = std::thread([this] { flush_loop(); });
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+uint64_t TrajectoryWriter::rows() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rows_;
+}
+
+void TrajectoryWriter::check_open() const {
+    if (flush_error_) std::rethrow_exception(flush_error_);
+    if (closed_) throw std::runtime_error("trajectory dataset '" + dir_ + "' is closed");
+}
+
+TrajectoryWriter::Shard& TrajectoryWriter::writable_shard() {
+    if (shards_.empty() || shards_.back()->rows == spec_.shard_rows) {
+        auto shard = std::make_unique<Shard>();
+        char name[32];
+        std::snprintf(name, sizeof(name), "shard_%06zu.npy", shards_.size());
+        shard->file = name;
+        shard->path = (std::filesystem::path(dir_) / name).string();
+        shard->fd = ::open(shard->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (shard->fd < 0) throw sys_error("open", shard->path);
+        // Reserve the address range for the whole shard now so rows never
+        // move; only the part backed by the file is touched.
+        shard->reserved = header_bytes_ + spec_.shard_rows * row_bytes_;
+        void* base = ::mmap(nullptr, shard->reserved, PROT_READ | PROT_WRITE, MAP_SHARED, shard->fd, 0);
+        if (base == MAP_FAILED) throw sys_error("mmap", shard->path);
+        shard->base = static_cast<uint8_t*>(base);
+        if (const int err = ::posix_fallocate(shard->fd, 0, static_cast<off_t>(header_bytes_)); err != 0) {
+            errno = err;
+            throw sys_error("allocate", shard->path);
+        }
+        const std::string header = npy_header(descr_, 0, header_bytes_);
+        std::memcpy(shard->base, header.data(), header.size());
+        shards_.push_back(std::move(shard));
+    }
+
+    Shard& shard = *shards_.back();
+    if (shard.rows == shard.capacity) {
+        const uint64_t capacity = std::min(shard.capacity + spec_.grow_rows, spec_.shard_rows);
+        // fallocate rather than ftruncate: a full disk fails here instead of
+        // raising SIGBUS on a later write through the mapping.
+        const int err = ::posix_fallocate(shard.fd, static_cast<off_t>(header_bytes_ + shard.capacity * row_bytes_),
+                                          static_cast<off_t>((capacity - shard.capacity) * row_bytes_));
+        if (err != 0) {
+            errno = err;
+            throw sys_error("allocate", shard.path);
+        }
+        shard.capacity = capacity;
+    }
+    return shard;
+}
+
+void TrajectoryWriter::append(const TrajectoryRow& row) {
+    if (row.obs.size() != static_cast<size_t>(spec_.obs_dim)) {
+        throw std::invalid_argument("trajectory row has " + std::to_string(row.obs.size()) +
+                                    " observations, expected " + std::to_string(spec_.obs_dim));
+    }
+    if (!row.metrics.empty() && row.metrics.size() != spec_.metrics.size()) {
+        throw std::invalid_argument("trajectory row has " + std::to_string(row.metrics.size()) +
+                                    " metrics, expected " + std::to_string(spec_.metrics.size()));
+    }
+    const auto action = action_values(row.action);
+    const std::span<const float> metrics = row.metrics.empty() ? std::span<const float>(nan_metrics_) : row.metrics;
+    const uint8_t flags[4] = {row.terminated ? uint8_t{1} : uint8_t{0}, row.truncated ? uint8_t{1} : uint8_t{0}, 0, 0};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    check_open();
+    Shard& shard = writable_shard();
+    uint8_t* p = shard.base + header_bytes_ + shard.rows * row_bytes_;
+    const auto put = [&p](const void* src, size_t n) {
+        std::memcpy(p, src, n);
+        p += n;
+    };
+    put(row.obs.data(), row.obs.size_bytes());
+    put(action.data(), sizeof(action));
+    put(metrics.data(), metrics.size_bytes());
+    put(&row.reward, sizeof(row.reward));
+    put(&row.seed, sizeof(row.seed));
+    put(&row.env, sizeof(row.env));
+    put(&row.step, sizeof(row.step));
+    put(flags, sizeof(flags));
+    shard.rows += 1;
+    rows_ += 1;
+}
+
+void TrajectoryWriter::append(uint64_t seed, uint32_t env, uint32_t step, std::span<const float> obs,
+                              const Action& action, const StepResult& result) {
+    thread_local std::vector<float> metrics;
+    metrics.clear();
+    for (const std::string& name : spec_.metrics) {
+        const auto it = result.info.scalars.find(name);
+        metrics.push_back(it == result.info.scalars.end() ? std::numeric_limits<float>::quiet_NaN() : it->second);
+    }
+    TrajectoryRow row;
+    row.seed = seed;
+    row.env = env;
+    row.step = step;
+    row.obs = obs;
+    row.action = action;
+    row.reward = result.reward;
+    row.terminated = result.terminated;
+    row.truncated = result.truncated;
+    row.metrics = metrics;
+    append(row);
+}
+
+void TrajectoryWriter::flush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        check_open();
+    }
+    sync(false);
+}
+
+void TrajectoryWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) return;
+        closed_ = true;
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (flusher_.joinable()) flusher_.join();
+    sync(true);
+    if (flush_error_) std::rethrow_exception(flush_error_);
+}
+
+void TrajectoryWriter::flush_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (wake_.wait_for(lock, spec_.flush_interval, [this] { return stop_; })) break;
+        lock.unlock();
+        try {
+            sync(false);
+        } catch (...) {
+            lock.lock();
+            flush_error_ = std::current_exception();
+            return;
+        }
+        lock.lock();
+    }
+}
+
+void TrajectoryWriter::sync(bool final) {
+    std::lock_guard<std::mutex> sync_lock(sync_mutex_);
+    std::vector<std::pair<Shard*, uint64_t>> mapped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_) {
+            if (shard->base != nullptr) mapped.emplace_back(shard.get(), shard->rows);
+        }
+    }
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    for (size_t i = 0; i < mapped.size(); ++i) {
+        auto [shard, rows] = mapped[i];
+        // Rows first, then the header that makes them visible.
+        if (rows > shard->published) {
+            const size_t begin = (header_bytes_ + shard->published * row_bytes_) / page * page;
+            const size_t end = header_bytes_ + rows * row_bytes_;
+            if (::msync(shard->base + begin, end - begin, MS_SYNC) != 0) throw sys_error("msync", shard->path);
+            const std::string header = npy_header(descr_, rows, header_bytes_);
+            std::memcpy(shard->base, header.data(), header.size());
+            if (::msync(shard->base, header_bytes_, MS_SYNC) != 0) throw sys_error("msync", shard->path);
+            shard->published = rows;
+        }
+        // Earlier shards are full and no longer written; the last one stays
+        // mapped until close().
+        if (final || i + 1 < mapped.size()) {
+            ::munmap(shard->base, shard->reserved);
+            shard->base = nullptr;
+            if (::ftruncate(shard->fd, static_cast<off_t>(header_bytes_ + rows * row_bytes_)) != 0) {
+                throw sys_error("truncate", shard->path);
+            }
+            ::close(shard->fd);
+            shard->fd = -1;
+        }
+    }
+    write_index(final);
+}
+
+void TrajectoryWriter::write_index(bool complete) const {
+    std::vector<std::pair<std::string, uint64_t>> shards;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_) shards.emplace_back(shard->file, shard->published);
+    }
+    uint64_t rows = 0;
+    for (const auto& shard : shards) rows += shard.second;
+
+    const std::filesystem::path path = std::filesystem::path(dir_) / kIndexFile;
+    const std::filesystem::path tmp = std::filesystem::path(dir_) / (std::string(kIndexFile) + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << "{\"format\":\"last_vector_trajectories\",\"version\":1,\"complete\":" << (complete ? "true" : "false")
+            << ",\"obs_dim\":" << spec_.obs_dim << ",\"action_dim\":" << kActionValues << ",\"metrics\":[";
+        for (size_t i = 0; i < spec_.metrics.size(); ++i) {
+            out << (i > 0 ? "," : "") << '"' << json_escape(spec_.metrics[i]) << '"';
+        }
+        out << "],\"row_bytes\":" << row_bytes_ << ",\"shard_rows\":" << spec_.shard_rows << ",\"rows\":" << rows
+            << ",\"shards\":[";
+        for (size_t i = 0; i < shards.size(); ++i) {
+            out << (i > 0 ? "," : "") << "{\"file\":\"" << shards[i].first << "\",\"rows\":" << shards[i].second
+                << '}';
+        }
+        out << "]}\n";
+        if (!out) throw std::runtime_error("failed to write '" + tmp.string() + "'");
+    }
+    // Readers see the old index or the new one, never half of it.
+    std::filesystem::rename(tmp, path);
+}
+
+} // namespace lv
@@ -25,4 +25,6 @@ void apply_upgrade(UpgradeState& state, UpgradeId id) {
     state.levels[idx] += 1;
 }
 
+float ring_of_fire_radius(int level) { return 70.0f + level * 16.0f; }
+
 } // namespace lv
@@ -0,0 +1,105 @@
+#include "lastvector/zombie_ray_grid.hpp"
+#include "lastvector/config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lv {
+
+namespace {
+// Zombie bounds are padded and the early-out keeps the same margin in ray
+// distance, which covers rounding in the DDA's accumulated cell crossings.
+constexpr float kGridPadding = 1.0f;
+
+} // namespace
+
+ZombieRayGrid::ZombieRayGrid(float cell_size) : cell_size_(cell_size), inv_cell_size_(1.0f / cell_size) {}
+
+void ZombieRayGrid::build(const std::vector<Zombie>& zombies, Vec2 arena_size) {
+    cols_ = std::max(1, static_cast<int>(std::ceil(arena_size.x * inv_cell_size_)));
+    rows_ = std::max(1, static_cast<int>(std::ceil(arena_size.y * inv_cell_size_)));
+    const size_t cells = static_cast<size_t>(cols_) * static_cast<size_t>(rows_);
+
+    // Positions are sanitized to [radius, size - radius], so the padded bounds
+    // stay above -1 cell and truncation matches floor after the clamp.
+    const float reach = kZombieRadius + kGridPadding;
+    const auto cell = [&](float v, int count) { return std::clamp(static_cast<int>(v * inv_cell_size_), 0, count - 1); };
+    const auto range = [&](Vec2 pos) {
+        return CellRange{cell(pos.x - reach, cols_), cell(pos.x + reach, cols_), cell(pos.y - reach, rows_),
+                         cell(pos.y + reach, rows_)};
+    };
+
+    cell_start_.assign(cells + 1, 0);
+    for (const auto& z : zombies) {
+        const CellRange r = range(z.pos);
+        for (int y = r.y0; y <= r.y1; ++y) {
+            for (int x = r.x0; x <= r.x1; ++x) ++cell_start_[static_cast<size_t>(y * cols_ + x) + 1];
+        }
+    }
+    for (size_t c = 0; c < cells; ++c) cell_start_[c + 1] += cell_start_[c];
+
+    cell_zombies_.resize(cell_start_.back());
+    fill_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    for (const auto& z : zombies) {
+        const CellRange r = range(z.pos);
+        for (int y = r.y0; y <= r.y1; ++y) {
+            for (int x = r.x0; x <= r.x1; ++x) cell_zombies_[fill_[static_cast<size_t>(y * cols_ + x)]++] = z.pos;
+        }
+    }
+}
+
+void ZombieRayGrid::cast(Vec2 origin, std::span<const Vec2> dirs, std::span<float> ray_t) const {
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        ray_t[i] = cast_one(origin, dirs[i], ray_t[i]);
+    }
+}
+
+float ZombieRayGrid::cast_one(Vec2 origin, Vec2 dir, float t_best) const {
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    const float c_radius = kZombieRadius * kZombieRadius;
+
+    int cx = std::clamp(static_cast<int>(std::floor(origin.x * inv_cell_size_)), 0, cols_ - 1);
+    int cy = std::clamp(static_cast<int>(std::floor(origin.y * inv_cell_size_)), 0, rows_ - 1);
+    const int step_x = dir.x > 0.0f ? 1 : -1;
+    const int step_y = dir.y > 0.0f ? 1 : -1;
+    const float t_delta_x = dir.x != 0.0f ? cell_size_ / std::abs(dir.x) : kInf;
+    const float t_delta_y = dir.y != 0.0f ? cell_size_ / std::abs(dir.y) : kInf;
+    float t_max_x = dir.x != 0.0f ? (static_cast<float>(cx + (step_x > 0 ? 1 : 0)) * cell_size_ - origin.x) / dir.x : kInf;
+    float t_max_y = dir.y != 0.0f ? (static_cast<float>(cy + (step_y > 0 ? 1 : 0)) * cell_size_ - origin.y) / dir.y : kInf;
+
+    while (true) {
+        const size_t cell = static_cast<size_t>(cy * cols_ + cx);
+        for (uint32_t k = cell_start_[cell]; k < cell_start_[cell + 1]; ++k) {
+            const Vec2 pos = cell_zombies_[k];
+            const float dx = pos.x - origin.x;
+            const float dy = pos.y - origin.y;
+            const float c = (dx * dx + dy * dy) - c_radius;
+            const float proj = dx * dir.x + dy * dir.y;
+            const float disc = proj * proj - c;
+            if (disc < 0.0f) continue;
+            const float sqrt_disc = std::sqrt(disc);
+            float t = proj - sqrt_disc;
+            if (t < 0.0f) {
+                t = proj + sqrt_disc;
+                if (t < 0.0f) continue;
+            }
+            t_best = std::min(t_best, t);
+        }
+
+        const float t_exit = std::min(t_max_x, t_max_y);
+        if (t_best + kGridPadding <= t_exit) break;
+        if (t_max_x < t_max_y) {
+            cx += step_x;
+            if (cx < 0 || cx >= cols_) break;
+            t_max_x += t_delta_x;
+        } else {
+            cy += step_y;
+            if (cy < 0 || cy >= rows_) break;
+            t_max_y += t_delta_y;
+        }
+    }
+    return t_best;
+}
+
+} // namespace lv
@@ -0,0 +1,106 @@
+// decode_action regression test: the boundary values every consumer (Python
+// env, native evaluation and rollouts, agent replies) must agree on.
+
+#include "lastvector/action.hpp"
+#include "lastvector/agent_protocol.hpp"
+#include "lastvector/rollout.hpp"
+#include "lastvector/sim.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    std::cout << what << ": FAILED\n";
+    ++failures;
+}
+
+std::array<float, lv::kActionValues> raw(float axis, float button, float choice) {
+    return {axis, -axis, axis, -axis, button, button, button, choice};
+}
+
+void check(const std::string& name, const std::array<float, lv::kActionValues>& values, float axis, bool pressed,
+           int choice) {
+    const lv::Action a = lv::decode_action(values);
+    expect(a.move_x == axis && a.move_y == -axis && a.aim_x == axis && a.aim_y == -axis, name + " axes");
+    expect(a.shoot == pressed && a.sprint == pressed && a.reload == pressed, name + " buttons");
+    expect(a.upgrade_choice == choice, name + " upgrade_choice " + std::to_string(a.upgrade_choice));
+
+    // Agent replies go through the same decoder.
+    std::vector<lv::Action> out;
+    lv::actions_from_agent_values(values, 1, out);
+    expect(out.size() == 1 && out[0].shoot == a.shoot && out[0].upgrade_choice == a.upgrade_choice &&
+               out[0].move_x == a.move_x,
+           name + " agent reply");
+}
+
+// Boundary values for step t: buttons exactly at 0.5 on even steps, upgrade
+// choices alternating between -0.5 and just below it.
+std::array<float, lv::kActionValues> boundary_action(size_t t) {
+    const float button = t % 2 == 0 ? 0.5f : std::nextafter(0.5f, 0.0f);
+    const float choice = t % 4 < 2 ? -0.5f : std::nextafter(-0.5f, -1.0f);
+    return {0.5f, -0.5f, 1.0f, 0.0f, button, button, t % 8 == 0 ? 0.5f : 0.0f, choice};
+}
+
+// RolloutCollector must step with decode_action, like the Python env.
+void check_rollout() {
+    lv::RolloutConfig config;
+    config.envs = 1;
+    config.steps = 400;
+    config.first_seed = 5;
+    lv::RolloutCollector collector(config);
+    collector.collect([](size_t t, std::span<const float>, std::span<float> actions) {
+        const auto values = boundary_action(t);
+        std::copy(values.begin(), values.end(), actions.begin());
+    });
+
+    lv::Simulator sim(config.sim);
+    sim.reset(config.first_seed);
+    const size_t dim = collector.obs_dim();
+    const auto obs = collector.observations();
+    for (size_t t = 0; t + 1 < collector.steps(); ++t) {
+        const lv::StepResult res = sim.step(lv::decode_action(boundary_action(t)));
+        if (res.terminated || res.truncated) break;
+        const auto next = obs.subspan((t + 1) * dim, dim);
+        if (!std::equal(res.observation.begin(), res.observation.end(), next.begin(), next.end())) {
+            expect(false, "rollout step " + std::to_string(t));
+            return;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    const float below_half = std::nextafter(0.5f, 0.0f);
+    const float below_minus_half = std::nextafter(-0.5f, -1.0f);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    check("buttons at 0.5", raw(0.0f, 0.5f, 0.0f), 0.0f, true, 0);
+    check("buttons just below 0.5", raw(0.0f, below_half, 0.0f), 0.0f, false, 0);
+    check("choice at -0.5", raw(0.0f, 0.0f, -0.5f), 0.0f, false, 0);
+    check("choice just below -0.5", raw(0.0f, 0.0f, below_minus_half), 0.0f, false, -1);
+    check("choice -1", raw(0.0f, 0.0f, -1.0f), 0.0f, false, -1);
+    check("choice 0.5", raw(0.0f, 0.0f, 0.5f), 0.0f, false, 1);
+    check("choice 1.5", raw(0.0f, 0.0f, 1.5f), 0.0f, false, 2);
+    check("choice 2.7", raw(0.0f, 0.0f, 2.7f), 0.0f, false, 2);
+    check("axes clamp high", raw(1.7f, 1.0f, 1.0f), 1.0f, true, 1);
+    check("axes clamp low", raw(-3.0f, 0.0f, 0.2f), -1.0f, false, 0);
+    check("axes in range", raw(0.25f, 0.0f, 0.0f), 0.25f, false, 0);
+    check("nan", raw(nan, nan, nan), 0.0f, false, -1);
+    check("inf", raw(inf, inf, inf), 0.0f, true, -1);
+    check_rollout();
+
+    std::cout << (failures == 0 ? "decode_action: ok\n" : "decode_action: FAILED\n");
+    return failures == 0 ? 0 : 1;
+}
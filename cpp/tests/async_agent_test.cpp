@@ -0,0 +1,117 @@
+// AsyncAgent regression test: destroying the agent while its server never
+// answers must not hang on the I/O thread blocked in the transport.
+
+#include "lastvector/agent_client.hpp"
+#include "lastvector/agent_protocol.hpp"
+#include "lastvector/async_agent.hpp"
+#include "lastvector/shm_mailbox.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    std::cout << what << ": " << (ok ? "ok" : "FAILED") << '\n';
+    if (!ok) ++failures;
+}
+
+// Unix socket server that answers the hello and then never replies.
+class MuteSocketServer {
+  public:
+    MuteSocketServer() : path_("/tmp/lv_async_agent_test_" + std::to_string(::getpid()) + ".sock") {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+        ::unlink(path_.c_str());
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd_, 1) != 0) {
+            throw std::runtime_error("unable to listen on " + path_ + ": " + std::strerror(errno));
+        }
+        accept_thread_ = std::thread([this] { accept_and_greet(); });
+    }
+
+    ~MuteSocketServer() {
+        if (accept_thread_.joinable()) accept_thread_.join();
+        if (conn_fd_ >= 0) ::close(conn_fd_);
+        ::close(listen_fd_);
+        ::unlink(path_.c_str());
+    }
+
+    const std::string& path() const { return path_; }
+
+  private:
+    void accept_and_greet() {
+        conn_fd_ = ::accept(listen_fd_, nullptr, nullptr);
+        if (conn_fd_ < 0) return;
+        char c = 0;
+        while (::recv(conn_fd_, &c, 1, 0) == 1 && c != '\n') {
+        }
+        const std::string hello = std::string("{\"type\":\"hello\",\"model\":\"mute\",\"protocol\":\"") +
+                                  lv::kAgentBinaryProtocolName + "\"}\n";
+        if (::send(conn_fd_, hello.data(), hello.size(), 0) < 0) return;
+    }
+
+    std::string path_;
+    int listen_fd_ = -1;
+    int conn_fd_ = -1;
+    std::thread accept_thread_;
+};
+
+// Plays ticks until the agent has missed three of them, then destroys it on a
+// helper thread and fails if that does not finish in time.
+void check_destroy_while_stalled(const std::string& name, std::unique_ptr<lv::AgentClient> client) {
+    auto agent = std::make_unique<lv::AsyncAgent>(std::move(client), std::chrono::milliseconds(1));
+    const lv::GameState state;
+    const std::vector<float> obs(16, 0.0f);
+    for (int i = 0; i < 3; ++i) agent->next_action_or_throw(state, [&] { return obs; });
+    expect(agent->missed() == 3, name + " missed=" + std::to_string(agent->missed()));
+
+    auto destroyed = std::async(std::launch::async, [&agent] { agent.reset(); });
+    if (destroyed.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+        std::cout << name << " destroy: FAILED (hung)" << std::endl;
+        std::_Exit(1);
+    }
+    expect(true, name + " destroy");
+}
+
+} // namespace
+
+int main() {
+    {
+        MuteSocketServer server;
+        lv::AgentEndpoint endpoint;
+        endpoint.transport = lv::AgentTransport::Unix;
+        endpoint.path = server.path();
+        auto client = lv::connect_agent(endpoint);
+        client->handshake_or_throw();
+        check_destroy_while_stalled("unix", std::move(client));
+    }
+    {
+        const std::string name = "lv_async_agent_test_" + std::to_string(::getpid());
+        lv::ShmMailbox server(name, lv::ShmMailboxRole::Server, "mute");
+        lv::AgentEndpoint endpoint;
+        endpoint.transport = lv::AgentTransport::Shm;
+        endpoint.path = name;
+        auto client = lv::connect_agent(endpoint);
+        client->handshake_or_throw();
+        check_destroy_while_stalled("shm", std::move(client));
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,476 @@
+// Golden-trajectory regression test: plays fixed seeds with scripted actions
+// and compares every step against cpp/tests/golden/<scenario>.golden.
+//
+// Each golden file records, per step, the tick, reward, terminated/truncated,
+// a hash of the observation bits, Simulator::state_hash() and an observation
+// digest (a weighted sum per block of kDigestBlock values), plus the whole
+// observation and a save_state() keyframe every kKeyframeEvery steps. By
+// default everything must match bit for bit and the first difference fails.
+// --tolerance EPS is for builds that are not expected to be bit-exact
+// (fast-math, other compilers): hashes are skipped, rewards and recorded
+// observations may differ by EPS * max(1, |golden|), every step's digest by
+// what those per-value differences can add up to, and the simulator is
+// reloaded from each golden keyframe so rounding differences cannot grow into
+// a different trajectory. Each keyframe window is then checked on its own;
+// --max-diverged N lets up to N of them differ, since a last-bit difference
+// can still decide a threshold (a hit, a timer running out) within a window.
+// --update rewrites the files after an intended behaviour change.
+
+#include "lastvector/action.hpp"
+#include "lastvector/config.hpp"
+#include "lastvector/env_api.hpp"
+#include "lastvector/sim.hpp"
+#include "lastvector/state.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kGoldenVersion = 2;
+constexpr int kKeyframeEvery = 100;
+constexpr size_t kDigestBlock = 16;
+
+using Script = lv::Action (*)(const lv::GameState&, int step);
+
+struct Scenario {
+    const char* name;
+    uint64_t seed;
+    int steps;
+    lv::SimConfig config;
+    Script script;
+};
+
+// Orbits the arena centre, aims at the nearest zombie and fires at it, sprints
+// in bursts, reloads on an empty magazine and always picks an upgrade.
+lv::Action hunter(const lv::GameState& s, int step) {
+    const lv::Vec2 p = s.player.pos;
+    lv::Action a;
+    float best = 1e30f;
+    lv::Vec2 nearest{};
+    for (const lv::Zombie& z : s.zombies) {
+        const float dx = z.pos.x - p.x;
+        const float dy = z.pos.y - p.y;
+        const float d2 = dx * dx + dy * dy;
+        if (d2 < best) {
+            best = d2;
+            nearest = {dx, dy};
+        }
+    }
+    const float cx = p.x - s.arena_size.x * 0.5f;
+    const float cy = p.y - s.arena_size.y * 0.5f;
+    const float r = std::max(std::sqrt(cx * cx + cy * cy), 1.0f);
+    const float pull = (r - 500.0f) / 500.0f; // towards a 500-unit circle
+    a.move_x = -cy / r - pull * cx / r;
+    a.move_y = cx / r - pull * cy / r;
+    if (!s.zombies.empty()) {
+        a.aim_x = nearest.x;
+        a.aim_y = nearest.y;
+        a.shoot = true;
+        if (best < 120.0f * 120.0f) {
+            const float d = std::sqrt(best);
+            a.move_x -= nearest.x / d;
+            a.move_y -= nearest.y / d;
+        }
+    }
+    a.sprint = (step / 90) % 3 == 0;
+    a.reload = s.player.mag == 0;
+    a.upgrade_choice = step % 3;
+    return a;
+}
+
+// Walks a fixed sequence of headings, sweeps its aim around and fires in
+// bursts. Never picks an upgrade, so offers run into the timeout.
+lv::Action wanderer(const lv::GameState&, int step) {
+    constexpr float kHeadings[8][2] = {{1, 0}, {0.6f, 0.8f}, {0, 1}, {-0.8f, 0.6f},
+                                       {-1, 0}, {-0.6f, -0.8f}, {0, -1}, {0.8f, -0.6f}};
+    const auto* h = kHeadings[(step / 150) % 8];
+    lv::Action a;
+    a.move_x = h[0];
+    a.move_y = h[1];
+    a.aim_x = std::cos(static_cast<float>(step) * 0.05f);
+    a.aim_y = std::sin(static_cast<float>(step) * 0.05f);
+    a.shoot = (step / 20) % 2 == 0;
+    a.sprint = (step / 300) % 2 == 1;
+    return a;
+}
+
+std::vector<Scenario> scenarios() {
+    lv::SimConfig crowd;
+    crowd.spawn_rate_base = 8.0f;
+    crowd.max_alive_base = 150;
+    crowd.separation_solver = lv::SeparationSolver::Jacobi;
+    crowd.separation_threads = 2;
+    crowd.zombie_obs_count = 16;
+    crowd.ray_count = 32;
+
+    lv::SimConfig brute;
+    brute.neighbor_search = lv::NeighborSearch::BruteForce;
+    brute.zombie_ray_search = lv::ZombieRaySearch::BruteForce;
+    brute.obstacle_field_cell_size = 0.0f;
+    brute.spawn_rate_base = 3.0f;
+    brute.episode_limit_seconds = 20.0f; // several episodes in one run
+
+    return {
+        {"hunter", 7, 4000, lv::SimConfig{}, hunter},
+        {"crowd_jacobi", 11, 3000, crowd, hunter},
+        {"wanderer_brute_force", 23, 3000, brute, wanderer},
+    };
+}
+
+struct StepRecord {
+    uint64_t tick = 0;
+    float reward = 0.0f;
+    bool terminated = false;
+    bool truncated = false;
+    uint64_t obs_hash = 0;
+    uint64_t state_hash = 0;
+    std::vector<float> obs_digest; // one per kDigestBlock observation values
+    // sum |weight| * max(1, |value|) per block, the scale a digest may drift by
+    // in tolerance mode; only set by play().
+    std::vector<float> digest_scale;
+};
+
+struct Trajectory {
+    int obs_dim = 0;
+    std::vector<StepRecord> steps;
+    // For steps 0, kKeyframeEvery, 2 * kKeyframeEvery, ...: the state before
+    // the step and the observation after it.
+    std::vector<std::vector<uint8_t>> keyframes;
+    std::vector<std::vector<float>> observations;
+};
+
+// FNV-1a over the float bit patterns.
+uint64_t hash_floats(std::span<const float> values) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const float v : values) {
+        uint32_t bits = std::bit_cast<uint32_t>(v);
+        for (int i = 0; i < 4; ++i, bits >>= 8) h = (h ^ (bits & 0xffU)) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Weight of the k-th value of a digest block: distinct magnitudes and
+// alternating signs, so swapped or offsetting values still move the sum.
+double digest_weight(size_t k) {
+    const double w = 1.0 + static_cast<double>(k % kDigestBlock) / kDigestBlock;
+    return k % 2 == 0 ? w : -w;
+}
+
+void digest_observation(std::span<const float> obs, StepRecord& r) {
+    const size_t blocks = (obs.size() + kDigestBlock - 1) / kDigestBlock;
+    r.obs_digest.assign(blocks, 0.0f);
+    r.digest_scale.assign(blocks, 0.0f);
+    for (size_t b = 0; b < blocks; ++b) {
+        double sum = 0.0;
+        double scale = 0.0;
+        for (size_t k = b * kDigestBlock; k < std::min(obs.size(), (b + 1) * kDigestBlock); ++k) {
+            const double w = digest_weight(k);
+            sum += w * obs[k];
+            scale += std::fabs(w) * std::max(1.0, std::fabs(static_cast<double>(obs[k])));
+        }
+        r.obs_digest[b] = static_cast<float>(sum);
+        r.digest_scale[b] = static_cast<float>(scale);
+    }
+}
+
+// Episodes that end are reset to the next seed; steps keep counting. With
+// `resync`, each keyframe step starts from that trajectory's keyframe.
+Trajectory play(const Scenario& scenario, const Trajectory* resync) {
+    lv::Simulator sim(scenario.config);
+    sim.reset(scenario.seed);
+    Trajectory out;
+    out.obs_dim = sim.observation_dim();
+    for (int step = 0; step < scenario.steps; ++step) {
+        if (step % kKeyframeEvery == 0) {
+            const auto k = static_cast<size_t>(step / kKeyframeEvery);
+            if (resync != nullptr && k < resync->keyframes.size()) sim.load_state(resync->keyframes[k]);
+            sim.save_state(out.keyframes.emplace_back());
+        }
+        const lv::StepResult result = sim.step(scenario.script(sim.state(), step));
+        out.steps.push_back({sim.state().tick, result.reward, result.terminated, result.truncated,
+                             hash_floats(result.observation), sim.state_hash(), {}, {}});
+        digest_observation(result.observation, out.steps.back());
+        if (step % kKeyframeEvery == 0) out.observations.push_back(result.observation);
+        if (result.terminated || result.truncated) sim.reset(sim.state().seed + 1);
+    }
+    return out;
+}
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+std::string format_float(float v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(v));
+    return buf;
+}
+
+void write_golden(const std::filesystem::path& path, const Scenario& scenario, const Trajectory& t) {
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error("cannot write " + path.string());
+    file << "last_vector_golden " << kGoldenVersion << '\n'
+         << "scenario " << scenario.name << '\n'
+         << "steps " << t.steps.size() << '\n'
+         << "obs_dim " << t.obs_dim << '\n'
+         << "# t step tick reward terminated truncated obs_hash state_hash obs_digest...\n"
+         << "# k step save_state bytes (hex)\n"
+         << "# o step observation...\n";
+    char hashes[40];
+    for (size_t i = 0; i < t.steps.size(); ++i) {
+        const StepRecord& r = t.steps[i];
+        std::snprintf(hashes, sizeof(hashes), "%016" PRIx64 " %016" PRIx64, r.obs_hash, r.state_hash);
+        file << "t " << i << ' ' << r.tick << ' ' << format_float(r.reward) << ' ' << r.terminated << ' '
+             << r.truncated << ' ' << hashes;
+        for (const float d : r.obs_digest) file << ' ' << format_float(d);
+        file << '\n';
+        if (i % kKeyframeEvery == 0) {
+            file << "k " << i << ' ';
+            for (const uint8_t b : t.keyframes[i / kKeyframeEvery]) file << kHexDigits[b >> 4] << kHexDigits[b & 15];
+            file << "\no " << i;
+            for (const float v : t.observations[i / kKeyframeEvery]) file << ' ' << format_float(v);
+            file << '\n';
+        }
+    }
+    if (!file.flush()) throw std::runtime_error("write failed: " + path.string());
+}
+
+std::optional<std::vector<uint8_t>> decode_hex(const std::string& hex) {
+    const auto digit = [](char c) { return c >= 'a' ? c - 'a' + 10 : c - '0'; };
+    if (hex.size() % 2 != 0 || hex.find_first_not_of(kHexDigits) != std::string::npos) return std::nullopt;
+    std::vector<uint8_t> bytes(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(digit(hex[2 * i]) * 16 + digit(hex[2 * i + 1]));
+    }
+    return bytes;
+}
+
+Trajectory read_golden(const std::filesystem::path& path, const Scenario& scenario) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("missing " + path.string() + " (run with --update to create it)");
+    const auto fail = [&](size_t line, const std::string& why) {
+        return std::runtime_error(path.string() + ":" + std::to_string(line) + ": " + why);
+    };
+
+    Trajectory t;
+    std::string line;
+    size_t line_no = 0;
+    size_t steps = 0;
+    while (std::getline(file, line)) {
+        ++line_no;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+        if (key == "last_vector_golden") {
+            int version = 0;
+            in >> version;
+            if (version != kGoldenVersion) throw fail(line_no, "unsupported version " + std::to_string(version));
+        } else if (key == "scenario") {
+            std::string name;
+            in >> name;
+            if (name != scenario.name) throw fail(line_no, "scenario '" + name + "', expected " + scenario.name);
+        } else if (key == "steps") {
+            in >> steps;
+        } else if (key == "obs_dim") {
+            in >> t.obs_dim;
+        } else if (key == "t") {
+            size_t step = 0;
+            StepRecord r;
+            std::string reward;
+            in >> step >> r.tick >> reward >> r.terminated >> r.truncated >> std::hex >> r.obs_hash >> r.state_hash;
+            const bool fields_ok = static_cast<bool>(in);
+            std::string v;
+            while (in >> v) r.obs_digest.push_back(std::stof(v));
+            const size_t blocks = (static_cast<size_t>(t.obs_dim) + kDigestBlock - 1) / kDigestBlock;
+            if (!fields_ok || step != t.steps.size() || r.obs_digest.size() != blocks) {
+                throw fail(line_no, "bad step record");
+            }
+            r.reward = std::stof(reward);
+            t.steps.push_back(r);
+        } else if (key == "k") {
+            size_t step = 0;
+            std::string hex;
+            in >> step >> hex;
+            auto bytes = decode_hex(hex);
+            if (step != t.keyframes.size() * kKeyframeEvery || !bytes.has_value()) throw fail(line_no, "bad keyframe");
+            t.keyframes.push_back(std::move(*bytes));
+        } else if (key == "o") {
+            size_t step = 0;
+            in >> step;
+            std::vector<float> obs;
+            std::string v;
+            while (in >> v) obs.push_back(std::stof(v));
+            if (step != t.observations.size() * kKeyframeEvery || obs.size() != static_cast<size_t>(t.obs_dim)) {
+                throw fail(line_no, "bad observation record");
+            }
+            t.observations.push_back(std::move(obs));
+        } else {
+            throw fail(line_no, "unknown record '" + key + "'");
+        }
+    }
+    if (t.steps.size() != steps) throw fail(line_no, "truncated: expected " + std::to_string(steps) + " steps");
+    return t;
+}
+
+bool close_enough(float actual, float golden, std::optional<float> tolerance) {
+    if (!tolerance.has_value()) return std::bit_cast<uint32_t>(actual) == std::bit_cast<uint32_t>(golden);
+    return std::fabs(actual - golden) <= *tolerance * std::max(1.0f, std::fabs(golden));
+}
+
+// The first difference within one keyframe window, or nothing.
+std::optional<std::string> compare_window(const Trajectory& actual, const Trajectory& golden, size_t window,
+                                          std::optional<float> tolerance) {
+    const bool exact = !tolerance.has_value();
+    const size_t begin = window * kKeyframeEvery;
+    const size_t end = std::min(begin + kKeyframeEvery, golden.steps.size());
+    for (size_t i = begin; i < end; ++i) {
+        const StepRecord& a = actual.steps[i];
+        const StepRecord& g = golden.steps[i];
+        const auto at = [&] { return "step " + std::to_string(i) + " (tick " + std::to_string(g.tick) + "): "; };
+        if (a.tick != g.tick) return at() + "tick " + std::to_string(a.tick);
+        if (a.terminated != g.terminated || a.truncated != g.truncated) return at() + "episode end differs";
+        if (!close_enough(a.reward, g.reward, tolerance)) {
+            return at() + "reward " + format_float(a.reward) + ", golden " + format_float(g.reward);
+        }
+        if (exact && a.state_hash != g.state_hash) return at() + "state hash differs";
+        if (!exact) {
+            // Values within EPS * max(1, |golden|) move a block's sum by at most
+            // EPS / (1 - EPS) of its scale; the float rounding of both sums
+            // gets an epsilon of its own.
+            const float slack = *tolerance / (1.0f - *tolerance) + 2.0f * std::numeric_limits<float>::epsilon();
+            for (size_t b = 0; b < g.obs_digest.size(); ++b) {
+                if (std::fabs(a.obs_digest[b] - g.obs_digest[b]) > slack * a.digest_scale[b]) {
+                    return at() + "observation digest[" + std::to_string(b) + "] " + format_float(a.obs_digest[b]) +
+                           ", golden " + format_float(g.obs_digest[b]);
+                }
+            }
+        }
+        if (i == begin) {
+            const auto& ao = actual.observations[window];
+            const auto& go = golden.observations[window];
+            for (size_t k = 0; k < go.size(); ++k) {
+                if (!close_enough(ao[k], go[k], tolerance)) {
+                    return at() + "observation[" + std::to_string(k) + "] " + format_float(ao[k]) + ", golden " +
+                           format_float(go[k]);
+                }
+            }
+        }
+        if (exact && a.obs_hash != g.obs_hash) return at() + "observation hash differs";
+    }
+    return std::nullopt;
+}
+
+// Differences between a run and its golden file: the first one when exact,
+// else the first of every diverged window.
+std::vector<std::string> compare(const Trajectory& actual, const Trajectory& golden, std::optional<float> tolerance) {
+    if (actual.obs_dim != golden.obs_dim) {
+        return {"obs_dim " + std::to_string(actual.obs_dim) + ", golden " + std::to_string(golden.obs_dim)};
+    }
+    if (actual.steps.size() != golden.steps.size()) {
+        return {std::to_string(actual.steps.size()) + " steps, golden " + std::to_string(golden.steps.size())};
+    }
+    std::vector<std::string> diffs;
+    for (size_t w = 0; w < golden.observations.size(); ++w) {
+        if (auto diff = compare_window(actual, golden, w, tolerance)) {
+            diffs.push_back(std::move(*diff));
+            if (!tolerance.has_value()) break;
+        }
+    }
+    return diffs;
+}
+
+void print_usage() {
+    std::cout << "Usage: last_vector_golden [--dir DIR] [--filter NAME] [--tolerance EPS [--max-diverged N]]\n"
+                 "                          [--update]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path dir = "cpp/tests/golden";
+    std::string filter;
+    std::optional<float> tolerance;
+    size_t max_diverged = 0;
+    bool update = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--dir" && i + 1 < argc) {
+                dir = argv[++i];
+            } else if (arg == "--filter" && i + 1 < argc) {
+                filter = argv[++i];
+            } else if (arg == "--tolerance" && i + 1 < argc) {
+                tolerance = std::stof(argv[++i]);
+            } else if (arg == "--max-diverged" && i + 1 < argc) {
+                max_diverged = std::stoul(argv[++i]);
+            } else if (arg == "--update") {
+                update = true;
+            } else if (arg == "--help" || arg == "-h") {
+                print_usage();
+                return 0;
+            } else {
+                std::cerr << "Unknown or incomplete argument: " << arg << '\n';
+                print_usage();
+                return 2;
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Failed to parse CLI arguments: " << ex.what() << '\n';
+        return 2;
+    }
+    if (tolerance.has_value() && !(*tolerance >= 0.0f && *tolerance < 1.0f)) {
+        std::cerr << "--tolerance must be in [0, 1)\n";
+        return 2;
+    }
+    if (max_diverged > 0 && !tolerance.has_value()) {
+        std::cerr << "--max-diverged needs --tolerance\n";
+        return 2;
+    }
+
+    int failures = 0;
+    for (const Scenario& scenario : scenarios()) {
+        if (!filter.empty() && filter != scenario.name) continue;
+        const auto path = dir / (std::string(scenario.name) + ".golden");
+        try {
+            if (update) {
+                std::filesystem::create_directories(dir);
+                write_golden(path, scenario, play(scenario, nullptr));
+                std::cout << scenario.name << ": wrote " << path.string() << '\n';
+                continue;
+            }
+            const Trajectory golden = read_golden(path, scenario);
+            const Trajectory actual = play(scenario, tolerance.has_value() ? &golden : nullptr);
+            const auto diffs = compare(actual, golden, tolerance);
+            for (const auto& diff : diffs) std::cout << scenario.name << ": differs at " << diff << '\n';
+            if (diffs.size() > max_diverged) {
+                std::cout << scenario.name << ": FAILED\n";
+                ++failures;
+            } else {
+                std::cout << scenario.name << ": ok (" << actual.steps.size() << " steps";
+                if (!diffs.empty()) {
+                    std::cout << ", " << diffs.size() << " of " << golden.observations.size() << " windows diverged";
+                }
+                std::cout << ")\n";
+            }
+        } catch (const std::exception& ex) {
+            std::cout << scenario.name << ": ERROR " << ex.what() << '\n';
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
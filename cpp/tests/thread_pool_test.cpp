@@ -0,0 +1,82 @@
+// ThreadPool regression test: loops with fewer items than threads must still
+// spread over several threads instead of running inline on the caller.
+
+#include "lastvector/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Each item waits (up to a deadline) until `want` items are running at once,
+// so the check does not depend on how fast the workers wake up.
+class Rendezvous {
+  public:
+    explicit Rendezvous(int want) : want_(want) {}
+
+    void arrive() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.insert(std::this_thread::get_id());
+        }
+        running_.fetch_add(1);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (running_.load() < want_ && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+    }
+
+    size_t threads() const { return threads_.size(); }
+
+  private:
+    int want_;
+    std::atomic<int> running_{0};
+    std::mutex mutex_;
+    std::set<std::thread::id> threads_;
+};
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    std::cout << what << ": " << (ok ? "ok" : "FAILED") << '\n';
+    if (!ok) ++failures;
+}
+
+void check_parallel_for(lv::ThreadPool& pool, size_t count) {
+    Rendezvous rendezvous(static_cast<int>(count));
+    std::vector<int> seen(count, 0);
+    pool.parallel_for(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) seen[i] += 1;
+        rendezvous.arrive();
+    });
+    const bool all_once = std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; });
+    expect(all_once && rendezvous.threads() == count,
+           "parallel_for count=" + std::to_string(count) + " threads=" + std::to_string(rendezvous.threads()));
+}
+
+void check_parallel_for_each(lv::ThreadPool& pool, size_t count) {
+    Rendezvous rendezvous(2);
+    std::vector<int> seen(count, 0);
+    pool.parallel_for_each(count, [&](size_t i, int) {
+        seen[i] += 1;
+        rendezvous.arrive();
+    });
+    const bool all_once = std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; });
+    expect(all_once && rendezvous.threads() > 1,
+           "parallel_for_each count=" + std::to_string(count) + " threads=" + std::to_string(rendezvous.threads()));
+}
+
+} // namespace
+
+int main() {
+    lv::ThreadPool pool(8);
+    for (const size_t count : {2, 3, 7, 8}) check_parallel_for(pool, count);
+    for (const size_t count : {2, 3, 7, 8, 20}) check_parallel_for_each(pool, count);
+    return failures == 0 ? 0 : 1;
+}
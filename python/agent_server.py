@@ -1,9 +1,15 @@
 from __future__ import annotations
 
 import argparse
+import ctypes
 import json
+import mmap
 import os
+import platform
+import selectors
 import socket
+import struct
+import time
 from pathlib import Path
 from typing import Any
 
@@ -12,12 +18,64 @@ from stable_baselines3 import PPO
 
 import last_vector_core
 
+# Binary framing negotiated in the hello (see cpp/include/lastvector/agent_protocol.hpp):
+# u32 length, u8 version, u8 kind, u16 count, then count little-endian float32.
+BINARY_PROTOCOL = "binary-v1"
+PROTOCOL_VERSION = 1
+FRAME_OBSERVATION = 1
+FRAME_ACTION = 2
+FRAME_HEADER = struct.Struct("<IBBH")
+MAX_MESSAGE_BYTES = 1 << 20
+MAX_ACTION_CHUNK = 64
+
+# Shared-memory mailbox layout (see cpp/src/shm_mailbox.cpp): a 256-byte header,
+# then one request slot and one response slot of SHM_SLOT_CAPACITY bytes each.
+SHM_MAGIC = 0x4D53564C
+SHM_VERSION = 1
+SHM_SLOT_CAPACITY = FRAME_HEADER.size + 65535 * 4
+SHM_HEADER_BYTES = 256
+SHM_MODEL_BYTES = 48
+SHM_REQUEST_SEQ = 64
+SHM_RESPONSE_SEQ = 128
+SHM_SPIN_SECONDS = 0.0005
+SYS_FUTEX = {"x86_64": 202, "aarch64": 98}.get(platform.machine())
+FUTEX_WAIT = 0
+FUTEX_WAKE = 1
+
 
 def parse_args() -> argparse.Namespace:
-    parser = argparse.ArgumentParser(description="Serve PPO inference actions over TCP.")
+    parser = argparse.ArgumentParser(
+        description="Serve batched PPO inference actions over TCP, a Unix socket or shared memory."
+    )
     parser.add_argument("--model", required=True, help="Path to SB3 PPO model .zip")
     parser.add_argument("--host", default="127.0.0.1", help="Listen host")
     parser.add_argument("--port", type=int, default=5555, help="Listen port")
+    parser.add_argument(
+        "--max-batch",
+        type=int,
+        default=64,
+        help="Largest number of observations evaluated in one forward pass",
+    )
+    parser.add_argument(
+        "--batch-window-ms",
+        type=float,
+        default=2.0,
+        help="How long the first pending observation may wait for others to join its batch",
+    )
+    parser.add_argument(
+        "--chunk",
+        type=int,
+        default=1,
+        help="Reply with this many ticks of the predicted action (capped by the client's max_chunk)",
+    )
+    transport = parser.add_mutually_exclusive_group()
+    transport.add_argument("--unix", metavar="PATH", help="Listen on a Unix-domain socket instead of TCP")
+    transport.add_argument("--shm", metavar="NAME", help="Serve through the shared-memory mailbox /dev/shm/NAME")
+    parser.add_argument(
+        "--json-only",
+        action="store_true",
+        help="Refuse binary frames and keep newline-delimited JSON for every client",
+    )
     return parser.parse_args()
 
 
@@ -25,22 +83,40 @@ def json_dumps_line(payload: dict[str, Any]) -> bytes:
     return (json.dumps(payload, separators=(",", ":")) + "\n").encode("utf-8")
 
 
-def recv_json_line(conn: socket.socket, recv_buffer: bytearray) -> dict[str, Any] | None:
+def pop_json_line(buffer: bytearray) -> dict[str, Any] | None:
     while True:
-        newline_index = recv_buffer.find(b"\n")
-        if newline_index != -1:
-            raw = bytes(recv_buffer[:newline_index])
-            del recv_buffer[: newline_index + 1]
-            if not raw.strip():
-                continue
+        newline_index = buffer.find(b"\n")
+        if newline_index == -1:
+            if len(buffer) > MAX_MESSAGE_BYTES:
+                raise ValueError("incoming message too large")
+            return None
+        raw = bytes(buffer[:newline_index])
+        del buffer[: newline_index + 1]
+        if raw.strip():
             return json.loads(raw.decode("utf-8"))
 
-        chunk = conn.recv(8192)
-        if not chunk:
-            return None
-        recv_buffer.extend(chunk)
-        if len(recv_buffer) > (1 << 20):
-            raise ValueError("incoming message too large")
+
+def pop_obs_frame(buffer: bytearray) -> np.ndarray | None:
+    if len(buffer) < FRAME_HEADER.size:
+        return None
+    length, version, kind, count = FRAME_HEADER.unpack_from(buffer)
+    if version != PROTOCOL_VERSION:
+        raise ValueError(f"unsupported frame version {version}")
+    if kind != FRAME_OBSERVATION:
+        raise ValueError(f"expected observation frame, got kind {kind}")
+    if length != 4 + 4 * count or length > MAX_MESSAGE_BYTES:
+        raise ValueError(f"frame length {length} does not match {count} values")
+    end = 4 + length
+    if len(buffer) < end:
+        return None
+    obs = np.frombuffer(bytes(buffer[FRAME_HEADER.size : end]), dtype="<f4").astype(np.float32)
+    del buffer[:end]
+    return obs
+
+
+def encode_action_frame(action: list[float]) -> bytes:
+    values = np.asarray(action, dtype="<f4")
+    return FRAME_HEADER.pack(4 + 4 * values.size, PROTOCOL_VERSION, FRAME_ACTION, values.size) + values.tobytes()
 
 
 def clamp_and_validate_action(action: np.ndarray) -> list[float]:
@@ -58,40 +134,295 @@ def clamp_and_validate_action(action: np.ndarray) -> list[float]:
     return [float(x) for x in arr.tolist()]
 
 
+def repeat_action(action: list[float], count: int) -> list[float]:
+    """Action chunk holding `action` for `count` ticks; the upgrade pick is only sent once."""
+    repeat = action[:7] + [-1.0]
+    return action + repeat * (count - 1)
+
+
 def resolve_model_name(model_path: Path) -> str:
     return model_path.name
 
 
-def handle_client(conn: socket.socket, model: PPO, model_name: str) -> None:
-    recv_buffer = bytearray()
+class ClientSession:
+    """One connected last_vector instance: its receive buffer and negotiated protocol."""
 
-    hello = recv_json_line(conn, recv_buffer)
-    if hello is None:
-        return
-    if hello.get("type") != "hello":
-        raise ValueError("client did not send hello")
+    def __init__(self, conn: socket.socket, name: str) -> None:
+        self.conn = conn
+        self.name = name
+        self.buffer = bytearray()
+        self.protocol: str | None = None  # None until the hello arrives
+        self.max_chunk = 1
 
-    conn.sendall(json_dumps_line({"type": "hello", "model": model_name}))
+    def feed(self, data: bytes, model_name: str, allow_binary: bool) -> list[np.ndarray]:
+        """Buffers received bytes and returns the observations they completed."""
+        self.buffer.extend(data)
+        if self.protocol is None:
+            hello = pop_json_line(self.buffer)
+            if hello is None:
+                return []
+            if hello.get("type") != "hello":
+                raise ValueError("client did not send hello")
+            # Clients that list no protocols (older builds) keep JSON.
+            offered = hello.get("protocols", [])
+            binary = allow_binary and isinstance(offered, list) and BINARY_PROTOCOL in offered
+            self.protocol = BINARY_PROTOCOL if binary else "json"
+            max_chunk = hello.get("max_chunk", 1)
+            if isinstance(max_chunk, int) and not isinstance(max_chunk, bool):
+                self.max_chunk = min(max(max_chunk, 1), MAX_ACTION_CHUNK)
+            self.conn.sendall(json_dumps_line({"type": "hello", "model": model_name, "protocol": self.protocol}))
+            print(f"client protocol: {self.name} {self.protocol} max_chunk={self.max_chunk}", flush=True)
 
-    while True:
-        message = recv_json_line(conn, recv_buffer)
-        if message is None:
+        requests = []
+        while True:
+            if self.protocol == BINARY_PROTOCOL:
+                obs_arr = pop_obs_frame(self.buffer)
+            else:
+                message = pop_json_line(self.buffer)
+                if message is None:
+                    break
+                obs = message.get("obs")
+                if not isinstance(obs, list):
+                    raise ValueError("request missing obs list")
+                obs_arr = np.asarray(obs, dtype=np.float32)
+            if obs_arr is None:
+                break
+            requests.append(obs_arr)
+        return requests
+
+    def send_action(self, action: list[float]) -> None:
+        """Sends 8 * n values: n consecutive actions."""
+        if self.protocol == BINARY_PROTOCOL:
+            self.conn.sendall(encode_action_frame(action))
+        else:
+            self.conn.sendall(json_dumps_line({"action": action}))
+
+
+class BatchingServer:
+    """Serves any number of clients from one model. Observations that arrive
+    within `window` seconds of the oldest pending one share a forward pass; the
+    batch goes early once it is full or every connected client is waiting."""
+
+    def __init__(
+        self,
+        server: socket.socket,
+        model: PPO,
+        model_name: str,
+        allow_binary: bool,
+        max_batch: int,
+        window: float,
+        chunk: int,
+    ) -> None:
+        self.server = server
+        self.model = model
+        self.model_name = model_name
+        self.allow_binary = allow_binary
+        self.max_batch = max_batch
+        self.window = window
+        self.chunk = chunk
+        self.selector = selectors.DefaultSelector()
+        self.selector.register(server, selectors.EVENT_READ, None)
+        self.sessions: set[ClientSession] = set()
+        self.pending: list[tuple[ClientSession, np.ndarray]] = []
+        self.oldest = 0.0
+        self.batches = 0
+        self.requests = 0
+
+    def serve_forever(self) -> None:
+        while True:
+            timeout = None
+            if self.pending:
+                timeout = max(0.0, self.oldest + self.window - time.perf_counter())
+            for key, _ in self.selector.select(timeout):
+                if key.data is None:
+                    self._accept()
+                else:
+                    self._read(key.data)
+            if self.pending and (self._batch_ready() or time.perf_counter() >= self.oldest + self.window):
+                self._flush()
+
+    def _accept(self) -> None:
+        conn, addr = self.server.accept()
+        if conn.family == socket.AF_UNIX:
+            name = f"#{conn.fileno()}"
+        else:
+            name = f"{addr[0]}:{addr[1]}"
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        session = ClientSession(conn, name)
+        self.sessions.add(session)
+        self.selector.register(conn, selectors.EVENT_READ, session)
+        print(f"client connected: {name} ({len(self.sessions)} active)", flush=True)
+
+    def _read(self, session: ClientSession) -> None:
+        try:
+            data = session.conn.recv(65536)
+            if not data:
+                self._drop(session, "client disconnected")
+                return
+            requests = session.feed(data, self.model_name, self.allow_binary)
+        except (json.JSONDecodeError, ValueError) as exc:
+            self._drop(session, f"client protocol error: {exc}")
+            return
+        except (ConnectionError, OSError) as exc:
+            self._drop(session, f"client socket error: {exc}")
+            return
+        if requests and not self.pending:
+            self.oldest = time.perf_counter()
+        self.pending.extend((session, obs) for obs in requests)
+
+    def _batch_ready(self) -> bool:
+        if len(self.pending) >= self.max_batch:
+            return True
+        # last_vector sends one observation and blocks on the reply, so once
+        # every client has one pending nothing else can join this batch.
+        waiting = {session for session, _ in self.pending}
+        return len(waiting) >= len(self.sessions)
+
+    def _flush(self) -> None:
+        batch = self.pending[: self.max_batch]
+        del self.pending[: self.max_batch]
+        if self.pending:
+            self.oldest = time.perf_counter()
+
+        # Clients may run different observation layouts; each shape gets its own pass.
+        by_shape: dict[tuple[int, ...], list[int]] = {}
+        for index, (_, obs) in enumerate(batch):
+            by_shape.setdefault(obs.shape, []).append(index)
+        for indices in by_shape.values():
+            obs_batch = np.stack([batch[i][1] for i in indices])
+            actions, _ = self.model.predict(obs_batch, deterministic=True)
+            actions = np.asarray(actions).reshape(len(indices), -1)
+            for i, action in zip(indices, actions):
+                session = batch[i][0]
+                if session not in self.sessions:
+                    continue
+                try:
+                    count = min(self.chunk, session.max_chunk)
+                    session.send_action(repeat_action(clamp_and_validate_action(action), count))
+                except (ConnectionError, OSError) as exc:
+                    self._drop(session, f"client socket error: {exc}")
+        self.batches += 1
+        self.requests += len(batch)
+
+    def _drop(self, session: ClientSession, reason: str) -> None:
+        self.sessions.discard(session)
+        self.selector.unregister(session.conn)
+        session.conn.close()
+        self.pending = [(s, obs) for s, obs in self.pending if s is not session]
+        mean_batch = self.requests / self.batches if self.batches else 0.0
+        print(
+            f"{reason}: {session.name} ({len(self.sessions)} active, mean batch {mean_batch:.1f})",
+            flush=True,
+        )
+
+
+class ShmMailboxServer:
+    """Server side of lv::ShmMailbox: one request and one response slot, each
+    published by bumping a u32 sequence counter and woken through a futex."""
+
+    def __init__(self, name: str, model_name: str) -> None:
+        if not name or "/" in name:
+            raise ValueError("--shm name must be non-empty and contain no '/'")
+        self.path = Path("/dev/shm") / name
+        size = SHM_HEADER_BYTES + 2 * SHM_SLOT_CAPACITY
+        fd = os.open(self.path, os.O_CREAT | os.O_RDWR | os.O_TRUNC, 0o600)
+        try:
+            os.ftruncate(fd, size)
+            self.buf = mmap.mmap(fd, size)
+        finally:
+            os.close(fd)
+        self.base = ctypes.addressof(ctypes.c_char.from_buffer(self.buf))
+        self.libc = ctypes.CDLL(None, use_errno=True)
+
+        model = model_name.encode("utf-8")[: SHM_MODEL_BYTES - 1]
+        struct.pack_into("<III", self.buf, 4, SHM_VERSION, SHM_SLOT_CAPACITY, os.getpid())
+        self.buf[16 : 16 + len(model) + 1] = model + b"\0"
+        # Magic last: the client checks it before trusting the rest of the header.
+        struct.pack_into("<I", self.buf, 0, SHM_MAGIC)
+        self.request_seen = self._load(SHM_REQUEST_SEQ)
+        self.response_seq = self._load(SHM_RESPONSE_SEQ)
+
+    def _load(self, offset: int) -> int:
+        return struct.unpack_from("<I", self.buf, offset)[0]
+
+    def _futex(self, offset: int, op: int, value: int, timeout: ctypes.Structure | None = None) -> None:
+        if SYS_FUTEX is None:
             return
+        timeout_ptr = ctypes.byref(timeout) if timeout is not None else None
+        self.libc.syscall(SYS_FUTEX, ctypes.c_void_p(self.base + offset), op, value, timeout_ptr, None, 0)
+
+    def wait_request(self) -> np.ndarray:
+        spin_until = time.perf_counter() + SHM_SPIN_SECONDS
+        timeout = (ctypes.c_long * 2)(0, 1_000_000)
+        while self._load(SHM_REQUEST_SEQ) == self.request_seen:
+            if time.perf_counter() >= spin_until:
+                if SYS_FUTEX is None:
+                    time.sleep(0.0001)
+                else:
+                    self._futex(SHM_REQUEST_SEQ, FUTEX_WAIT, self.request_seen, timeout)
+        self.request_seen = self._load(SHM_REQUEST_SEQ)
 
-        obs = message.get("obs")
-        if not isinstance(obs, list):
-            raise ValueError("request missing obs list")
+        offset = SHM_HEADER_BYTES
+        length, version, kind, count = FRAME_HEADER.unpack_from(self.buf, offset)
+        if version != PROTOCOL_VERSION or kind != FRAME_OBSERVATION or length != 4 + 4 * count:
+            raise ValueError(f"bad observation frame (version {version}, kind {kind}, length {length})")
+        start = offset + FRAME_HEADER.size
+        return np.frombuffer(self.buf, dtype="<f4", count=count, offset=start).astype(np.float32)
 
-        obs_arr = np.asarray(obs, dtype=np.float32)
-        action, _ = model.predict(obs_arr, deterministic=True)
-        response = {"action": clamp_and_validate_action(action)}
-        conn.sendall(json_dumps_line(response))
+    def post_response(self, action: list[float]) -> None:
+        frame = encode_action_frame(action)
+        offset = SHM_HEADER_BYTES + SHM_SLOT_CAPACITY
+        self.buf[offset : offset + len(frame)] = frame
+        # Plain stores: the slot is written before the counter in program order,
+        # which the client's acquire load observes correctly on x86-64 (TSO).
+        self.response_seq = (self.response_seq + 1) & 0xFFFFFFFF
+        struct.pack_into("<I", self.buf, SHM_RESPONSE_SEQ, self.response_seq)
+        self._futex(SHM_RESPONSE_SEQ, FUTEX_WAKE, 1)
+
+    def close(self) -> None:
+        struct.pack_into("<I", self.buf, 12, 0)
+        self.path.unlink(missing_ok=True)
+
+
+def serve_shm(name: str, model: PPO, model_name: str) -> None:
+    mailbox = ShmMailboxServer(name, model_name)
+    print(f"agent_server serving shm:{name} model={model_name}", flush=True)
+    try:
+        while True:
+            obs_arr = mailbox.wait_request()
+            action, _ = model.predict(obs_arr, deterministic=True)
+            mailbox.post_response(clamp_and_validate_action(action))
+    finally:
+        mailbox.close()
+
+
+def open_listener(args: argparse.Namespace) -> tuple[socket.socket, str]:
+    if args.unix:
+        path = Path(args.unix)
+        if path.is_socket():
+            path.unlink()
+        server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        server.bind(str(path))
+        endpoint = f"unix:{path}"
+    else:
+        server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind((args.host, args.port))
+        endpoint = f"{args.host}:{args.port}"
+    server.listen(128)
+    return server, endpoint
 
 
 def main() -> None:
     args = parse_args()
     if args.port <= 0 or args.port > 65535:
         raise ValueError("--port must be in range [1, 65535]")
+    if args.max_batch < 1:
+        raise ValueError("--max-batch must be >= 1")
+    if args.batch_window_ms < 0:
+        raise ValueError("--batch-window-ms must be >= 0")
+    if not 1 <= args.chunk <= MAX_ACTION_CHUNK:
+        raise ValueError(f"--chunk must be in range [1, {MAX_ACTION_CHUNK}]")
 
     model_path = Path(args.model)
     if not model_path.exists():
@@ -100,24 +431,22 @@ def main() -> None:
     model = PPO.load(str(model_path), device="cpu")
     model_name = resolve_model_name(model_path)
 
-    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as server:
-        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-        server.bind((args.host, args.port))
-        server.listen(1)
-
-        print(f"agent_server listening on {args.host}:{args.port} model={model_name}", flush=True)
+    if args.shm:
+        serve_shm(args.shm, model, model_name)
+        return
 
-        while True:
-            conn, addr = server.accept()
-            print(f"client connected: {addr[0]}:{addr[1]}", flush=True)
-            with conn:
-                try:
-                    handle_client(conn, model=model, model_name=model_name)
-                    print("client disconnected", flush=True)
-                except (json.JSONDecodeError, ValueError) as exc:
-                    print(f"client protocol error: {exc}", flush=True)
-                except (ConnectionError, OSError) as exc:
-                    print(f"client socket error: {exc}", flush=True)
+    server, endpoint = open_listener(args)
+    with server:
+        print(f"agent_server listening on {endpoint} model={model_name}", flush=True)
+        BatchingServer(
+            server,
+            model,
+            model_name,
+            allow_binary=not args.json_only,
+            max_batch=args.max_batch,
+            window=args.batch_window_ms / 1000.0,
+            chunk=args.chunk,
+        ).serve_forever()
 
 
 if __name__ == "__main__":
@@ -1,61 +1,74 @@
 from __future__ import annotations
 
 import argparse
-import statistics
+import json
+from pathlib import Path
 
-from stable_baselines3 import PPO
+import numpy as np
 
-from last_vector_env import LastVectorEnv
-from last_vector_env.env import EnvConfig
+import last_vector_core
 
 
 def parse_args() -> argparse.Namespace:
     p = argparse.ArgumentParser()
-    p.add_argument("--model", required=True)
+    source = p.add_mutually_exclusive_group(required=True)
+    source.add_argument("--model", help="SB3 PPO model .zip (batched model.predict)")
+    source.add_argument("--policy", help="Actor exported by export_policy.py (native inference, no Python per step)")
     p.add_argument("--episodes", type=int, default=5)
     p.add_argument("--seed", type=int, default=2024)
     p.add_argument("--episode-seconds", type=float, default=180.0)
+    p.add_argument("--threads", type=int, default=1, help="Threads stepping the simulators")
+    p.add_argument("--batch", type=int, default=64, help="Episodes run in lockstep and inferred together")
+    p.add_argument("--json", help="Also write the full report (per-seed results included) here")
     return p.parse_args()
 
 
+def load_policy(args: argparse.Namespace):
+    if args.policy:
+        return last_vector_core.MlpPolicy(args.policy)
+
+    from gymnasium import spaces
+    from stable_baselines3 import PPO
+
+    model = PPO.load(args.model, device="cpu")
+    if not isinstance(model.observation_space, spaces.Box):
+        raise ValueError("native evaluation needs a model trained on the flat vector observation")
+
+    def predict(obs: np.ndarray) -> np.ndarray:
+        action, _ = model.predict(obs, deterministic=True)
+        return np.asarray(action, dtype=np.float32)
+
+    return predict
+
+
 def main() -> None:
     args = parse_args()
-    env = LastVectorEnv(config=EnvConfig(episode_limit_s=args.episode_seconds), render_mode="none")
-    model = PPO.load(args.model)
-
-    ep_rewards = []
-    ep_lengths = []
-    ep_kills = []
-
-    for ep in range(args.episodes):
-        obs, _ = env.reset(seed=args.seed + ep)
-        terminated = truncated = False
-        total_reward = 0.0
-        steps = 0
-        final_info = {}
-
-        while not (terminated or truncated):
-            action, _ = model.predict(obs, deterministic=True)
-            obs, reward, terminated, truncated, info = env.step(action)
-            total_reward += reward
-            steps += 1
-            final_info = info
-
-        ep_rewards.append(total_reward)
-        ep_lengths.append(steps)
-        ep_kills.append(float(final_info.get("kills", 0.0)))
+    report_json = last_vector_core.evaluate(
+        load_policy(args),
+        args.episodes,
+        seed=args.seed,
+        threads=args.threads,
+        batch=args.batch,
+        episode_seconds=args.episode_seconds,
+    )
+    report = json.loads(report_json)
 
+    for ep in report["per_seed"]:
         print(
-            f"episode={ep} reward={total_reward:.3f} steps={steps} "
-            f"kills={final_info.get('kills', 0)} damage={final_info.get('damage_taken', 0.0):.2f}"
+            f"seed={ep['seed']} reward={ep['reward']:.3f} steps={ep['steps']} "
+            f"kills={ep['kills']} survival={ep['survival_s']:.1f}s accuracy={ep['accuracy']:.3f}"
         )
 
     print("\n=== aggregate ===")
-    print(f"episodes: {args.episodes}")
-    print(f"reward_mean: {statistics.fmean(ep_rewards):.4f}")
-    print(f"steps_mean: {statistics.fmean(ep_lengths):.2f}")
-    print(f"kills_mean: {statistics.fmean(ep_kills):.3f}")
-    env.close()
+    print(f"episodes: {report['episodes']}")
+    for name, stats in report["summary"].items():
+        print(
+            f"{name}: mean={stats['mean']:.4f} std={stats['std']:.4f} "
+            f"p5={stats['p5']:.4f} p50={stats['p50']:.4f} p95={stats['p95']:.4f}"
+        )
+
+    if args.json:
+        Path(args.json).write_text(report_json + "\n")
 
 
 if __name__ == "__main__":
@@ -0,0 +1,78 @@
+from __future__ import annotations
+
+import argparse
+import struct
+from pathlib import Path
+
+import numpy as np
+
+# Flat actor format read by lv::MlpPolicy (cpp/include/lastvector/mlp_policy.hpp).
+MAGIC = 0x504D564C  # "LVMP"
+VERSION = 1
+ACTIVATIONS = {"Tanh": 0, "ReLU": 1}
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Export the actor of an SB3 PPO MlpPolicy for last_vector --policy.")
+    parser.add_argument("--model", required=True, help="Path to SB3 PPO model .zip")
+    parser.add_argument("--out", required=True, help="Output .bin path")
+    return parser.parse_args()
+
+
+def write_policy(path: Path, layers: list[tuple[np.ndarray, np.ndarray]], activation: str) -> None:
+    """Writes (weight[out, in], bias[out]) pairs; every layer but the last is followed by `activation`."""
+    if activation not in ACTIVATIONS:
+        raise ValueError(f"unsupported activation {activation}; expected one of {sorted(ACTIVATIONS)}")
+    obs_dim = layers[0][0].shape[1]
+    action_dim = layers[-1][0].shape[0]
+    with path.open("wb") as f:
+        f.write(struct.pack("<6I", MAGIC, VERSION, obs_dim, action_dim, len(layers), ACTIVATIONS[activation]))
+        for weight, bias in layers:
+            out_features, in_features = weight.shape
+            if bias.shape != (out_features,):
+                raise ValueError(f"bias shape {bias.shape} does not match weight shape {weight.shape}")
+            f.write(struct.pack("<2I", in_features, out_features))
+            f.write(np.ascontiguousarray(weight, dtype="<f4").tobytes())
+            f.write(np.ascontiguousarray(bias, dtype="<f4").tobytes())
+
+
+def extract_actor(model_path: Path) -> tuple[list[tuple[np.ndarray, np.ndarray]], str]:
+    from stable_baselines3 import PPO
+    from stable_baselines3.common.torch_layers import FlattenExtractor
+    from torch import nn
+
+    policy = PPO.load(str(model_path), device="cpu").policy
+    if not isinstance(policy.features_extractor, FlattenExtractor):
+        raise ValueError("only MlpPolicy with a flat vector observation can be exported")
+
+    layers = []
+    activations = set()
+    for module in policy.mlp_extractor.policy_net:
+        if isinstance(module, nn.Linear):
+            layers.append((module.weight.detach().numpy(), module.bias.detach().numpy()))
+        else:
+            activations.add(type(module).__name__)
+    if not isinstance(policy.action_net, nn.Linear):
+        raise ValueError("action_net is not a Linear layer; only Box action spaces are supported")
+    layers.append((policy.action_net.weight.detach().numpy(), policy.action_net.bias.detach().numpy()))
+
+    if len(activations) > 1:
+        raise ValueError(f"mixed activations {sorted(activations)} are not supported")
+    return layers, activations.pop() if activations else "Tanh"
+
+
+def main() -> None:
+    args = parse_args()
+    model_path = Path(args.model)
+    if not model_path.exists():
+        raise FileNotFoundError(f"Model does not exist: {model_path}")
+
+    layers, activation = extract_actor(model_path)
+    out_path = Path(args.out)
+    write_policy(out_path, layers, activation)
+    shapes = " -> ".join(str(w.shape[1]) for w, _ in layers) + f" -> {layers[-1][0].shape[0]}"
+    print(f"wrote {out_path}: {shapes} ({activation})")
+
+
+if __name__ == "__main__":
+    main()
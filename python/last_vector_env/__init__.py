@@ -1,3 +1,4 @@
+from .dataset import TrajectoryDataset, open_dataset
 from .env import EnvConfig, LastVectorEnv
 
-__all__ = ["LastVectorEnv", "EnvConfig"]
+__all__ = ["LastVectorEnv", "EnvConfig", "TrajectoryDataset", "open_dataset"]
@@ -0,0 +1,65 @@
+from __future__ import annotations
+
+import json
+import os
+from dataclasses import dataclass
+from typing import Any, Dict, List
+
+import numpy as np
+
+
+@dataclass
+class TrajectoryDataset:
+    """Shards written by last_vector_core.TrajectoryWriter (or --dataset DIR).
+
+    Every shard is a read-only np.memmap of structured records with fields
+    obs, action, metrics, reward, seed, env, step, terminated and truncated;
+    ``shard["obs"]`` is a view into the file, nothing is copied or parsed.
+    Rows of one episode share (env, seed) and appear in step order; the next
+    observation of a row is the obs of the following row of its episode.
+    """
+
+    path: str
+    index: Dict[str, Any]
+    shards: List[np.memmap]
+
+    @property
+    def metrics(self) -> List[str]:
+        return list(self.index["metrics"])
+
+    @property
+    def complete(self) -> bool:
+        """False while a writer is still appending (rows seen so far are whole)."""
+
+        return bool(self.index["complete"])
+
+    def __len__(self) -> int:
+        return sum(len(shard) for shard in self.shards)
+
+    def column(self, name: str) -> List[np.ndarray]:
+        """Per-shard views of one field, e.g. column("obs")."""
+
+        return [shard[name] for shard in self.shards]
+
+    def metric(self, name: str) -> List[np.ndarray]:
+        """Per-shard views of one info metric, by name."""
+
+        i = self.metrics.index(name)
+        return [shard["metrics"][:, i] for shard in self.shards]
+
+
+def open_dataset(path: str) -> TrajectoryDataset:
+    """Maps every shard listed in path/index.json."""
+
+    with open(os.path.join(path, "index.json"), encoding="utf-8") as f:
+        index = json.load(f)
+    if index.get("format") != "last_vector_trajectories" or index.get("version") != 1:
+        raise ValueError(f"{path} is not a Last-Vector trajectory dataset")
+    shards = []
+    for entry in index["shards"]:
+        if entry["rows"] == 0:
+            continue  # created but nothing flushed yet
+        shard = np.load(os.path.join(path, entry["file"]), mmap_mode="r")
+        # The .npy header may already count rows flushed after index.json.
+        shards.append(shard[: entry["rows"]])
+    return TrajectoryDataset(path=path, index=index, shards=shards)
@@ -1,6 +1,6 @@
 from __future__ import annotations
 
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 from typing import Any, Dict, Optional, Tuple
 
 import gymnasium as gym
@@ -16,20 +16,41 @@ class EnvConfig:
 
     episode_limit_s: float = 180.0
     simulator_seed: int = 0
+    # Field overrides for last_vector_core.SimConfig (arena size, spawn curve,
+    # observation layout, ...). episode_limit_s always wins over
+    # "episode_limit_seconds".
+    sim_overrides: Dict[str, Any] = field(default_factory=dict)
+    # "vector": float32 feature vector; "grid": uint8 (channels, size, size)
+    # egocentric occupancy grid for CnnPolicy; "dict": both, under "vector"
+    # and "grid", for MultiInputPolicy.
+    observation_mode: str = "vector"
 
 
-class LastVectorEnv(gym.Env[np.ndarray, np.ndarray]):
+OBSERVATION_MODES = ("vector", "grid", "dict")
+
+
+class LastVectorEnv(gym.Env[Any, np.ndarray]):
     """Gymnasium wrapper around the native Last-Vector simulator."""
 
-    metadata = {"render_modes": ["none"], "render_fps": 60}
+    metadata = {"render_modes": ["none", "rgb_array"], "render_fps": 60}
 
     def __init__(self, config: Optional[EnvConfig] = None, render_mode: str = "none") -> None:
         super().__init__()
         self.config = config or EnvConfig()
         self.render_mode = render_mode
+        if self.config.observation_mode not in OBSERVATION_MODES:
+            raise ValueError(
+                f"observation_mode must be one of {OBSERVATION_MODES}, got {self.config.observation_mode!r}"
+            )
+        sim_config = last_vector_core.SimConfig()
+        for key, value in self.config.sim_overrides.items():
+            if not hasattr(sim_config, key):
+                raise ValueError(f"Unknown SimConfig field: {key}")
+            setattr(sim_config, key, value)
         self.core = last_vector_core.Simulator(
             seed=int(self.config.simulator_seed),
             episode_seconds=float(self.config.episode_limit_s),
+            config=sim_config,
         )
 
         self.action_space = spaces.Box(
@@ -39,28 +60,44 @@ class LastVectorEnv(gym.Env[np.ndarray, np.ndarray]):
         )
 
         obs_dim = int(self.core.obs_dim())
-        self.observation_space = spaces.Box(
+        vector_space = spaces.Box(
             low=np.full((obs_dim,), -np.inf, dtype=np.float32),
             high=np.full((obs_dim,), np.inf, dtype=np.float32),
             shape=(obs_dim,),
             dtype=np.float32,
         )
+        grid_space = spaces.Box(low=0, high=255, shape=tuple(self.core.occupancy_shape()), dtype=np.uint8)
+        if self.config.observation_mode == "vector":
+            self.observation_space = vector_space
+        elif self.config.observation_mode == "grid":
+            self.observation_space = grid_space
+        else:
+            self.observation_space = spaces.Dict({"vector": vector_space, "grid": grid_space})
+
+    def _make_obs(self, vector_obs: np.ndarray) -> Any:
+        mode = self.config.observation_mode
+        if mode == "vector":
+            return np.ascontiguousarray(vector_obs)
+        grid = self.core.occupancy()
+        if mode == "grid":
+            return grid
+        return {"vector": np.ascontiguousarray(vector_obs), "grid": grid}
 
     def reset(
         self,
         *,
         seed: Optional[int] = None,
         options: Optional[Dict[str, Any]] = None,
-    ) -> Tuple[np.ndarray, Dict[str, Any]]:
+    ) -> Tuple[Any, Dict[str, Any]]:
         """Reset environment state and return (observation, info)."""
 
         del options
         super().reset(seed=seed)
         resolved_seed = seed if seed is not None else int(self.np_random.integers(0, 2**31 - 1))
         obs = np.asarray(self.core.reset(int(resolved_seed)), dtype=np.float32)
-        return np.ascontiguousarray(obs), {"seed": int(resolved_seed)}
+        return self._make_obs(obs), {"seed": int(resolved_seed)}
 
-    def step(self, action: np.ndarray) -> Tuple[np.ndarray, float, bool, bool, Dict[str, Any]]:
+    def step(self, action: np.ndarray) -> Tuple[Any, float, bool, bool, Dict[str, Any]]:
         """Advance one step and return Gymnasium step tuple."""
 
         action_arr = np.asarray(action, dtype=np.float32).reshape(-1)
@@ -68,14 +105,18 @@ class LastVectorEnv(gym.Env[np.ndarray, np.ndarray]):
         obs, reward, terminated, truncated, info = self.core.step(action_arr)
         obs_np = np.asarray(obs, dtype=np.float32)
         return (
-            np.ascontiguousarray(obs_np),
+            self._make_obs(obs_np),
             float(reward),
             bool(terminated),
             bool(truncated),
             dict(info),
         )
 
-    def render(self) -> None:
+    def render(self) -> Optional[np.ndarray]:
+        """Return a (360, 640, 3) uint8 frame in "rgb_array" mode, else None."""
+
+        if self.render_mode == "rgb_array":
+            return self.core.render_rgb()
         return None
 
     def close(self) -> None:
@@ -0,0 +1,130 @@
+from __future__ import annotations
+
+import time
+from typing import Any, Dict, List, Optional
+
+import numpy as np
+import torch as th
+from stable_baselines3 import PPO
+from stable_baselines3.common.buffers import RolloutBuffer
+from stable_baselines3.common.callbacks import BaseCallback
+from stable_baselines3.common.utils import obs_as_tensor
+from stable_baselines3.common.vec_env import VecEnv
+
+import last_vector_core
+
+
+class NativeRolloutPPO(PPO):
+    """PPO that gathers each rollout with one RolloutCollector.collect() call.
+
+    The collector steps n_envs native simulators and calls the policy once per
+    step on the whole (n_envs, obs_dim) batch; the rollout buffer is then filled
+    from its (n_steps, n_envs, ...) arrays in a few copies. `env` only provides
+    the spaces and n_envs and is never stepped. Callbacks get one on_step() per
+    rollout, with `infos` holding the episodes that ended in Monitor's format,
+    so step-based frequencies count rollouts rather than steps. Saved models
+    load as plain PPO.
+    """
+
+    def __init__(self, *args: Any, collector: Optional[last_vector_core.RolloutCollector] = None, **kwargs: Any):
+        super().__init__(*args, **kwargs)
+        if collector is not None and (collector.envs != self.n_envs or collector.steps != self.n_steps):
+            raise ValueError(
+                f"collector is {collector.steps} steps x {collector.envs} envs, "
+                f"PPO expects {self.n_steps} x {self.n_envs}"
+            )
+        self.collector = collector
+        self._collect_start = time.time()
+
+    def _excluded_save_params(self) -> List[str]:
+        return super()._excluded_save_params() + ["collector"]
+
+    def collect_rollouts(
+        self,
+        env: VecEnv,
+        callback: BaseCallback,
+        rollout_buffer: RolloutBuffer,
+        n_rollout_steps: int,
+    ) -> bool:
+        if self.collector is None:
+            return super().collect_rollouts(env, callback, rollout_buffer, n_rollout_steps)
+
+        collector = self.collector
+        self.policy.set_training_mode(False)
+        rollout_buffer.reset()
+        if self.use_sde:
+            self.policy.reset_noise(self.n_envs)
+        callback.on_rollout_start()
+
+        values = np.zeros((n_rollout_steps, self.n_envs), dtype=np.float32)
+        log_probs = np.zeros_like(values)
+
+        def act(step: int, obs: np.ndarray) -> np.ndarray:
+            if self.use_sde and self.sde_sample_freq > 0 and step > 0 and step % self.sde_sample_freq == 0:
+                self.policy.reset_noise(self.n_envs)
+            with th.no_grad():
+                actions, step_values, step_log_probs = self.policy(obs_as_tensor(np.array(obs), self.device))
+            values[step] = step_values.cpu().numpy().reshape(-1)
+            log_probs[step] = step_log_probs.cpu().numpy()
+            # Stored unclipped for the update; the collector decodes them as LastVectorEnv does.
+            return actions.cpu().numpy()
+
+        collector.collect(act)
+        self.num_timesteps += n_rollout_steps * self.n_envs
+
+        episodes = collector.episodes()
+        rewards = np.array(collector.rewards)
+        truncated = episodes["truncated"]
+        if truncated.any():
+            # Time limits are not terminal: bootstrap from the value of the
+            # observation the episode was cut off at.
+            with th.no_grad():
+                final_obs = obs_as_tensor(episodes["final_obs"][truncated], self.device)
+                final_values = self.policy.predict_values(final_obs).cpu().numpy().reshape(-1)
+            np.add.at(rewards, (episodes["step"][truncated], episodes["env"][truncated]), self.gamma * final_values)
+
+        rollout_buffer.observations[:] = collector.observations
+        rollout_buffer.actions[:] = collector.actions
+        rollout_buffer.rewards[:] = rewards
+        rollout_buffer.episode_starts[:] = collector.episode_starts
+        rollout_buffer.values[:] = values
+        rollout_buffer.log_probs[:] = log_probs
+        rollout_buffer.pos = n_rollout_steps
+        rollout_buffer.full = True
+
+        with th.no_grad():
+            last_values = self.policy.predict_values(obs_as_tensor(np.array(collector.last_observations), self.device))
+        dones = collector.terminated[-1] | collector.truncated[-1]
+        rollout_buffer.compute_returns_and_advantage(last_values=last_values, dones=dones)
+
+        infos = self._episode_infos(episodes)
+        self._update_info_buffer(infos)
+        callback.update_locals(locals())
+        if not callback.on_step():
+            return False
+        callback.on_rollout_end()
+        return True
+
+    def _episode_infos(self, episodes: Dict[str, np.ndarray]) -> List[Dict[str, Any]]:
+        elapsed = round(time.time() - self._collect_start, 6)
+        infos = []
+        for i in range(len(episodes["env"])):
+            kills = int(episodes["kills"][i])
+            infos.append(
+                {
+                    "episode": {
+                        "r": round(float(episodes["reward"][i]), 6),
+                        "l": int(episodes["length"][i]),
+                        "t": elapsed,
+                        "kills": kills,
+                    },
+                    "kills": kills,
+                    "shots_fired": int(episodes["shots_fired"][i]),
+                    "hits": int(episodes["hits"][i]),
+                    "accuracy": float(episodes["accuracy"][i]),
+                    "damage_dealt": float(episodes["damage_dealt"][i]),
+                    "damage_taken": float(episodes["damage_taken"][i]),
+                    "TimeLimit.truncated": bool(episodes["truncated"][i]),
+                }
+            )
+        return infos
@@ -12,14 +12,34 @@ ext_modules = [
         "last_vector_core",
         [
             str(ROOT / "cpp/src/python_bindings.cpp"),
+            str(ROOT / "cpp/src/action.cpp"),
             str(ROOT / "cpp/src/sim.cpp"),
+            str(ROOT / "cpp/src/sim_state.cpp"),
             str(ROOT / "cpp/src/observation.cpp"),
             str(ROOT / "cpp/src/collision.cpp"),
+            str(ROOT / "cpp/src/separation.cpp"),
+            str(ROOT / "cpp/src/thread_pool.cpp"),
             str(ROOT / "cpp/src/upgrades.cpp"),
+            str(ROOT / "cpp/src/obstacle_field.cpp"),
+            str(ROOT / "cpp/src/occupancy_grid.cpp"),
+            str(ROOT / "cpp/src/software_renderer.cpp"),
+            str(ROOT / "cpp/src/render_snapshot.cpp"),
+            str(ROOT / "cpp/src/sim_thread.cpp"),
+            str(ROOT / "cpp/src/frame_writer.cpp"),
+            str(ROOT / "cpp/src/agent_protocol.cpp"),
+            str(ROOT / "cpp/src/agent_client.cpp"),
+            str(ROOT / "cpp/src/async_agent.cpp"),
+            str(ROOT / "cpp/src/shm_mailbox.cpp"),
+            str(ROOT / "cpp/src/mlp_policy.cpp"),
+            str(ROOT / "cpp/src/evaluation.cpp"),
+            str(ROOT / "cpp/src/replay.cpp"),
+            str(ROOT / "cpp/src/rollout.cpp"),
+            str(ROOT / "cpp/src/trajectory_writer.cpp"),
+            str(ROOT / "cpp/src/zombie_ray_grid.cpp"),
         ],
         include_dirs=[str(ROOT / "cpp/include"), pybind11.get_include()],
         language="c++",
-        extra_compile_args=["-std=c++20", "-Wall", "-Wextra", "-Wpedantic"],
+        extra_compile_args=["-std=c++20", "-Wall", "-Wextra", "-Wpedantic", "-ffp-contract=off"],
     )
 ]
 
@@ -16,6 +16,7 @@ from stable_baselines3.common.callbacks import BaseCallback, CallbackList, Check
 from stable_baselines3.common.monitor import Monitor
 from stable_baselines3.common.vec_env import DummyVecEnv
 
+import last_vector_core
 from last_vector_env import LastVectorEnv
 from last_vector_env.env import EnvConfig
 
@@ -189,6 +190,15 @@ def parse_args() -> argparse.Namespace:
     parser.add_argument("--lr", type=float, default=3e-4, help="Learning rate.")
     parser.add_argument("--n-steps", type=int, default=2048, help="PPO rollout steps.")
     parser.add_argument("--batch-size", type=int, default=256, help="PPO minibatch size.")
+    parser.add_argument("--n-envs", type=int, default=1, help="Parallel training environments.")
+    parser.add_argument(
+        "--native-rollouts",
+        action="store_true",
+        help="Collect rollouts with the native RolloutCollector instead of SB3's per-step loop.",
+    )
+    parser.add_argument(
+        "--rollout-threads", type=int, default=1, help="Simulator threads for --native-rollouts."
+    )
     return parser.parse_args()
 
 
@@ -214,6 +224,10 @@ def validate_args(args: argparse.Namespace) -> None:
         raise ValueError("--n-steps must be > 0")
     if args.batch_size <= 0:
         raise ValueError("--batch-size must be > 0")
+    if args.n_envs <= 0:
+        raise ValueError("--n-envs must be > 0")
+    if args.rollout_threads <= 0:
+        raise ValueError("--rollout-threads must be > 0")
 
 
 def main() -> None:
@@ -243,6 +257,8 @@ def main() -> None:
         "lr": float(args.lr),
         "n_steps": int(args.n_steps),
         "batch_size": int(args.batch_size),
+        "n_envs": int(args.n_envs),
+        "native_rollouts": bool(args.native_rollouts),
         "episode_seconds": float(args.episode_seconds),
         "device": args.device,
         "run_id": run_id,
@@ -273,10 +289,12 @@ def main() -> None:
         env.reset(seed=env_seed)
         return Monitor(env)
 
-    train_env = DummyVecEnv([lambda: make_env(args.seed)])
-    eval_env = DummyVecEnv([lambda: make_env(args.seed + 1)])
+    # With --native-rollouts these envs only provide the spaces; the collector
+    # steps its own simulators.
+    train_env = DummyVecEnv([lambda i=i: make_env(args.seed + i) for i in range(args.n_envs)])
+    eval_env = DummyVecEnv([lambda: make_env(args.seed + args.n_envs)])
 
-    model = PPO(
+    ppo_kwargs: Dict[str, Any] = dict(
         policy="MlpPolicy",
         env=train_env,
         seed=args.seed,
@@ -287,9 +305,29 @@ def main() -> None:
         verbose=1,
         device=args.device,
     )
+    # Callback frequencies count on_step() calls: one per env step in SB3's
+    # loop, one per rollout with the native collector.
+    calls_per_step = 1.0
+    if args.native_rollouts:
+        from last_vector_env.native_ppo import NativeRolloutPPO
+
+        collector = last_vector_core.RolloutCollector(
+            envs=args.n_envs,
+            steps=args.n_steps,
+            seed=args.seed,
+            threads=args.rollout_threads,
+            episode_seconds=args.episode_seconds,
+        )
+        model = NativeRolloutPPO(collector=collector, **ppo_kwargs)
+        calls_per_step = 1.0 / args.n_steps
+    else:
+        model = PPO(**ppo_kwargs)
+
+    def callback_freq(env_steps: int) -> int:
+        return max(1, int(env_steps * calls_per_step))
 
     checkpoint_cb = CheckpointCallback(
-        save_freq=50_000,
+        save_freq=callback_freq(50_000),
         save_path=str(ckpt_dir),
         name_prefix="ppo_last_vector",
         save_replay_buffer=False,
@@ -299,7 +337,7 @@ def main() -> None:
         eval_env=eval_env,
         best_model_save_path=str(run_dir),
         log_path=str(run_dir),
-        eval_freq=25_000,
+        eval_freq=callback_freq(25_000),
         deterministic=True,
         render=False,
     )